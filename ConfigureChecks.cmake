@@ -13,6 +13,10 @@ CHECK_INCLUDE_FILE(locale.h HAVE_LOCALE_H)
 CHECK_INCLUDE_FILE(libgen.h HAVE_LIBGEN_H)
 CHECK_INCLUDE_FILE(unistd.h HAVE_UNISTD_H)
 CHECK_INCLUDE_FILE(direct.h HAVE_DIRECT_H)
+CHECK_INCLUDE_FILE(sys/stat.h HAVE_SYS_STAT_H)
+CHECK_INCLUDE_FILE(dirent.h HAVE_DIRENT_H)
+CHECK_INCLUDE_FILE(sys/socket.h HAVE_SYS_SOCKET_H)
+CHECK_INCLUDE_FILE(sys/un.h HAVE_SYS_UN_H)
 CHECK_INCLUDE_FILE(stdint.h HAVE_STDINT_H)
 
 CHECK_SYMBOL_EXISTS(abort "stdlib.h" HAVE_ABORT)
@@ -20,6 +24,10 @@ CHECK_SYMBOL_EXISTS(abort "stdlib.h" HAVE_ABORT)
 CHECK_FUNCTION_EXISTS(getcwd HAVE_GETCWD)
 CHECK_FUNCTION_EXISTS(_stricmp HAVE__STRICMP)
 CHECK_FUNCTION_EXISTS(toascii HAVE_TOASCII)
+CHECK_FUNCTION_EXISTS(fork HAVE_FORK)
+CHECK_FUNCTION_EXISTS(getpeereid HAVE_GETPEEREID)
+CHECK_FUNCTION_EXISTS(fopencookie HAVE_FOPENCOOKIE)
+CHECK_FUNCTION_EXISTS(funopen HAVE_FUNOPEN)
 
 CHECK_LIBRARY_EXISTS(dl dlopen "" HAVE_LIBDL)
 
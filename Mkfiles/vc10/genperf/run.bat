@@ -31,6 +31,7 @@ call :update %1 x86insn_nasm.gperf x86insn_nasm.c
 call :update %1 x86insn_gas.gperf x86insn_gas.c
 call :update %1 modules\arch\x86\x86cpu.gperf x86cpu.c
 call :update %1 modules\arch\x86\x86regtmod.gperf x86regtmod.c
+call :update %1 modules\parsers\nasm\nasm-keywords.gperf nasm-keywords.c
 goto :eof
 
 :update
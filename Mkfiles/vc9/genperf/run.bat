@@ -20,3 +20,4 @@ call %_python_% modules\arch\x86\gen_x86_insn.py
 %1 x86insn_gas.gperf x86insn_gas.c
 %1 modules\arch\x86\x86cpu.gperf x86cpu.c
 %1 modules\arch\x86\x86regtmod.gperf x86regtmod.c
+%1 modules\parsers\nasm\nasm-keywords.gperf nasm-keywords.c
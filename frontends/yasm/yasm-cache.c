@@ -0,0 +1,395 @@
+/*
+ * Local directory cache of assembly results
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <util.h>
+
+#include <errno.h>
+#include <time.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+#include <io.h>
+#include <process.h>
+#include <sys/types.h>
+#include <sys/utime.h>
+#elif defined(HAVE_SYS_STAT_H)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <utime.h>
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#endif
+
+#include <libyasm/file.h>
+
+#include "yasm-cache.h"
+
+#define CACHE_OBJ_EXT   ".obj"
+#define CACHE_LIST_EXT  ".lst"
+#define CACHE_TMP_EXT   ".tmp"
+#define CACHE_EXT_LEN   4
+
+/* Temporary files older than this (in seconds) were left behind by a
+ * process that died while storing, and are removed during eviction.
+ */
+#define CACHE_TMP_MAX_AGE   3600
+
+typedef struct cache_entry {
+    /*@only@*/ char *name;
+    unsigned long size;
+    double mtime;
+} cache_entry;
+
+void
+cache_key_string(char key[CACHE_KEY_LEN+1], const unsigned char digest[16])
+{
+    static const char hexdig[] = "0123456789abcdef";
+    int i;
+
+    for (i=0; i<16; i++) {
+        key[2*i] = hexdig[digest[i] >> 4];
+        key[2*i+1] = hexdig[digest[i] & 0xf];
+    }
+    key[CACHE_KEY_LEN] = '\0';
+}
+
+static /*@only@*/ char *
+cache_path(const char *dir, const char *name, const char *ext)
+{
+    size_t dirlen = strlen(dir), namelen = strlen(name);
+    char *path = yasm_xmalloc(dirlen + namelen + strlen(ext) + 2);
+
+    memcpy(path, dir, dirlen);
+    path[dirlen] = '/';
+    memcpy(path+dirlen+1, name, namelen);
+    strcpy(path+dirlen+1+namelen, ext);
+    return path;
+}
+
+/* Copy src to dst.  Returns 0 on success, nonzero on failure. */
+static int
+copy_file(const char *src, const char *dst)
+{
+    unsigned char buf[8192];
+    FILE *in, *out;
+    size_t got;
+    int err = 0;
+
+    in = fopen(src, "rb");
+    if (!in)
+        return 1;
+    out = fopen(dst, "wb");
+    if (!out) {
+        fclose(in);
+        return 1;
+    }
+    while ((got = fread(buf, 1, sizeof(buf), in)) > 0) {
+        if (fwrite(buf, 1, got, out) != got) {
+            err = 1;
+            break;
+        }
+    }
+    if (ferror(in))
+        err = 1;
+    fclose(in);
+    if (fclose(out) != 0)
+        err = 1;
+    return err;
+}
+
+/* Mark a cache entry as recently used. */
+static void
+touch_file(const char *path)
+{
+#if defined(_WIN32)
+    _utime(path, NULL);
+#elif defined(HAVE_SYS_STAT_H)
+    utime(path, NULL);
+#endif
+}
+
+static int
+file_exists(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    fclose(f);
+    return 1;
+}
+
+int
+cache_fetch(const char *dir, const char *key, const char *obj_filename,
+            const char *list_filename)
+{
+    char *obj_path, *list_path = NULL;
+    int hit = 0;
+
+    obj_path = cache_path(dir, key, CACHE_OBJ_EXT);
+    if (list_filename)
+        list_path = cache_path(dir, key, CACHE_LIST_EXT);
+
+    if (file_exists(obj_path) && (!list_path || file_exists(list_path))) {
+        hit = copy_file(obj_path, obj_filename) == 0;
+        if (hit && list_path)
+            hit = copy_file(list_path, list_filename) == 0;
+        if (hit) {
+            touch_file(obj_path);
+            if (list_path)
+                touch_file(list_path);
+        } else {
+            /* Don't leave a partial result behind */
+            remove(obj_filename);
+            if (list_filename)
+                remove(list_filename);
+        }
+    }
+
+    yasm_xfree(obj_path);
+    if (list_path)
+        yasm_xfree(list_path);
+    return hit;
+}
+
+/* Copy file into the cache as dir/key+ext.  The copy is made under a
+ * temporary name unique to this process and file and renamed into place,
+ * so that neither a concurrent fetch nor a concurrent store of the same
+ * entry ever sees a partially written file.
+ */
+static int
+store_file(const char *dir, const char *key, const char *ext,
+           const char *filename)
+{
+    static unsigned long tmp_count = 0;
+    char tmp_ext[CACHE_EXT_LEN+64];
+    char *tmp_path, *path;
+    unsigned long pid;
+    int err;
+
+#if defined(_WIN32)
+    pid = (unsigned long)_getpid();
+#elif defined(HAVE_UNISTD_H)
+    pid = (unsigned long)getpid();
+#else
+    pid = 0;
+#endif
+    sprintf(tmp_ext, "%s.%lu.%lu%s", ext, pid, tmp_count++, CACHE_TMP_EXT);
+    tmp_path = cache_path(dir, key, tmp_ext);
+    path = cache_path(dir, key, ext);
+
+    err = copy_file(filename, tmp_path);
+    if (!err) {
+#ifdef _WIN32
+        remove(path);
+#endif
+        err = rename(tmp_path, path);
+    }
+    if (err)
+        remove(tmp_path);
+
+    yasm_xfree(tmp_path);
+    yasm_xfree(path);
+    return err;
+}
+
+/* Is name one of our cache entries (a key plus an object or list
+ * extension)?  Anything else in the directory is left alone.
+ */
+static int
+is_cache_entry(const char *name)
+{
+    size_t i;
+
+    if (strlen(name) != CACHE_KEY_LEN+CACHE_EXT_LEN)
+        return 0;
+    for (i=0; i<CACHE_KEY_LEN; i++) {
+        if (!((name[i] >= '0' && name[i] <= '9') ||
+              (name[i] >= 'a' && name[i] <= 'f')))
+            return 0;
+    }
+    return strcmp(&name[CACHE_KEY_LEN], CACHE_OBJ_EXT) == 0 ||
+           strcmp(&name[CACHE_KEY_LEN], CACHE_LIST_EXT) == 0;
+}
+
+/* Is name a temporary file of ours (a key followed by anything ending in
+ * the temporary extension)?
+ */
+static int
+is_cache_tmp(const char *name)
+{
+    size_t len = strlen(name), i;
+
+    if (len < CACHE_KEY_LEN+strlen(CACHE_TMP_EXT))
+        return 0;
+    for (i=0; i<CACHE_KEY_LEN; i++) {
+        if (!((name[i] >= '0' && name[i] <= '9') ||
+              (name[i] >= 'a' && name[i] <= 'f')))
+            return 0;
+    }
+    return strcmp(&name[len-strlen(CACHE_TMP_EXT)], CACHE_TMP_EXT) == 0;
+}
+
+/* Remove dir/name if it's one of our temporary files and is old enough
+ * that no store can still be writing it.
+ */
+static void
+remove_stale_tmp(const char *dir, const char *name, double mtime)
+{
+    char *path;
+
+    if (!is_cache_tmp(name) || (double)time(NULL) - mtime < CACHE_TMP_MAX_AGE)
+        return;
+    path = cache_path(dir, name, "");
+    remove(path);
+    yasm_xfree(path);
+}
+
+static int
+cache_entry_compare(const void *a, const void *b)
+{
+    const cache_entry *ea = a, *eb = b;
+    if (ea->mtime < eb->mtime)
+        return -1;
+    if (ea->mtime > eb->mtime)
+        return 1;
+    return strcmp(ea->name, eb->name);
+}
+
+static void
+add_entry(cache_entry **entries, size_t *num, size_t *alloc,
+          const char *name, unsigned long size, double mtime)
+{
+    if (*num >= *alloc) {
+        *alloc = *alloc ? *alloc * 2 : 64;
+        *entries = yasm_xrealloc(*entries, *alloc * sizeof(cache_entry));
+    }
+    (*entries)[*num].name = yasm__xstrdup(name);
+    (*entries)[*num].size = size;
+    (*entries)[*num].mtime = mtime;
+    (*num)++;
+}
+
+/* Evict least recently used entries until the total size of the cache is
+ * no more than max_size bytes.  Also removes stale temporary files.
+ */
+static void
+cache_evict(const char *dir, unsigned long max_size)
+{
+    cache_entry *entries = NULL;
+    size_t num = 0, alloc = 0, i;
+    double total = 0.0;
+#if defined(_WIN32)
+    struct _finddata_t fi;
+    intptr_t h;
+    char *pattern = cache_path(dir, "*", "");
+
+    h = _findfirst(pattern, &fi);
+    yasm_xfree(pattern);
+    if (h == -1)
+        return;
+    do {
+        if (fi.attrib & _A_SUBDIR)
+            continue;
+        if (is_cache_entry(fi.name)) {
+            add_entry(&entries, &num, &alloc, fi.name,
+                      (unsigned long)fi.size, (double)fi.time_write);
+            total += (double)fi.size;
+        } else
+            remove_stale_tmp(dir, fi.name, (double)fi.time_write);
+    } while (_findnext(h, &fi) == 0);
+    _findclose(h);
+#elif defined(HAVE_SYS_STAT_H) && defined(HAVE_DIRENT_H)
+    DIR *d;
+    struct dirent *de;
+
+    d = opendir(dir);
+    if (!d)
+        return;
+    while ((de = readdir(d)) != NULL) {
+        struct stat st;
+        char *path;
+
+        if (!is_cache_entry(de->d_name) && !is_cache_tmp(de->d_name))
+            continue;
+        path = cache_path(dir, de->d_name, "");
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+            if (!is_cache_entry(de->d_name))
+                remove_stale_tmp(dir, de->d_name, (double)st.st_mtime);
+            else {
+                add_entry(&entries, &num, &alloc, de->d_name,
+                          (unsigned long)st.st_size, (double)st.st_mtime);
+                total += (double)st.st_size;
+            }
+        }
+        yasm_xfree(path);
+    }
+    closedir(d);
+#else
+    return;
+#endif
+
+    if (total > (double)max_size) {
+        qsort(entries, num, sizeof(cache_entry), cache_entry_compare);
+        for (i=0; i<num && total > (double)max_size; i++) {
+            char *path = cache_path(dir, entries[i].name, "");
+            if (remove(path) == 0)
+                total -= (double)entries[i].size;
+            yasm_xfree(path);
+        }
+    }
+
+    for (i=0; i<num; i++)
+        yasm_xfree(entries[i].name);
+    if (entries)
+        yasm_xfree(entries);
+}
+
+void
+cache_store(const char *dir, const char *key, const char *obj_filename,
+            const char *list_filename, unsigned long max_size)
+{
+    char *path;
+
+    /* Make sure the cache directory exists */
+    path = cache_path(dir, key, CACHE_OBJ_EXT);
+    yasm__createpath(path);
+    yasm_xfree(path);
+
+    /* Store the list file first; fetches look for the object, so they
+     * never find one whose list file is still missing.
+     */
+    if (list_filename &&
+        store_file(dir, key, CACHE_LIST_EXT, list_filename) != 0)
+        return;
+    if (store_file(dir, key, CACHE_OBJ_EXT, obj_filename) != 0)
+        return;
+
+    cache_evict(dir, max_size);
+}
@@ -0,0 +1,54 @@
+/*
+ * Local directory cache of assembly results
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef YASM_CACHE_H
+#define YASM_CACHE_H
+
+/* Length of a cache key as returned by cache_key_string() (without the
+ * terminating NUL).
+ */
+#define CACHE_KEY_LEN   32
+
+/* Convert a 16-byte digest into a NUL-terminated hex cache key. */
+void cache_key_string(char key[CACHE_KEY_LEN+1],
+                      const unsigned char digest[16]);
+
+/* Copy the cached object (and list file, if list_filename is non-NULL) for
+ * key out of dir.  Returns 0 on a miss or on failure; nothing is written
+ * unless every needed entry is present.
+ */
+int cache_fetch(const char *dir, const char *key, const char *obj_filename,
+                /*@null@*/ const char *list_filename);
+
+/* Store the object (and list file, if list_filename is non-NULL) under key
+ * in dir, creating dir if needed, then evict the least recently used
+ * entries until the cache is no larger than max_size bytes.
+ */
+void cache_store(const char *dir, const char *key, const char *obj_filename,
+                 /*@null@*/ const char *list_filename,
+                 unsigned long max_size);
+
+#endif
@@ -0,0 +1,635 @@
+/*
+ * Assembly server and client
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/* sigaction() and friends are hidden by -ansi otherwise; glibc also needs
+ * _GNU_SOURCE for struct ucred (SO_PEERCRED).
+ */
+#define _POSIX_C_SOURCE 200112L
+#define _GNU_SOURCE
+
+#include <util.h>
+
+#if defined(HAVE_UNISTD_H) && defined(HAVE_SYS_SOCKET_H) && \
+    defined(HAVE_SYS_UN_H) && defined(HAVE_SYS_STAT_H) && defined(HAVE_FORK)
+#define SERVER_SUPPORTED
+#endif
+
+#ifdef SERVER_SUPPORTED
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+/* Without a way to tell who is on the other end of a connection, a server
+ * would run jobs for any local user, so don't offer one.
+ */
+#if !defined(SO_PEERCRED) && !defined(HAVE_GETPEEREID)
+#undef SERVER_SUPPORTED
+#elif !defined(SO_PEERCRED)
+/* may be hidden by _POSIX_C_SOURCE */
+int getpeereid(int s, uid_t *euid, gid_t *egid);
+#endif
+#endif
+
+#include "yasm-server.h"
+
+
+#ifdef SERVER_SUPPORTED
+
+/* A request is a 4-byte big-endian payload length, sent together with the
+ * client's stdin, stdout and stderr descriptors, followed by the payload:
+ * NUL-terminated strings giving the working directory, the number of
+ * arguments (in decimal), the arguments, and then the environment.  The
+ * reply is the job's exit status, also as a 4-byte big-endian number.
+ *
+ * Both ends only talk to processes running as the same user, and the
+ * socket is only accessible to that user.
+ */
+#define REQUEST_FDS     3
+#define REQUEST_MAX     (16UL*1024*1024)    /* sanity limit on payload */
+
+/* Environment variables passed on to jobs.  Any others a job needs, e.g.
+ * for %!name references in NASM source, are named (separated by colons) in
+ * YASM_SERVER_ENV.
+ */
+static const char *job_env[] = {
+    "YASM_TEST_SUITE"
+};
+
+static volatile sig_atomic_t server_stop = 0;
+
+static void
+server_signal(int sig)
+{
+    server_stop = 1;
+}
+
+static void
+put_be32(unsigned char *buf, unsigned long val)
+{
+    buf[0] = (unsigned char)((val >> 24) & 0xFF);
+    buf[1] = (unsigned char)((val >> 16) & 0xFF);
+    buf[2] = (unsigned char)((val >> 8) & 0xFF);
+    buf[3] = (unsigned char)(val & 0xFF);
+}
+
+static unsigned long
+get_be32(const unsigned char *buf)
+{
+    return ((unsigned long)buf[0] << 24) | ((unsigned long)buf[1] << 16) |
+        ((unsigned long)buf[2] << 8) | (unsigned long)buf[3];
+}
+
+static int
+write_all(int fd, const void *buf, size_t len)
+{
+    const char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int
+read_all(int fd, void *buf, size_t len)
+{
+    char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (n == 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int
+set_socket_addr(/*@out@*/ struct sockaddr_un *addr, const char *path)
+{
+    if (strlen(path) >= sizeof(addr->sun_path))
+        return -1;
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+/* Is path a socket owned by us and not accessible to anyone else? */
+static int
+is_own_socket(const char *path, int check_mode)
+{
+    struct stat st;
+
+    if (lstat(path, &st) != 0 || !S_ISSOCK(st.st_mode) ||
+        st.st_uid != geteuid())
+        return 0;
+    if (check_mode && (st.st_mode & (S_IRWXG|S_IRWXO)) != 0)
+        return 0;
+    return 1;
+}
+
+/* Is the process on the other end of the connection fd running as us? */
+static int
+is_own_peer(int fd)
+{
+    uid_t uid;
+#ifdef SO_PEERCRED
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 ||
+        len != sizeof(cred))
+        return 0;
+    uid = cred.uid;
+#else
+    gid_t gid;
+
+    if (getpeereid(fd, &uid, &gid) != 0)
+        return 0;
+#endif
+    return uid == geteuid();
+}
+
+/* Should the environment entry var ("name=value") be passed to jobs?  extra
+ * is the value of YASM_SERVER_ENV, if set.
+ */
+static int
+is_job_env(const char *var, /*@null@*/ const char *extra)
+{
+    size_t name_len = strcspn(var, "="), len;
+    size_t i;
+
+    if (var[name_len] != '=')
+        return 0;
+    for (i=0; i<NELEMS(job_env); i++) {
+        if (strlen(job_env[i]) == name_len &&
+            strncmp(var, job_env[i], name_len) == 0)
+            return 1;
+    }
+    while (extra && *extra != '\0') {
+        len = strcspn(extra, ":");
+        if (len == name_len && strncmp(var, extra, len) == 0)
+            return 1;
+        extra += len;
+        if (*extra == ':')
+            extra++;
+    }
+    return 0;
+}
+
+static void
+set_signal(int sig, void (*handler) (int))
+{
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0;            /* no SA_RESTART: interrupt accept() */
+    sigaction(sig, &sa, NULL);
+}
+
+/* Receive a request on conn.  Returns the payload (NUL-terminated, with
+ * length in *len) and the client's descriptors in fds, or NULL on error.
+ */
+static /*@null@*/ /*@only@*/ char *
+receive_request(int conn, int fds[REQUEST_FDS], /*@out@*/ size_t *len)
+{
+    unsigned char hdr[4];
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int)*REQUEST_FDS)];
+    } control;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    ssize_t n;
+    char *payload;
+    int got_fds = 0;
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = hdr;
+    iov.iov_len = sizeof(hdr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    do {
+        n = recvmsg(conn, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0)
+        return NULL;
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS
+            && cmsg->cmsg_len == CMSG_LEN(sizeof(int)*REQUEST_FDS)) {
+            memcpy(fds, CMSG_DATA(cmsg), sizeof(int)*REQUEST_FDS);
+            got_fds = 1;
+        }
+    }
+    if (!got_fds)
+        return NULL;
+
+    if ((size_t)n < sizeof(hdr) &&
+        read_all(conn, &hdr[n], sizeof(hdr)-(size_t)n) != 0)
+        return NULL;
+
+    *len = get_be32(hdr);
+    if (*len > REQUEST_MAX)
+        return NULL;
+    payload = yasm_xmalloc(*len+1);
+    if (read_all(conn, payload, *len) != 0) {
+        yasm_xfree(payload);
+        return NULL;
+    }
+    payload[*len] = '\0';
+    return payload;
+}
+
+/* Split a request payload into the working directory, arguments and
+ * environment.  Returns 0 on success.
+ */
+static int
+parse_request(char *payload, size_t len, /*@out@*/ char **cwd,
+              /*@out@*/ int *argc, /*@out@*/ char ***argv,
+              /*@out@*/ char ***envp)
+{
+    char *end = payload+len;
+    char *p;
+    long nargs;
+    size_t nenv = 0, i;
+
+    *cwd = payload;
+    p = payload+strlen(payload)+1;
+    if (p >= end)
+        return -1;
+    nargs = strtol(p, NULL, 10);
+    p += strlen(p)+1;
+    if (nargs < 1 || (unsigned long)nargs > len)
+        return -1;
+
+    *argc = (int)nargs;
+    *argv = yasm_xmalloc((size_t)(nargs+1)*sizeof(char *));
+    for (i=0; i<(size_t)nargs; i++) {
+        if (p >= end) {
+            yasm_xfree(*argv);
+            return -1;
+        }
+        (*argv)[i] = p;
+        p += strlen(p)+1;
+    }
+    (*argv)[nargs] = NULL;
+
+    for (i=(size_t)(p-payload); i<len; i++) {
+        if (payload[i] == '\0')
+            nenv++;
+    }
+    *envp = yasm_xmalloc((nenv+1)*sizeof(char *));
+    for (i=0; i<nenv; i++) {
+        (*envp)[i] = p;
+        p += strlen(p)+1;
+    }
+    (*envp)[nenv] = NULL;
+    return 0;
+}
+
+/* Run the job for one connection; called in a child of the server.  The job
+ * itself runs in a further child, so that the exit status can be reported
+ * even if the job exits from deep inside the assembler.
+ */
+static void
+server_serve(int conn, int (*job) (int argc, char *argv[]),
+             void (*print_error) (const char *fmt, ...))
+{
+    int fds[REQUEST_FDS];
+    unsigned char reply[4];
+    char *payload, *cwd;
+    char **argv, **envp;
+    size_t len;
+    int argc, status, i;
+    pid_t pid;
+
+    payload = receive_request(conn, fds, &len);
+    if (!payload)
+        return;
+    if (parse_request(payload, len, &cwd, &argc, &argv, &envp) != 0) {
+        for (i=0; i<REQUEST_FDS; i++)
+            close(fds[i]);
+        yasm_xfree(payload);
+        return;
+    }
+
+    pid = fork();
+    if (pid == 0) {
+        close(conn);
+        for (i=0; i<REQUEST_FDS; i++) {
+            dup2(fds[i], i);
+            if (fds[i] >= REQUEST_FDS)
+                close(fds[i]);
+        }
+        environ = envp;
+        if (chdir(cwd) != 0) {
+            print_error(_("could not change to directory `%s'"), cwd);
+            exit(EXIT_FAILURE);
+        }
+        exit(job(argc, argv));
+    }
+
+    for (i=0; i<REQUEST_FDS; i++)
+        close(fds[i]);
+
+    status = EXIT_FAILURE;
+    if (pid > 0) {
+        int wstatus;
+        pid_t w;
+        do {
+            w = waitpid(pid, &wstatus, 0);
+        } while (w < 0 && errno == EINTR);
+        if (w == pid && WIFEXITED(wstatus))
+            status = WEXITSTATUS(wstatus);
+    }
+
+    put_be32(reply, (unsigned long)status);
+    write_all(conn, reply, sizeof(reply));
+
+    yasm_xfree(envp);
+    yasm_xfree(argv);
+    yasm_xfree(payload);
+}
+
+int
+server_run(const char *path, int (*job) (int argc, char *argv[]),
+           void (*print_error) (const char *fmt, ...))
+{
+    struct sockaddr_un addr;
+    mode_t old_umask;
+    int fd, rc;
+
+    if (set_socket_addr(&addr, path) != 0) {
+        print_error(_("socket name `%s' is too long"), path);
+        return EXIT_FAILURE;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        print_error(_("could not create socket: %s"), strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    /* Only we may connect */
+    old_umask = umask(077);
+    rc = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    if (rc != 0 && errno == EADDRINUSE) {
+        /* Replace the socket if it was left behind by a server of ours
+         * that's no longer running.
+         */
+        int probe;
+
+        if (!is_own_socket(path, 0)) {
+            umask(old_umask);
+            close(fd);
+            print_error(_("`%s' exists and is not a socket owned by you"),
+                        path);
+            return EXIT_FAILURE;
+        }
+        probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe >= 0 &&
+            connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            umask(old_umask);
+            close(probe);
+            close(fd);
+            print_error(_("a server is already listening on `%s'"), path);
+            return EXIT_FAILURE;
+        }
+        if (probe >= 0)
+            close(probe);
+        unlink(path);
+        rc = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    }
+    umask(old_umask);
+    if (rc != 0 || listen(fd, SOMAXCONN) != 0) {
+        print_error(_("could not listen on `%s': %s"), path,
+                    strerror(errno));
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    set_signal(SIGINT, server_signal);
+    set_signal(SIGTERM, server_signal);
+    set_signal(SIGPIPE, SIG_IGN);
+    set_signal(SIGCHLD, SIG_IGN);       /* reap connection handlers */
+
+    while (!server_stop) {
+        pid_t pid;
+        int conn = accept(fd, NULL, NULL);
+
+        if (conn < 0)
+            continue;
+        if (!is_own_peer(conn)) {
+            close(conn);
+            continue;
+        }
+
+        pid = fork();
+        if (pid == 0) {
+            close(fd);
+            set_signal(SIGINT, SIG_DFL);
+            set_signal(SIGTERM, SIG_DFL);
+            set_signal(SIGPIPE, SIG_DFL);
+            set_signal(SIGCHLD, SIG_DFL);
+            server_serve(conn, job, print_error);
+            _exit(EXIT_SUCCESS);
+        }
+        if (pid < 0)
+            print_error(_("could not fork: %s"), strerror(errno));
+        close(conn);
+    }
+
+    close(fd);
+    if (is_own_socket(path, 0))
+        unlink(path);
+    return EXIT_SUCCESS;
+}
+
+int
+server_client(const char *path, int argc, char *argv[], int *status,
+              void (*print_error) (const char *fmt, ...))
+{
+    struct sockaddr_un addr;
+    int fd, i;
+    int fds[REQUEST_FDS] = {0, 1, 2};
+    unsigned char hdr[4], reply[4];
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int)*REQUEST_FDS)];
+    } control;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char *cwd, *payload, *p;
+    const char *extra_env = getenv("YASM_SERVER_ENV");
+    char nargs[32];
+    size_t cwd_size = 256, len;
+    ssize_t n;
+
+    if (set_socket_addr(&addr, path) != 0)
+        return 1;
+    /* Our streams and environment only go to a server of our own */
+    if (access(path, F_OK) == 0 && !is_own_socket(path, 1)) {
+        print_error(
+            _("warning: ignoring server `%s': not a socket only you can use"),
+            path);
+        return 1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return 1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return 1;
+    }
+    if (!is_own_peer(fd)) {
+        print_error(_("warning: ignoring server `%s': not running as you"),
+                    path);
+        close(fd);
+        return 1;
+    }
+
+    /* Build the payload */
+    cwd = yasm_xmalloc(cwd_size);
+    while (!getcwd(cwd, cwd_size)) {
+        if (errno != ERANGE) {
+            yasm_xfree(cwd);
+            close(fd);
+            return 1;
+        }
+        cwd_size *= 2;
+        cwd = yasm_xrealloc(cwd, cwd_size);
+    }
+    sprintf(nargs, "%d", argc);
+
+    len = strlen(cwd)+1 + strlen(nargs)+1;
+    for (i=0; i<argc; i++)
+        len += strlen(argv[i])+1;
+    for (i=0; environ[i]; i++) {
+        if (is_job_env(environ[i], extra_env))
+            len += strlen(environ[i])+1;
+    }
+
+    p = payload = yasm_xmalloc(len);
+    strcpy(p, cwd);
+    p += strlen(p)+1;
+    strcpy(p, nargs);
+    p += strlen(p)+1;
+    for (i=0; i<argc; i++) {
+        strcpy(p, argv[i]);
+        p += strlen(p)+1;
+    }
+    for (i=0; environ[i]; i++) {
+        if (!is_job_env(environ[i], extra_env))
+            continue;
+        strcpy(p, environ[i]);
+        p += strlen(p)+1;
+    }
+    yasm_xfree(cwd);
+
+    /* Send the header along with our standard streams */
+    put_be32(hdr, (unsigned long)len);
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = hdr;
+    iov.iov_len = sizeof(hdr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int)*REQUEST_FDS);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(int)*REQUEST_FDS);
+
+    do {
+        n = sendmsg(fd, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n != (ssize_t)sizeof(hdr)) {
+        /* Nothing has run yet; e.g. one of our streams is closed */
+        yasm_xfree(payload);
+        close(fd);
+        return 1;
+    }
+
+    if (write_all(fd, payload, len) != 0 ||
+        read_all(fd, reply, sizeof(reply)) != 0) {
+        print_error(_("lost connection to server `%s'"), path);
+        *status = EXIT_FAILURE;
+    } else
+        *status = (int)get_be32(reply);
+
+    yasm_xfree(payload);
+    close(fd);
+    return 0;
+}
+
+#else
+
+int
+server_run(const char *path, int (*job) (int argc, char *argv[]),
+           void (*print_error) (const char *fmt, ...))
+{
+    print_error(_("server mode is not supported on this platform"));
+    return EXIT_FAILURE;
+}
+
+int
+server_client(const char *path, int argc, char *argv[], int *status,
+              void (*print_error) (const char *fmt, ...))
+{
+    return 1;
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Assembly server and client
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef YASM_SERVER_H
+#define YASM_SERVER_H
+
+/* Listen on the local socket path and run each job sent by server_client()
+ * by calling job with the job's command line, in a process forked from the
+ * server, with the client's standard streams, working directory and
+ * environment.  Only the server's user can connect, and only jobs from
+ * processes running as that user are run.  Runs until interrupted or
+ * terminated.  Returns the exit status for the server itself.
+ */
+int server_run(const char *path, int (*job) (int argc, char *argv[]),
+               void (*print_error) (const char *fmt, ...));
+
+/* Run the command line on the server listening on path, which must be a
+ * socket only our user can use, served by a process running as that user.
+ * Only the environment variables yasm reads, plus any named in
+ * YASM_SERVER_ENV, are passed on.  Returns 0 and sets *status to the job's
+ * exit status if the server ran the job, or nonzero if no suitable server
+ * could be reached (in which case the job should be run locally).
+ */
+int server_client(const char *path, int argc, char *argv[], int *status,
+                  void (*print_error) (const char *fmt, ...));
+
+#endif
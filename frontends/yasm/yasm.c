@@ -36,6 +36,8 @@
 #endif
 
 #include "yasm-options.h"
+#include "yasm-cache.h"
+#include "yasm-server.h"
 
 #if defined(CMAKE_BUILD) && defined(BUILD_SHARED_LIBS)
 #include "yasm-plugin.h"
@@ -46,6 +48,9 @@
 /* Preprocess-only buffer size */
 #define PREPROC_BUF_SIZE    16384
 
+/* Default result cache size limit, in megabytes */
+#define CACHE_DEFAULT_SIZE  256
+
 /*@null@*/ /*@only@*/ static char *obj_filename = NULL, *in_filename = NULL;
 /*@null@*/ /*@only@*/ static char *global_prefix = NULL, *global_suffix = NULL;
 /*@null@*/ /*@only@*/ static char *list_filename = NULL, *map_filename = NULL;
@@ -75,6 +80,15 @@ static int makedep_dos2unix_slash = 0;
 /*@null@*/ /*@only@*/ static const char *makedep_out_filename = NULL;
 /*@null@*/ /*@only@*/ static const char *makedep_target = NULL;
 static int warning_error = 0;   /* warnings being treated as errors */
+static int stream_errors = 0;
+static unsigned long max_repeat = 0;    /* 0=unlimited */
+/*@null@*/ /*@only@*/ static char *cache_dir = NULL;
+static unsigned long cache_max_size = CACHE_DEFAULT_SIZE*1024UL*1024UL;
+static int cache_key_valid = 0;
+static char cache_key[CACHE_KEY_LEN+1];
+static yasm_md5_context cache_args_md5;    /* command line, for the key */
+/*@null@*/ /*@only@*/ static char *server_filename = NULL;
+static int in_server_job = 0;
 static FILE *errfile;
 /*@null@*/ /*@only@*/ static char *error_filename = NULL;
 static enum {
@@ -84,6 +98,7 @@ static enum {
 
 /*@null@*/ /*@dependent@*/ static FILE *open_file(const char *filename,
                                                   const char *mode);
+static void setup_errwarns(yasm_errwarns *errwarns, yasm_linemap *linemap);
 static void check_errors(/*@only@*/ yasm_errwarns *errwarns,
                          /*@only@*/ yasm_object *object,
                          /*@only@*/ yasm_linemap *linemap);
@@ -109,6 +124,10 @@ static int preproc_only_handler(char *cmd, /*@null@*/ char *param, int extra);
 static int opt_include_option(char *cmd, /*@null@*/ char *param, int extra);
 static int opt_preproc_option(char *cmd, /*@null@*/ char *param, int extra);
 static int opt_ewmsg_handler(char *cmd, /*@null@*/ char *param, int extra);
+static int opt_stream_errors_handler(char *cmd, /*@null@*/ char *param,
+                                     int extra);
+static int opt_max_repeat_handler(char *cmd, /*@null@*/ char *param,
+                                  int extra);
 static int opt_makedep_and_assemble_handler(char *cmd, /*@null@*/ char *param, int extra);
 static int opt_makedep_empty_handler(char *cmd, /*@null@*/ char *param, int extra);
 static int opt_makedep_target_handler(char *cmd, /*@null@*/ char *param, int extra);
@@ -116,6 +135,10 @@ static int opt_makedep_handler(char *cmd, /*@null@*/ char *param, int extra);
 static int opt_makedep_dos2unix_slash_handler(char *cmd, /*@null@*/ char *param, int extra);
 static int opt_prefix_handler(char *cmd, /*@null@*/ char *param, int extra);
 static int opt_suffix_handler(char *cmd, /*@null@*/ char *param, int extra);
+static int opt_cache_dir_handler(char *cmd, /*@null@*/ char *param, int extra);
+static int opt_cache_size_handler(char *cmd, /*@null@*/ char *param,
+                                  int extra);
+static int opt_server_handler(char *cmd, /*@null@*/ char *param, int extra);
 #if defined(CMAKE_BUILD) && defined(BUILD_SHARED_LIBS)
 static int opt_plugin_handler(char *cmd, /*@null@*/ char *param, int extra);
 #endif
@@ -143,6 +166,7 @@ static void print_yasm_warning(const char *filename, unsigned long line,
 static void apply_preproc_builtins(void);
 static void apply_preproc_standard_macros(const yasm_stdmac *stdmacs);
 static void apply_preproc_saved_options(void);
+static void free_preproc_saved_options(void);
 static void print_list_keyword_desc(const char *name, const char *keyword);
 
 #ifndef MAX
@@ -226,12 +250,25 @@ static opt_option options[] =
       N_("undefine a macro"), N_("macro") },
     { 'X', NULL, 1, opt_ewmsg_handler, 0,
       N_("select error/warning message style (`gnu' or `vc')"), N_("style") },
+    { 0, "stream-errors", 0, opt_stream_errors_handler, 0,
+      N_("output errors/warnings as they occur instead of sorted by line"),
+      NULL },
+    { 0, "max-repeat", 1, opt_max_repeat_handler, 0,
+      N_("output each distinct error/warning at most count times"),
+      N_("count") },
     { 0, "prefix", 1, opt_prefix_handler, 0,
       N_("prepend argument to name of all external symbols"), N_("prefix") },
     { 0, "suffix", 1, opt_suffix_handler, 0,
       N_("append argument to name of all external symbols"), N_("suffix") },
     { 0, "postfix", 1, opt_suffix_handler, 0,
       N_("append argument to name of all external symbols"), N_("suffix") },
+    { 0, "cache-dir", 1, opt_cache_dir_handler, 0,
+      N_("reuse results of identical earlier runs cached in directory"),
+      N_("dir") },
+    { 0, "cache-size", 1, opt_cache_size_handler, 0,
+      N_("limit size of the result cache (default 256)"), N_("megabytes") },
+    { 0, "server", 1, opt_server_handler, 0,
+      N_("run as an assembly server listening on socket file"), N_("file") },
 #if defined(CMAKE_BUILD) && defined(BUILD_SHARED_LIBS)
     { 'N', "plugin", 1, opt_plugin_handler, 0,
       N_("load plugin module"), N_("plugin") },
@@ -399,6 +436,7 @@ do_preproc_only(void)
     /* Initialize line map */
     linemap = yasm_linemap_create();
     yasm_linemap_set(linemap, in_filename, 0, 1, 1);
+    setup_errwarns(errwarns, linemap);
 
     /* Default output to stdout if not specified or generating dependency
        makefiles */
@@ -471,6 +509,95 @@ do_preproc_only(void)
     return EXIT_SUCCESS;
 }
 
+/* Compute the result cache key by preprocessing the input into an MD5
+ * digest along with the selected modules and the full command line.
+ * Returns 1 if the cache had a matching entry (the outputs, including any
+ * make dependencies, have then already been written), otherwise returns 0
+ * and sets cache_key_valid if the result of this run may be stored.
+ */
+static int
+cache_lookup(void)
+{
+    yasm_md5_context md5;
+    unsigned char digest[16];
+    yasm_linemap *linemap;
+    yasm_errwarns *errwarns;
+    char *preproc_buf, *cwd;
+    int cacheable = 1, hit = 0;
+
+    /* Input we can't read twice, and output we don't cache */
+    if (strcmp(in_filename, "-") == 0 || map_filename ||
+        yasm__strcasecmp(cur_objfmt_module->keyword, "dbg") == 0)
+        return 0;
+
+    md5 = cache_args_md5;
+#define MD5_STRING(str) \
+    yasm_md5_update(&md5, (const unsigned char *)(str), strlen(str)+1)
+    MD5_STRING(PACKAGE_STRING);
+    cwd = yasm__getcwd();
+    MD5_STRING(cwd);
+    yasm_xfree(cwd);
+    MD5_STRING(cur_arch_module->keyword);
+    MD5_STRING(machine_name);
+    MD5_STRING(cur_parser_module->keyword);
+    MD5_STRING(cur_preproc_module->keyword);
+    MD5_STRING(cur_objfmt_module->keyword);
+    MD5_STRING(cur_dbgfmt_module->keyword);
+    if (cur_listfmt_module)
+        MD5_STRING(cur_listfmt_module->keyword);
+
+    linemap = yasm_linemap_create();
+    yasm_linemap_set(linemap, in_filename, 0, 1, 1);
+    errwarns = yasm_errwarns_create();
+
+    cur_preproc = yasm_preproc_create(cur_preproc_module, in_filename, NULL,
+                                      linemap, errwarns);
+    apply_preproc_builtins();
+    apply_preproc_standard_macros(cur_parser_module->stdmacs);
+    apply_preproc_standard_macros(cur_objfmt_module->stdmacs);
+    apply_preproc_saved_options();
+
+    while ((preproc_buf = yasm_preproc_get_line(cur_preproc)) != NULL) {
+        const char *p;
+
+        /* Included binary files don't show up in the preprocessed text */
+        for (p = preproc_buf; *p != '\0'; p++) {
+            if ((*p == 'i' || *p == 'I') &&
+                yasm__strncasecmp(p, "incbin", 6) == 0) {
+                cacheable = 0;
+                break;
+            }
+        }
+        MD5_STRING(preproc_buf);
+        yasm_xfree(preproc_buf);
+        if (!cacheable)
+            break;
+    }
+#undef MD5_STRING
+    yasm_md5_final(digest, &md5);
+
+    /* Don't cache anything the assembler would complain about */
+    if (yasm_errwarns_num_errors(errwarns, 1) > 0)
+        cacheable = 0;
+
+    if (cacheable) {
+        cache_key_string(cache_key, digest);
+        cache_key_valid = 1;
+        hit = cache_fetch(cache_dir, cache_key, obj_filename, list_filename);
+        /* The preprocessor has seen all the include files */
+        if (hit && generate_make_dependencies)
+            do_generate_make_dependencies();
+    }
+
+    yasm_preproc_destroy(cur_preproc);
+    cur_preproc = NULL;
+    yasm_error_clear();
+    yasm_warn_clear();
+    yasm_errwarns_destroy(errwarns);
+    yasm_linemap_destroy(linemap);
+    return hit;
+}
+
 static int
 do_assemble(void)
 {
@@ -486,6 +613,7 @@ do_assemble(void)
     /* Initialize line map */
     linemap = yasm_linemap_create();
     yasm_linemap_set(linemap, in_filename, 0, 1, 1);
+    setup_errwarns(errwarns, linemap);
 
     /* determine the object filename if not specified */
     if (!obj_filename) {
@@ -595,6 +723,15 @@ do_assemble(void)
     if (global_suffix)
         yasm_object_set_global_suffix(object, global_suffix);
 
+    /* Reuse the result of an identical earlier run if there is one */
+    if (cache_dir && cache_lookup()) {
+        yasm_linemap_destroy(linemap);
+        yasm_errwarns_destroy(errwarns);
+        cleanup(object);
+        yasm_delete_include_paths();
+        return EXIT_SUCCESS;
+    }
+
     cur_preproc = yasm_preproc_create(cur_preproc_module, in_filename,
                                       object->symtab, linemap, errwarns);
 
@@ -694,6 +831,11 @@ do_assemble(void)
         fclose(list);
     }
 
+    /* Save the results for later runs (only if they were clean) */
+    if (cache_key_valid && yasm_errwarns_num_errors(errwarns, 1) == 0)
+        cache_store(cache_dir, cache_key, obj_filename, list_filename,
+                    cache_max_size);
+
     /* Generate make dependency. */
     if (generate_make_dependencies)
         do_generate_make_dependencies();
@@ -708,12 +850,27 @@ do_assemble(void)
     return EXIT_SUCCESS;
 }
 
+static int run_cmdline(int argc, char *argv[]);
+
+/* Run one job on behalf of a server client, in a process of its own */
+static int
+server_job(int argc, char *argv[])
+{
+    in_server_job = 1;
+    if (server_filename) {
+        yasm_xfree(server_filename);
+        server_filename = NULL;
+    }
+    return run_cmdline(argc, argv);
+}
+
 /* main function */
 /*@-globstate -unrecog@*/
 int
 main(int argc, char *argv[])
 {
-    size_t i;
+    const char *server_env;
+    int i;
 
     errfile = stderr;
 
@@ -731,6 +888,21 @@ main(int argc, char *argv[])
     yasm_gettext_hook = handle_yasm_gettext;
     yasm_errwarn_initialize();
 
+    /* Hand the job to a running server if there is one; when running a
+     * server ourselves, don't try to be our own client.
+     */
+    server_env = getenv("YASM_SERVER");
+    if (server_env && server_env[0] != '\0') {
+        int status;
+        for (i=1; i<argc; i++) {
+            if (strncmp(argv[i], "--server", 8) == 0)
+                break;
+        }
+        if (i == argc &&
+            server_client(server_env, argc, argv, &status, print_error) == 0)
+            return status;
+    }
+
     /* Initialize BitVector (needed for intnum/floatnum). */
     if (BitVector_Boot() != ErrCode_Ok) {
         print_error(_("%s: could not initialize BitVector"), _("FATAL"));
@@ -753,12 +925,39 @@ main(int argc, char *argv[])
 #endif
 #endif
 
+    return run_cmdline(argc, argv);
+}
+
+/* Parse the command line and run the requested job */
+static int
+run_cmdline(int argc, char *argv[])
+{
+    size_t i;
+
     /* Initialize parameter storage */
     STAILQ_INIT(&preproc_options);
 
+    /* Hash the command line before option parsing modifies it */
+    yasm_md5_init(&cache_args_md5);
+    for (i=1; i<(size_t)argc; i++)
+        yasm_md5_update(&cache_args_md5, (const unsigned char *)argv[i],
+                        strlen(argv[i])+1);
+
     if (parse_cmdline(argc, argv, options, NELEMS(options), print_error))
         return EXIT_FAILURE;
 
+    if (server_filename) {
+        if (in_server_job) {
+            print_error(_("cannot start a server from a server job"));
+            return EXIT_FAILURE;
+        }
+        if (argc != 2) {
+            print_error(_("`--server' cannot be combined with other options"));
+            return EXIT_FAILURE;
+        }
+        return server_run(server_filename, server_job, print_error);
+    }
+
     switch (special_options) {
         case SPECIAL_SHOW_HELP:
             /* Does gettext calls internally */
@@ -890,6 +1089,15 @@ open_file(const char *filename, const char *mode)
     return f;
 }
 
+static void
+setup_errwarns(yasm_errwarns *errwarns, yasm_linemap *linemap)
+{
+    if (stream_errors)
+        yasm_errwarns_stream(errwarns, linemap, warning_error,
+                             print_yasm_error, print_yasm_warning);
+    yasm_errwarns_set_max_repeat(errwarns, max_repeat);
+}
+
 static void
 check_errors(yasm_errwarns *errwarns, yasm_object *object,
              yasm_linemap *linemap)
@@ -943,6 +1151,11 @@ cleanup(yasm_object *object)
             yasm_xfree(machine_name);
         if (objfmt_keyword)
             yasm_xfree(objfmt_keyword);
+        if (cache_dir)
+            yasm_xfree(cache_dir);
+        if (server_filename)
+            yasm_xfree(server_filename);
+        free_preproc_saved_options();
     }
 
     if (errfile != stderr && errfile != stdout)
@@ -1295,6 +1508,30 @@ opt_ewmsg_handler(/*@unused@*/ char *cmd, char *param, /*@unused@*/ int extra)
     return 0;
 }
 
+static int
+opt_stream_errors_handler(/*@unused@*/ char *cmd, /*@unused@*/ char *param,
+                          /*@unused@*/ int extra)
+{
+    stream_errors = 1;
+    return 0;
+}
+
+static int
+opt_max_repeat_handler(/*@unused@*/ char *cmd, char *param,
+                       /*@unused@*/ int extra)
+{
+    char *end;
+
+    assert(param != NULL);
+    max_repeat = strtoul(param, &end, 10);
+    if (*param == '\0' || *end != '\0') {
+        print_error(_("invalid repeat count `%s'"), param);
+        return 1;
+    }
+
+    return 0;
+}
+
 static int
 opt_makedep_and_assemble_handler(/*@unused@*/ char *cmd, char *param,
                           /*@unused@*/ int extra)
@@ -1364,6 +1601,50 @@ opt_suffix_handler(/*@unused@*/ char *cmd, char *param, /*@unused@*/ int extra)
     return 0;
 }
 
+static int
+opt_cache_dir_handler(/*@unused@*/ char *cmd, char *param,
+                      /*@unused@*/ int extra)
+{
+    if (cache_dir)
+        yasm_xfree(cache_dir);
+
+    assert(param != NULL);
+    cache_dir = yasm__xstrdup(param);
+
+    return 0;
+}
+
+static int
+opt_cache_size_handler(/*@unused@*/ char *cmd, char *param,
+                       /*@unused@*/ int extra)
+{
+    char *end;
+    unsigned long size;
+
+    assert(param != NULL);
+    size = strtoul(param, &end, 10);
+    if (*param == '\0' || *end != '\0' || size > 4095) {
+        print_error(_("invalid cache size `%s'"), param);
+        return 1;
+    }
+    cache_max_size = size*1024UL*1024UL;
+
+    return 0;
+}
+
+static int
+opt_server_handler(/*@unused@*/ char *cmd, char *param,
+                   /*@unused@*/ int extra)
+{
+    if (server_filename)
+        yasm_xfree(server_filename);
+
+    assert(param != NULL);
+    server_filename = yasm__xstrdup(param);
+
+    return 0;
+}
+
 #if defined(CMAKE_BUILD) && defined(BUILD_SHARED_LIBS)
 static int
 opt_plugin_handler(/*@unused@*/ char *cmd, char *param,
@@ -1411,7 +1692,7 @@ apply_preproc_standard_macros(const yasm_stdmac *stdmacs)
 static void
 apply_preproc_saved_options(void)
 {
-    constcharparam *cp, *cpnext;
+    constcharparam *cp;
 
     void (*funcs[3])(yasm_preproc *, const char *);
     funcs[0] = cur_preproc_module->add_include_file;
@@ -1422,6 +1703,12 @@ apply_preproc_saved_options(void)
         if (0 <= cp->id && cp->id < 3 && funcs[cp->id])
             funcs[cp->id](cur_preproc, cp->param);
     }
+}
+
+static void
+free_preproc_saved_options(void)
+{
+    constcharparam *cp, *cpnext;
 
     cp = STAILQ_FIRST(&preproc_options);
     while (cp != NULL) {
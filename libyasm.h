@@ -68,6 +68,7 @@ typedef unsigned long uintptr_t;
 
 #include <libyasm/file.h>
 #include <libyasm/module.h>
+#include <libyasm/assemble.h>
 
 #include <libyasm/hamt.h>
 #include <libyasm/md5.h>
@@ -0,0 +1,594 @@
+/*
+ * In-memory assembly
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/* fopencookie() is a GNU extension */
+#define _GNU_SOURCE
+
+#include "util.h"
+
+#include <time.h>
+
+#include "coretype.h"
+#include "linemap.h"
+#include "errwarn.h"
+#include "intnum.h"
+#include "expr.h"
+#include "value.h"
+#include "symrec.h"
+
+#include "bytecode.h"
+#include "arch.h"
+#include "section.h"
+
+#include "dbgfmt.h"
+#include "objfmt.h"
+#include "parser.h"
+#include "preproc.h"
+
+#include "file.h"
+#include "module.h"
+#include "assemble.h"
+
+
+/* Memory-backed streams.  The object formats and preprocessors only deal in
+ * FILE *s, so where the C library lets us supply our own stream functions
+ * the data is read from and written to memory directly.  Otherwise an
+ * anonymous temporary file is used.
+ */
+#if defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN)
+#define MEM_STREAMS
+#endif
+
+#ifdef MEM_STREAMS
+typedef struct mem_file {
+    /* Data being read, or NULL if writing to out */
+    /*@null@*/ /*@dependent@*/ const char *src;
+    size_t src_len;
+
+    /*@null@*/ /*@dependent@*/ yasm_output_buffer *out;
+
+    size_t pos;             /* current position */
+} mem_file;
+
+static size_t
+mem_read(mem_file *mf, char *buf, size_t size)
+{
+    if (!mf->src || mf->pos >= mf->src_len)
+        return 0;
+    if (size > mf->src_len - mf->pos)
+        size = mf->src_len - mf->pos;
+    memcpy(buf, mf->src + mf->pos, size);
+    mf->pos += size;
+    return size;
+}
+
+static size_t
+mem_write(mem_file *mf, const char *buf, size_t size)
+{
+    yasm_output_buffer *out = mf->out;
+
+    if (!out || size == 0)
+        return 0;
+    if (mf->pos + size > out->size) {
+        size_t newsize = out->size ? out->size : 4096;
+        while (newsize < mf->pos + size)
+            newsize *= 2;
+        out->data = out->data ? yasm_xrealloc(out->data, newsize)
+                              : yasm_xmalloc(newsize);
+        out->size = newsize;
+    }
+    /* Zero any gap left by seeking past the end */
+    if (mf->pos > out->len)
+        memset(out->data + out->len, 0, mf->pos - out->len);
+    memcpy(out->data + mf->pos, buf, size);
+    mf->pos += size;
+    if (mf->pos > out->len)
+        out->len = mf->pos;
+    return size;
+}
+
+/* Returns new position, or -1 on error. */
+static long
+mem_seek(mem_file *mf, long offset, int whence)
+{
+    long base;
+
+    switch (whence) {
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = (long)mf->pos;
+            break;
+        case SEEK_END:
+            base = (long)(mf->src ? mf->src_len : mf->out->len);
+            break;
+        default:
+            return -1;
+    }
+    if (offset < -base)
+        return -1;
+    mf->pos = (size_t)(base + offset);
+    return (long)mf->pos;
+}
+
+#ifdef HAVE_FOPENCOOKIE
+static ssize_t
+cookie_read(void *cookie, char *buf, size_t size)
+{
+    return (ssize_t)mem_read(cookie, buf, size);
+}
+
+static ssize_t
+cookie_write(void *cookie, const char *buf, size_t size)
+{
+    return (ssize_t)mem_write(cookie, buf, size);
+}
+
+static int
+cookie_seek(void *cookie, off64_t *offset, int whence)
+{
+    long pos = mem_seek(cookie, (long)*offset, whence);
+    if (pos < 0)
+        return -1;
+    *offset = pos;
+    return 0;
+}
+
+static int
+cookie_close(void *cookie)
+{
+    yasm_xfree(cookie);
+    return 0;
+}
+
+static FILE *
+mem_fopen(mem_file *mf, const char *mode)
+{
+    cookie_io_functions_t funcs;
+    FILE *f;
+
+    funcs.read = cookie_read;
+    funcs.write = cookie_write;
+    funcs.seek = cookie_seek;
+    funcs.close = cookie_close;
+    f = fopencookie(mf, mode, funcs);
+    if (!f)
+        yasm_xfree(mf);
+    return f;
+}
+#else
+static int
+funopen_read(void *cookie, char *buf, int size)
+{
+    return (int)mem_read(cookie, buf, (size_t)size);
+}
+
+static int
+funopen_write(void *cookie, const char *buf, int size)
+{
+    return (int)mem_write(cookie, buf, (size_t)size);
+}
+
+static fpos_t
+funopen_seek(void *cookie, fpos_t offset, int whence)
+{
+    return (fpos_t)mem_seek(cookie, (long)offset, whence);
+}
+
+static int
+funopen_close(void *cookie)
+{
+    yasm_xfree(cookie);
+    return 0;
+}
+
+static FILE *
+mem_fopen(mem_file *mf, const char *mode)
+{
+    FILE *f = funopen(mf, mf->src ? funopen_read : NULL,
+                      mf->src ? NULL : funopen_write, funopen_seek,
+                      funopen_close);
+    if (!f)
+        yasm_xfree(mf);
+    return f;
+}
+#endif
+#endif
+
+/* Open data for reading. */
+static /*@null@*/ FILE *
+mem_open_read(const char *data, size_t len)
+{
+#ifdef MEM_STREAMS
+    mem_file *mf = yasm_xmalloc(sizeof(mem_file));
+    mf->src = data;
+    mf->src_len = len;
+    mf->out = NULL;
+    mf->pos = 0;
+    return mem_fopen(mf, "r");
+#else
+    FILE *f = tmpfile();
+    if (!f)
+        return NULL;
+    if (fwrite(data, 1, len, f) != len) {
+        fclose(f);
+        return NULL;
+    }
+    rewind(f);
+    return f;
+#endif
+}
+
+/* Open a stream that writes into out; finish with mem_close_write(). */
+static /*@null@*/ FILE *
+mem_open_write(yasm_output_buffer *out)
+{
+#ifdef MEM_STREAMS
+    mem_file *mf = yasm_xmalloc(sizeof(mem_file));
+    mf->src = NULL;
+    mf->src_len = 0;
+    mf->out = out;
+    mf->pos = 0;
+    return mem_fopen(mf, "w");
+#else
+    return tmpfile();
+#endif
+}
+
+/* Close a stream from mem_open_write(), leaving the data written to it in
+ * out.  Returns nonzero on error.
+ */
+static int
+mem_close_write(FILE *f, yasm_output_buffer *out)
+{
+#ifdef MEM_STREAMS
+    return fclose(f) != 0;
+#else
+    long len;
+
+    if (fflush(f) != 0 || fseek(f, 0, SEEK_END) != 0 ||
+        (len = ftell(f)) < 0) {
+        fclose(f);
+        return 1;
+    }
+    if ((size_t)len > out->size) {
+        out->data = out->data ? yasm_xrealloc(out->data, (size_t)len)
+                              : yasm_xmalloc((size_t)len);
+        out->size = (size_t)len;
+    }
+    out->len = (size_t)len;
+    rewind(f);
+    if (fread(out->data, 1, out->len, f) != out->len) {
+        fclose(f);
+        return 1;
+    }
+    fclose(f);
+    return 0;
+#endif
+}
+
+typedef struct assemble_source {
+    const char *filename;
+    const char *src;
+    size_t src_len;
+    /*@null@*/ const yasm_assemble_options *opts;
+
+    /* The caller's hook, consulted for anything we don't supply */
+    /*@null@*/ yasm_fopen_hook_func prev_hook;
+    /*@null@*/ void *prev_data;
+} assemble_source;
+
+/* yasm_fopen_hook_func that supplies the source and any resolved includes */
+static /*@null@*/ FILE *
+assemble_fopen(const char *filename, const char *mode, void *d)
+{
+    assemble_source *as = d;
+    const char *data;
+    size_t len;
+
+    if (strchr(mode, 'w') || strchr(mode, 'a') || strchr(mode, '+'))
+        return NULL;
+    if (strcmp(filename, as->filename) == 0)
+        return mem_open_read(as->src, as->src_len);
+    if (as->opts && as->opts->include_func &&
+        as->opts->include_func(filename, &data, &len,
+                               as->opts->include_data))
+        return mem_open_read(data, len);
+    if (as->prev_hook)
+        return as->prev_hook(filename, mode, as->prev_data);
+    return NULL;
+}
+
+static void
+discard_error(const char *fn, unsigned long line, const char *msg,
+              const char *xref_fn, unsigned long xref_line,
+              const char *xref_msg)
+{
+}
+
+static void
+discard_warning(const char *fn, unsigned long line, const char *msg)
+{
+}
+
+/* Report an error not tied to a source line. */
+static void
+report_error(const yasm_assemble_options *opts, const char *src_filename,
+             const char *msg, const char *what, const char *keyword)
+{
+    char *str;
+
+    if (!opts || !opts->print_error)
+        return;
+    msg = yasm_gettext_hook(msg);
+    what = yasm_gettext_hook(what);
+    str = yasm_xmalloc(strlen(msg) + strlen(what) + strlen(keyword) + 1);
+    sprintf(str, msg, what, keyword);
+    opts->print_error(src_filename, 0, str, NULL, 0, NULL);
+    yasm_xfree(str);
+}
+
+/* Returns the processor time since *start, and restarts it. */
+static double
+phase_time(clock_t *start)
+{
+    clock_t now = clock();
+    double t = (double)(now - *start) / CLOCKS_PER_SEC;
+    *start = now;
+    return t;
+}
+
+int
+yasm_assemble_buffer(const char *src_filename, const char *src,
+                     size_t src_len, const yasm_assemble_options *opts,
+                     yasm_output_buffer *out)
+{
+    static const yasm_assemble_options default_opts;
+    const char *keyword, *machine;
+    yasm_arch_module *arch_module;
+    yasm_parser_module *parser_module;
+    yasm_preproc_module *preproc_module;
+    const yasm_objfmt_module *objfmt_module;
+    yasm_dbgfmt_module *dbgfmt_module;
+    yasm_arch_create_error arch_error;
+    yasm_arch *arch;
+    /*@null@*/ yasm_object *object = NULL;
+    /*@null@*/ yasm_preproc *preproc = NULL;
+    yasm_linemap *linemap;
+    yasm_errwarns *errwarns;
+    assemble_source as;
+    yasm_assemble_stats stats;
+    clock_t start = clock();
+    char *predef;
+    FILE *f;
+    int i, matched, result = 1;
+
+    if (!opts)
+        opts = &default_opts;
+    out->len = 0;
+    memset(&stats, 0, sizeof(stats));
+    if (opts->stats)
+        *opts->stats = stats;
+    yasm_get_fopen_hook(&as.prev_hook, &as.prev_data);
+
+    /* Load modules */
+    keyword = opts->arch ? opts->arch : "x86";
+    arch_module = yasm_load_arch(keyword);
+    if (!arch_module) {
+        report_error(opts, src_filename, N_("unrecognized %s `%s'"),
+                     N_("architecture"), keyword);
+        return 1;
+    }
+    keyword = opts->parser ? opts->parser : "nasm";
+    parser_module = yasm_load_parser(keyword);
+    if (!parser_module) {
+        report_error(opts, src_filename, N_("unrecognized %s `%s'"),
+                     N_("parser"), keyword);
+        return 1;
+    }
+    keyword = opts->preproc ? opts->preproc
+                            : parser_module->default_preproc_keyword;
+    preproc_module = yasm_load_preproc(keyword);
+    if (!preproc_module) {
+        report_error(opts, src_filename, N_("unrecognized %s `%s'"),
+                     N_("preprocessor"), keyword);
+        return 1;
+    }
+    keyword = opts->objfmt ? opts->objfmt : "bin";
+    objfmt_module = yasm_load_objfmt(keyword);
+    if (!objfmt_module) {
+        report_error(opts, src_filename, N_("unrecognized %s `%s'"),
+                     N_("object format"), keyword);
+        return 1;
+    }
+    keyword = opts->dbgfmt ? opts->dbgfmt : "null";
+    dbgfmt_module = yasm_load_dbgfmt(keyword);
+    if (!dbgfmt_module) {
+        report_error(opts, src_filename, N_("unrecognized %s `%s'"),
+                     N_("debug format"), keyword);
+        return 1;
+    }
+
+    /* Check the preprocessor is one the parser can use */
+    matched = 0;
+    for (i=0; parser_module->preproc_keywords[i]; i++) {
+        if (yasm__strcasecmp(parser_module->preproc_keywords[i],
+                             preproc_module->keyword) == 0) {
+            matched = 1;
+            break;
+        }
+    }
+    if (!matched) {
+        report_error(opts, src_filename, N_("invalid %s `%s'"),
+                     N_("preprocessor"), preproc_module->keyword);
+        return 1;
+    }
+
+    /* Pick the machine the same way the command line program does */
+    if (opts->machine)
+        machine = opts->machine;
+    else if (yasm__strcasecmp(arch_module->keyword, "x86") == 0 &&
+             objfmt_module->default_x86_mode_bits == 64)
+        machine = "amd64";
+    else
+        machine = arch_module->default_machine_keyword;
+    if (yasm__strcasecmp(machine, "amd64") == 0 &&
+        yasm__strcasecmp(objfmt_module->keyword, "elfx32") == 0)
+        machine = "x32";
+
+    arch = yasm_arch_create(arch_module, machine, parser_module->keyword,
+                            &arch_error);
+    if (!arch) {
+        if (arch_error == YASM_ARCH_CREATE_BAD_PARSER)
+            report_error(opts, src_filename, N_("invalid %s `%s'"),
+                         N_("parser"), parser_module->keyword);
+        else
+            report_error(opts, src_filename, N_("invalid %s `%s'"),
+                         N_("machine"), machine);
+        return 1;
+    }
+
+    errwarns = yasm_errwarns_create();
+    linemap = yasm_linemap_create();
+    yasm_linemap_set(linemap, src_filename, 0, 1, 1);
+
+    object = yasm_object_create(src_filename,
+                                opts->obj_filename ? opts->obj_filename
+                                                   : "yasm.out",
+                                arch, objfmt_module, dbgfmt_module);
+    if (!object) {
+        /* arch has been destroyed along with the partial object */
+        yasm_errwarn_propagate(errwarns, 0);
+        goto done;
+    }
+    objfmt_module = ((yasm_objfmt_base *)object->objfmt)->module;
+
+    /* Feed the source (and resolved includes) to the preprocessor */
+    as.filename = src_filename;
+    as.src = src;
+    as.src_len = src_len;
+    as.opts = opts;
+    yasm_set_fopen_hook(assemble_fopen, &as);
+
+    preproc = yasm_preproc_create(preproc_module, src_filename,
+                                  object->symtab, linemap, errwarns);
+
+    keyword = opts->objfmt ? opts->objfmt : "bin";
+    predef = yasm_xmalloc(strlen("__YASM_OBJFMT__=") + strlen(keyword) + 1);
+    strcpy(predef, "__YASM_OBJFMT__=");
+    strcat(predef, keyword);
+    yasm_preproc_define_builtin(preproc, predef);
+    yasm_xfree(predef);
+
+    for (i=0; i<2; i++) {
+        const yasm_stdmac *stdmacs = i == 0 ? parser_module->stdmacs
+                                            : objfmt_module->stdmacs;
+        int j;
+        matched = -1;
+        for (j=0; stdmacs && stdmacs[j].parser; j++) {
+            if (yasm__strcasecmp(stdmacs[j].parser,
+                                 parser_module->keyword) == 0 &&
+                yasm__strcasecmp(stdmacs[j].preproc,
+                                 preproc_module->keyword) == 0)
+                matched = j;
+        }
+        if (matched >= 0 && stdmacs[matched].macros)
+            yasm_preproc_add_standard(preproc, stdmacs[matched].macros);
+    }
+
+    if (yasm__strcasecmp(arch_module->keyword, "x86") == 0)
+        yasm_arch_set_var(arch, "mode_bits",
+                          objfmt_module->default_x86_mode_bits);
+
+    stats.setup_time = phase_time(&start);
+
+    parser_module->do_parse(object, preproc, 0, linemap, errwarns);
+    stats.parse_time = phase_time(&start);
+    if (yasm_errwarns_num_errors(errwarns, opts->warning_error) > 0)
+        goto done;
+
+    yasm_object_finalize(object, errwarns);
+    stats.finalize_time = phase_time(&start);
+    if (yasm_errwarns_num_errors(errwarns, opts->warning_error) > 0)
+        goto done;
+
+    yasm_object_optimize(object, errwarns);
+    stats.optimize_time = phase_time(&start);
+    if (yasm_errwarns_num_errors(errwarns, opts->warning_error) > 0)
+        goto done;
+
+    yasm_dbgfmt_generate(object, linemap, errwarns);
+    if (yasm_errwarns_num_errors(errwarns, opts->warning_error) > 0)
+        goto done;
+
+    f = mem_open_write(out);
+    if (!f) {
+        yasm_error_set(YASM_ERROR_IO, N_("could not open output buffer"));
+        yasm_errwarn_propagate(errwarns, 0);
+        goto done;
+    }
+    yasm_objfmt_output(object, f,
+                       yasm__strcasecmp(dbgfmt_module->keyword, "null"),
+                       errwarns);
+    if (mem_close_write(f, out) != 0) {
+        yasm_error_set(YASM_ERROR_IO, N_("error writing output buffer"));
+        yasm_errwarn_propagate(errwarns, 0);
+    }
+    stats.output_time = phase_time(&start);
+
+    if (yasm_errwarns_num_errors(errwarns, opts->warning_error) == 0)
+        result = 0;
+
+done:
+    if (opts->stats)
+        *opts->stats = stats;
+    yasm_set_fopen_hook(as.prev_hook, as.prev_data);
+    yasm_errwarns_output_all(errwarns, linemap, opts->warning_error,
+                             opts->print_error ? opts->print_error
+                                               : discard_error,
+                             opts->print_warning ? opts->print_warning
+                                                 : discard_warning);
+    if (result != 0)
+        out->len = 0;
+    if (preproc)
+        yasm_preproc_destroy(preproc);
+    if (object)
+        yasm_object_destroy(object);    /* destroys arch too */
+    yasm_linemap_destroy(linemap);
+    yasm_errwarns_destroy(errwarns);
+    return result;
+}
+
+void
+yasm_output_buffer_free(yasm_output_buffer *out)
+{
+    if (out->data)
+        yasm_xfree(out->data);
+    out->data = NULL;
+    out->len = 0;
+    out->size = 0;
+}
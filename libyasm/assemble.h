@@ -0,0 +1,142 @@
+/**
+ * \file libyasm/assemble.h
+ * \brief YASM in-memory assembly interface.
+ *
+ * \license
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * \endlicense
+ */
+#ifndef YASM_ASSEMBLE_H
+#define YASM_ASSEMBLE_H
+
+#ifndef YASM_LIB_DECL
+#define YASM_LIB_DECL
+#endif
+
+/** Growable memory buffer that receives an object image. */
+typedef struct yasm_output_buffer {
+    /** Image data.  Allocated and grown with yasm_xmalloc() and
+     * yasm_xrealloc(); may be NULL if size is 0.
+     */
+    /*@null@*/ /*@owned@*/ unsigned char *data;
+
+    /** Length of the image in data. */
+    size_t len;
+
+    /** Allocated size of data. */
+    size_t size;
+} yasm_output_buffer;
+
+/** Function that supplies the contents of source and include files.
+ * \param filename  pathname of the file (for includes, as combined with the
+ *                  including file's directory or an include path)
+ * \param data      pointer to return file contents into; must remain valid
+ *                  until yasm_assemble_buffer() returns
+ * \param len       pointer to return length of file contents into
+ * \param d         include_data from the options
+ * \return Nonzero if the file was supplied, 0 to look for it in the
+ *         filesystem instead.
+ */
+typedef int (*yasm_include_func)
+    (const char *filename, /*@out@*/ const char **data, /*@out@*/ size_t *len,
+     /*@null@*/ void *d);
+
+/** Processor time spent in each phase of yasm_assemble_buffer(), in
+ * seconds as measured with clock().  Phases that weren't reached (because
+ * of errors) are left at 0.
+ */
+typedef struct yasm_assemble_stats {
+    double setup_time;      /**< Module loading and object creation */
+    double parse_time;      /**< Preprocessing and parsing */
+    double finalize_time;   /**< yasm_object_finalize() */
+    double optimize_time;   /**< yasm_object_optimize() */
+    double output_time;     /**< Debug information and object output */
+} yasm_assemble_stats;
+
+/** Options for yasm_assemble_buffer().  NULL keywords select the same
+ * defaults as the yasm command line program.
+ */
+typedef struct yasm_assemble_options {
+    /*@null@*/ const char *arch;        /**< Architecture (default x86) */
+    /*@null@*/ const char *machine;     /**< Machine (default per arch) */
+    /*@null@*/ const char *parser;      /**< Parser (default nasm) */
+    /*@null@*/ const char *preproc;     /**< Preprocessor (default per
+                                         *   parser) */
+    /*@null@*/ const char *objfmt;      /**< Object format (default bin) */
+    /*@null@*/ const char *dbgfmt;      /**< Debug format (default null) */
+
+    /** Object filename, for formats that record it (default yasm.out). */
+    /*@null@*/ const char *obj_filename;
+
+    /** Resolver for include files not on disk (may be NULL). */
+    /*@null@*/ yasm_include_func include_func;
+    /*@null@*/ void *include_data;       /**< Data for include_func */
+
+    /** Treat warnings as errors. */
+    int warning_error;
+
+    /** Error and warning output functions (may be NULL to discard). */
+    /*@null@*/ yasm_print_error_func print_error;
+    /*@null@*/ yasm_print_warning_func print_warning;
+
+    /** Receives phase timings (may be NULL if not wanted). */
+    /*@null@*/ yasm_assemble_stats *stats;
+} yasm_assemble_options;
+
+/** Assemble source code held in memory into an object image held in memory.
+ * The source, and any file it includes, may be provided through the
+ * include function in the options rather than the filesystem.
+ * \note libyasm must be initialized as for normal use: BitVector, intnum,
+ *       floatnum and errwarn initialized and the standard modules loaded.
+ * \warning Not reentrant: calls must be serialized, both with each other and
+ *          with any other libyasm use in the process (for example with a
+ *          lock shared by all threads).  Assembly goes through process-wide
+ *          state: the error and warning indicators, the enabled warnings,
+ *          include paths, and the fopen hook.  This function installs its
+ *          own fopen hook for the duration of the call, passing files it
+ *          doesn't supply on to any hook set with yasm_set_fopen_hook(),
+ *          and puts that hook back before returning.
+ * \param src_filename  name to use for the source in diagnostics and as the
+ *                      base for relative includes
+ * \param src           source code
+ * \param src_len       length of src
+ * \param opts          assembly options (NULL for all defaults)
+ * \param out           buffer to receive the object image; any previous
+ *                      contents are replaced, reusing its allocation
+ * \return 0 on success, nonzero if there were errors (which are reported
+ *         through opts->print_error).
+ */
+YASM_LIB_DECL
+int yasm_assemble_buffer(const char *src_filename, const char *src,
+                         size_t src_len,
+                         /*@null@*/ const yasm_assemble_options *opts,
+                         yasm_output_buffer *out);
+
+/** Free the data of an output buffer, leaving it empty.
+ * \param out           output buffer
+ */
+YASM_LIB_DECL
+void yasm_output_buffer_free(yasm_output_buffer *out);
+
+#endif
@@ -35,22 +35,31 @@ typedef struct assoc_data_item {
     void *data;
 } assoc_data_item;
 
+/* Items are allocated together with the container.  Symbols and sections
+ * rarely have data for more than one or two callbacks (typically one each
+ * from the object and debug formats), so that is the initial allocation.
+ */
+#define ASSOC_DATA_INITIAL_ALLOC    2
+
 struct yasm__assoc_data {
-    assoc_data_item *vector;
     size_t size;
     size_t alloc;
+    assoc_data_item vector[ASSOC_DATA_INITIAL_ALLOC];   /* actually alloc */
 };
 
+#define ASSOC_DATA_ALLOC_SIZE(alloc) \
+    (sizeof(yasm__assoc_data) + \
+     ((alloc)-ASSOC_DATA_INITIAL_ALLOC)*sizeof(assoc_data_item))
+
 
 yasm__assoc_data *
 yasm__assoc_data_create(void)
 {
-    yasm__assoc_data *assoc_data = yasm_xmalloc(sizeof(yasm__assoc_data));
+    yasm__assoc_data *assoc_data =
+        yasm_xmalloc(ASSOC_DATA_ALLOC_SIZE(ASSOC_DATA_INITIAL_ALLOC));
 
     assoc_data->size = 0;
-    assoc_data->alloc = 2;
-    assoc_data->vector = yasm_xmalloc(assoc_data->alloc *
-                                      sizeof(assoc_data_item));
+    assoc_data->alloc = ASSOC_DATA_INITIAL_ALLOC;
 
     return assoc_data;
 }
@@ -93,16 +102,15 @@ yasm__assoc_data_add(yasm__assoc_data *assoc_data_arg,
         }
     }
 
-    /* No?  Then append a new one */
+    /* No?  Then append a new one (moving the container if it must grow) */
     if (!item) {
-        assoc_data->size++;
-        if (assoc_data->size > assoc_data->alloc) {
+        if (assoc_data->size == assoc_data->alloc) {
             assoc_data->alloc *= 2;
-            assoc_data->vector =
-                yasm_xrealloc(assoc_data->vector,
-                              assoc_data->alloc * sizeof(assoc_data_item));
+            assoc_data =
+                yasm_xrealloc(assoc_data,
+                              ASSOC_DATA_ALLOC_SIZE(assoc_data->alloc));
         }
-        item = &assoc_data->vector[assoc_data->size-1];
+        item = &assoc_data->vector[assoc_data->size++];
         item->callback = callback;
         item->data = NULL;
     }
@@ -126,7 +134,6 @@ yasm__assoc_data_destroy(yasm__assoc_data *assoc_data)
 
     for (i=0; i<assoc_data->size; i++)
         assoc_data->vector[i].callback->destroy(assoc_data->vector[i].data);
-    yasm_xfree(assoc_data->vector);
     yasm_xfree(assoc_data);
 }
 
@@ -56,6 +56,8 @@ YASM_LIB_DECL
  * \param assoc_data    container of associated data
  * \param callback      callback
  * \param data          data to associate
+ * \return Container with data added; may differ from assoc_data (which is
+ *         then no longer valid).
  */
 YASM_LIB_DECL
 /*@only@*/ yasm__assoc_data *yasm__assoc_data_add
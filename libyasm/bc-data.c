@@ -61,6 +61,17 @@ typedef struct bytecode_data {
     yasm_datavalhead datahead;
 
     int item_size;
+
+    /* allocated size of the last dataval's raw contents when it has been
+     * grown by yasm_bc_data_merge(), 0 if allocated to exact length.
+     */
+    unsigned long raw_alloc;
+
+    /* lines of the (non-empty) data lines merged in by yasm_bc_data_merge(),
+     * in order; the bytecode's own line comes before them.
+     */
+    /*@null@*/ /*@only@*/ unsigned long *merged_lines;
+    unsigned long num_merged, merged_alloc;
 } bytecode_data;
 
 static void bc_data_destroy(void *contents);
@@ -91,6 +102,8 @@ bc_data_destroy(void *contents)
 {
     bytecode_data *bc_data = (bytecode_data *)contents;
     yasm_dvs_delete(&bc_data->datahead);
+    if (bc_data->merged_lines)
+        yasm_xfree(bc_data->merged_lines);
     yasm_xfree(contents);
 }
 
@@ -259,95 +272,78 @@ bc_data_tobytes(yasm_bytecode *bc, unsigned char **bufp,
     return 0;
 }
 
+/* Reserve len more bytes at the end of the raw dataval currently being
+ * built by yasm_bc_create_data(), starting a new one if needed.  The raw
+ * contents are grown geometrically; *allocp tracks the allocated size.
+ */
+static unsigned char *
+bc_data_raw_reserve(yasm_datavalhead *headp, yasm_dataval **rawp,
+                    unsigned long *allocp, unsigned long len)
+{
+    yasm_dataval *raw = *rawp;
+    unsigned char *ptr;
+
+    if (!raw) {
+        *allocp = len < 16 ? 16 : len;
+        raw = yasm_dv_create_raw(yasm_xmalloc(*allocp), 0);
+        STAILQ_INSERT_TAIL(headp, raw, link);
+        *rawp = raw;
+    } else if (raw->data.raw.len + len > *allocp) {
+        while (raw->data.raw.len + len > *allocp)
+            *allocp *= 2;
+        raw->data.raw.contents = yasm_xrealloc(raw->data.raw.contents,
+                                               *allocp);
+    }
+
+    ptr = &raw->data.raw.contents[raw->data.raw.len];
+    raw->data.raw.len += len;
+    return ptr;
+}
+
+/* Finish the raw dataval currently being built, trimming its contents. */
+static void
+bc_data_raw_flush(yasm_dataval **rawp, unsigned long alloc)
+{
+    yasm_dataval *raw = *rawp;
+
+    if (raw && raw->data.raw.len > 0 && raw->data.raw.len < alloc)
+        raw->data.raw.contents = yasm_xrealloc(raw->data.raw.contents,
+                                               raw->data.raw.len);
+    *rawp = NULL;
+}
+
 yasm_bytecode *
 yasm_bc_create_data(yasm_datavalhead *datahead, unsigned int size,
                     int append_zero, yasm_arch *arch, unsigned long line)
 {
     bytecode_data *data = yasm_xmalloc(sizeof(bytecode_data));
     yasm_bytecode *bc = yasm_bc_create_common(&bc_data_callback, data, line);
-    yasm_dataval *dv, *dv2, *dvo;
+    yasm_dataval *dv, *dvnext, *raw = NULL;
     yasm_intnum *intn;
-    unsigned long len = 0, rlen, i;
-
+    unsigned char *ptr;
+    unsigned long alloc = 0, rlen;
+    int keep, sign;
 
     yasm_dvs_initialize(&data->datahead);
     data->item_size = size;
-
-    /* Prescan input data for length, etc.  Careful: this needs to be
-     * precisely paired with the second loop.
+    data->raw_alloc = 0;
+    data->merged_lines = NULL;
+    data->num_merged = 0;
+    data->merged_alloc = 0;
+
+    /* Convert input data in a single pass.  Runs of constant data are
+     * packed into one raw dataval as they are seen; only values that are
+     * not yet constant (e.g. contain symbols) stay values, and those reuse
+     * their input dataval.  All other input datavals are freed.
      */
-    STAILQ_FOREACH(dv, datahead, link) {
-        if (dv->multiple && dv->type != DV_EMPTY && len > 0) {
-            /* Flush previous data */
-            dvo = yasm_dv_create_raw(yasm_xmalloc(len), len);
-            STAILQ_INSERT_TAIL(&data->datahead, dvo, link);
-            len = 0;
-        }
-        switch (dv->type) {
-            case DV_EMPTY:
-                break;
-            case DV_VALUE:
-            case DV_ULEB128:
-            case DV_SLEB128:
-                intn = yasm_expr_get_intnum(&dv->data.val.abs, 0);
-                if (intn && dv->type == DV_VALUE && (arch || size == 1))
-                    len += size;
-                else if (intn && dv->type == DV_ULEB128)
-                    len += yasm_intnum_size_leb128(intn, 0);
-                else if (intn && dv->type == DV_SLEB128)
-                    len += yasm_intnum_size_leb128(intn, 1);
-                else {
-                    if (len > 0) {
-                        /* Create bytecode for all previous len */
-                        dvo = yasm_dv_create_raw(yasm_xmalloc(len), len);
-                        STAILQ_INSERT_TAIL(&data->datahead, dvo, link);
-                        len = 0;
-                    }
-
-                    /* Create bytecode for this value */
-                    dvo = yasm_xmalloc(sizeof(yasm_dataval));
-                    STAILQ_INSERT_TAIL(&data->datahead, dvo, link);
-                    dvo->multiple = dv->multiple;
-                }
-                break;
-            case DV_RAW:
-                rlen = dv->data.raw.len;
-                /* find count, rounding up to nearest multiple of size */
-                rlen = (rlen + size - 1) / size;
-                len += rlen*size;
-                break;
-            case DV_RESERVE:
-                len += size;
-                break;
-        }
+    for (dv = STAILQ_FIRST(datahead); dv; dv = dvnext) {
+        dvnext = STAILQ_NEXT(dv, link);
+        keep = 0;
 
-        if (dv->multiple && dv->type != DV_EMPTY && len > 0) {
-            /* Flush this data */
-            dvo = yasm_dv_create_raw(yasm_xmalloc(len), len);
-            STAILQ_INSERT_TAIL(&data->datahead, dvo, link);
-            dvo->multiple = dv->multiple;
-            len = 0;
-        }
+        /* Data with a multiple gets its own dataval */
+        if (dv->multiple && dv->type != DV_EMPTY)
+            bc_data_raw_flush(&raw, alloc);
 
-        if (append_zero)
-            len++;
-    }
-
-    /* Create final dataval for any trailing length */
-    if (len > 0) {
-        dvo = yasm_dv_create_raw(yasm_xmalloc(len), len);
-        STAILQ_INSERT_TAIL(&data->datahead, dvo, link);
-    }
-
-    /* Second iteration: copy data and delete input datavals. */
-    dv = STAILQ_FIRST(datahead);
-    dvo = STAILQ_FIRST(&data->datahead);
-    len = 0;
-    while (dv && dvo) {
-        if (dv->multiple && dv->type != DV_EMPTY && len > 0) {
-            dvo = STAILQ_NEXT(dvo, link);
-            len = 0;
-        }
         switch (dv->type) {
             case DV_EMPTY:
                 break;
@@ -356,71 +352,147 @@ yasm_bc_create_data(yasm_datavalhead *datahead, unsigned int size,
             case DV_SLEB128:
                 intn = yasm_expr_get_intnum(&dv->data.val.abs, 0);
                 if (intn && dv->type == DV_VALUE && (arch || size == 1)) {
+                    ptr = bc_data_raw_reserve(&data->datahead, &raw, &alloc,
+                                              size);
                     if (size == 1)
-                        yasm_intnum_get_sized(intn,
-                                              &dvo->data.raw.contents[len],
-                                              1, 8, 0, 0, 1);
+                        yasm_intnum_get_sized(intn, ptr, 1, 8, 0, 0, 1);
                     else
-                        yasm_arch_intnum_tobytes(arch, intn,
-                                                 &dvo->data.raw.contents[len],
-                                                 size, size*8, 0, bc, 1);
-                    yasm_value_delete(&dv->data.val);
-                    len += size;
-                } else if (intn && dv->type == DV_ULEB128) {
-                    len += yasm_intnum_get_leb128(intn,
-                                                  &dvo->data.raw.contents[len],
-                                                  0);
+                        yasm_arch_intnum_tobytes(arch, intn, ptr, size,
+                                                 size*8, 0, bc, 1);
                     yasm_value_delete(&dv->data.val);
-                } else if (intn && dv->type == DV_SLEB128) {
-                    len += yasm_intnum_get_leb128(intn,
-                                                  &dvo->data.raw.contents[len],
-                                                  1);
+                } else if (intn && dv->type != DV_VALUE) {
+                    sign = dv->type == DV_SLEB128;
+                    ptr = bc_data_raw_reserve(&data->datahead, &raw, &alloc,
+                        yasm_intnum_size_leb128(intn, sign));
+                    yasm_intnum_get_leb128(intn, ptr, sign);
                     yasm_value_delete(&dv->data.val);
                 } else {
-                    if (len > 0)
-                        dvo = STAILQ_NEXT(dvo, link);
-                    dvo->type = dv->type;
-                    dvo->data.val = dv->data.val;   /* structure copy */
-                    dvo->data.val.size = size*8;    /* remember size */
-                    dvo = STAILQ_NEXT(dvo, link);
-                    len = 0;
+                    /* Keep this value (and its multiple) as-is */
+                    bc_data_raw_flush(&raw, alloc);
+                    dv->data.val.size = size*8;     /* remember size */
+                    STAILQ_INSERT_TAIL(&data->datahead, dv, link);
+                    keep = 1;
                 }
                 break;
             case DV_RAW:
                 rlen = dv->data.raw.len;
-                memcpy(&dvo->data.raw.contents[len], dv->data.raw.contents,
-                       rlen);
-                yasm_xfree(dv->data.raw.contents);
-                len += rlen;
                 /* pad with 0's to nearest multiple of size */
-                rlen %= size;
+                if (size > 1)
+                    rlen = (rlen + size - 1) / size * size;
                 if (rlen > 0) {
-                    rlen = size-rlen;
-                    for (i=0; i<rlen; i++)
-                        dvo->data.raw.contents[len++] = 0;
+                    ptr = bc_data_raw_reserve(&data->datahead, &raw, &alloc,
+                                              rlen);
+                    memcpy(ptr, dv->data.raw.contents, dv->data.raw.len);
+                    memset(ptr + dv->data.raw.len, 0,
+                           rlen - dv->data.raw.len);
                 }
+                yasm_xfree(dv->data.raw.contents);
                 break;
             case DV_RESERVE:
-                memset(&dvo->data.raw.contents[len], 0, size);
-                len += size;
+                ptr = bc_data_raw_reserve(&data->datahead, &raw, &alloc, size);
+                memset(ptr, 0, size);
                 break;
         }
 
-        if (dv->multiple && dv->type != DV_EMPTY && len > 0) {
-            dvo = STAILQ_NEXT(dvo, link);
-            len = 0;
+        if (!keep && dv->multiple) {
+            if (dv->type != DV_EMPTY && raw) {
+                raw->multiple = dv->multiple;
+                bc_data_raw_flush(&raw, alloc);
+            } else
+                yasm_expr_destroy(dv->multiple);
         }
 
         if (append_zero)
-            dvo->data.raw.contents[len++] = 0;
-        dv2 = STAILQ_NEXT(dv, link);
-        yasm_xfree(dv);
-        dv = dv2;
+            *bc_data_raw_reserve(&data->datahead, &raw, &alloc, 1) = 0;
+
+        if (!keep)
+            yasm_xfree(dv);
     }
 
+    /* Finish any trailing raw data */
+    bc_data_raw_flush(&raw, alloc);
+
     return bc;
 }
 
+int
+yasm_bc_data_merge(yasm_bytecode *prevbc, yasm_bytecode *bc)
+{
+    bytecode_data *prev_data, *bc_data;
+    yasm_dataval *dv, *last;
+    unsigned long len, total = 0;
+
+    if (!prevbc || prevbc->callback != &bc_data_callback
+        || bc->callback != &bc_data_callback || prevbc->pos_ref
+        || prevbc->multiple || bc->multiple)
+        return 0;
+
+    prev_data = (bytecode_data *)prevbc->contents;
+    bc_data = (bytecode_data *)bc->contents;
+    if (prev_data->item_size != bc_data->item_size
+        || STAILQ_EMPTY(&prev_data->datahead))
+        return 0;
+
+    STAILQ_FOREACH(dv, &bc_data->datahead, link) {
+        if (dv->type != DV_RAW || dv->multiple)
+            return 0;
+        total += dv->data.raw.len;
+    }
+
+    /* Remember the line for diagnostics about the merged data */
+    if (total > 0) {
+        if (prev_data->num_merged >= prev_data->merged_alloc) {
+            prev_data->merged_alloc = prev_data->merged_alloc ?
+                2*prev_data->merged_alloc : 16;
+            prev_data->merged_lines =
+                yasm_xrealloc(prev_data->merged_lines,
+                              prev_data->merged_alloc*sizeof(unsigned long));
+        }
+        prev_data->merged_lines[prev_data->num_merged++] = bc->line;
+    }
+
+    while ((dv = STAILQ_FIRST(&bc_data->datahead))) {
+        STAILQ_REMOVE_HEAD(&bc_data->datahead, link);
+        last = STAILQ_LAST(&prev_data->datahead, yasm_dataval, link);
+        if (!last || last->type != DV_RAW || last->multiple) {
+            STAILQ_INSERT_TAIL(&prev_data->datahead, dv, link);
+            prev_data->raw_alloc = 0;
+            continue;
+        }
+
+        /* Append to the previous raw data, growing it geometrically */
+        len = last->data.raw.len + dv->data.raw.len;
+        if (len > prev_data->raw_alloc) {
+            prev_data->raw_alloc = len < 2*last->data.raw.len ?
+                2*last->data.raw.len : len;
+            last->data.raw.contents =
+                yasm_xrealloc(last->data.raw.contents, prev_data->raw_alloc);
+        }
+        memcpy(&last->data.raw.contents[last->data.raw.len],
+               dv->data.raw.contents, dv->data.raw.len);
+        last->data.raw.len = len;
+        yasm_xfree(dv->data.raw.contents);
+        yasm_xfree(dv);
+    }
+
+    yasm_bc_destroy(bc);
+    return 1;
+}
+
+const unsigned long *
+yasm_bc_data_merged_lines(const yasm_bytecode *bc, unsigned long *num)
+{
+    const bytecode_data *bc_data;
+
+    if (bc->callback != &bc_data_callback) {
+        *num = 0;
+        return NULL;
+    }
+    bc_data = (const bytecode_data *)bc->contents;
+    *num = bc_data->num_merged;
+    return bc_data->merged_lines;
+}
+
 yasm_bytecode *
 yasm_bc_create_leb128(yasm_datavalhead *datahead, int sign, unsigned long line)
 {
@@ -106,6 +106,7 @@ yasm_bc_create_common(const yasm_bytecode_callback *callback, void *contents,
     bc->line = line;
     bc->offset = ~0UL;  /* obviously incorrect / uninitialized value */
     bc->symrecs = NULL;
+    bc->pos_ref = 0;
     bc->contents = contents;
 
     return bc;
@@ -223,6 +223,11 @@ struct yasm_bytecode {
      */
     /*@null@*/ yasm_symrec **symrecs;
 
+    /** Nonzero if a label or current position symbol refers to the end of
+     * this bytecode, which then must not move (see yasm_bc_data_merge()).
+     */
+    int pos_ref;
+
     /** Implementation-specific data (type identified by callback). */
     void *contents;
 };
@@ -310,6 +315,36 @@ YASM_LIB_DECL
     (yasm_datavalhead *datahead, unsigned int size, int append_zero,
      /*@null@*/ yasm_arch *arch, unsigned long line);
 
+/** Merge a data bytecode into the data bytecode preceding it.  Only done if
+ * \a bc consists solely of constant data, neither bytecode has a multiple,
+ * both have the same item size, \a prevbc isn't empty, and no symbol
+ * references \a prevbc (so its end position may move).  This lets long runs
+ * of constant data directives share a single bytecode instead of keeping
+ * one bytecode per line.  The line of \a bc is kept (see
+ * yasm_bc_data_merged_lines()) so that diagnostics about the data can
+ * still be reported for each line.
+ * \param prevbc        preceding bytecode (last bytecode of the section)
+ * \param bc            data bytecode (not yet appended to a section)
+ * \return Nonzero if \a bc was merged into \a prevbc and destroyed, 0 if the
+ *         bytecodes were left unchanged.
+ */
+YASM_LIB_DECL
+int yasm_bc_data_merge(/*@null@*/ yasm_bytecode *prevbc, yasm_bytecode *bc);
+
+/** Get the lines of the data merged into a data bytecode by
+ * yasm_bc_data_merge().  A diagnostic that applies to all of a data
+ * bytecode's contents (not just to its first line) should be reported at
+ * each of these lines as well as at the bytecode's own line.  Lines whose
+ * data was empty are not included.
+ * \param bc           bytecode
+ * \param num          number of lines (output)
+ * \return Lines in source order, or NULL if there are none (including when
+ *         \a bc is not a data bytecode).
+ */
+YASM_LIB_DECL
+/*@null@*/ const unsigned long *yasm_bc_data_merged_lines
+    (const yasm_bytecode *bc, /*@out@*/ unsigned long *num);
+
 /** Create a bytecode containing LEB128-encoded data value(s).
  * \param datahead      list of data values (kept, do not free)
  * \param sign          signedness (1=signed, 0=unsigned) of each data value
@@ -29,50 +29,97 @@
 #include <libyasm.h>
 
 
-typedef struct loaded_module {
-    const char *keyword;            /* module keyword */
-    void *data;                     /* associated data */
-} loaded_module;
-
-static HAMT *loaded_modules[] = {NULL, NULL, NULL, NULL, NULL, NULL};
-
-static void
-load_module_destroy(/*@only@*/ void *data)
+/* Tables of modules registered with yasm_register_module_table(), most
+ * recently registered last.  Each is sorted by type and then keyword, so it
+ * is searched in place without building anything at startup.
+ */
+typedef struct module_table {
+    const yasm_module_entry *entries;
+    size_t n;
+} module_table;
+
+static module_table *module_tables = NULL;
+static size_t num_module_tables = 0;
+
+/* Modules registered one at a time with yasm_register_module() */
+static yasm_module_entry *loaded_modules = NULL;
+static size_t num_loaded_modules = 0;
+
+/* Find keyword of the given type in a sorted table. */
+static /*@null@*/ const yasm_module_entry *
+table_search(const module_table *table, yasm_module_type type,
+             const char *keyword)
 {
-    /* do nothing */
+    size_t lo = 0, hi = table->n;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const yasm_module_entry *e = &table->entries[mid];
+        int cmp;
+
+        if (e->type != type)
+            cmp = e->type < type ? -1 : 1;
+        else
+            cmp = yasm__strcasecmp(e->keyword, keyword);
+        if (cmp == 0)
+            return e;
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return NULL;
 }
 
 void *
 yasm_load_module(yasm_module_type type, const char *keyword)
 {
-    if (!loaded_modules[type])
-        return NULL;
-    return HAMT_search(loaded_modules[type], keyword);
+    size_t i;
+
+    /* Later registrations override earlier ones */
+    for (i=num_loaded_modules; i>0; i--) {
+        if (loaded_modules[i-1].type == type &&
+            yasm__strcasecmp(loaded_modules[i-1].keyword, keyword) == 0)
+            return loaded_modules[i-1].data;
+    }
+
+    for (i=num_module_tables; i>0; i--) {
+        const yasm_module_entry *e =
+            table_search(&module_tables[i-1], type, keyword);
+        if (e)
+            return e->data;
+    }
+
+    return NULL;
 }
 
 void
 yasm_register_module(yasm_module_type type, const char *keyword, void *data)
 {
-    int replace = 1;
-
-    assert(type < sizeof(loaded_modules));
-
-    if (!loaded_modules[type])
-        loaded_modules[type] = HAMT_create(1, yasm_internal_error_);
-
-    HAMT_insert(loaded_modules[type], keyword, data, &replace,
-                load_module_destroy);
+    loaded_modules =
+        yasm_xrealloc(loaded_modules,
+                      (num_loaded_modules+1)*sizeof(yasm_module_entry));
+    loaded_modules[num_loaded_modules].type = type;
+    loaded_modules[num_loaded_modules].keyword = keyword;
+    loaded_modules[num_loaded_modules].data = data;
+    num_loaded_modules++;
 }
 
-typedef struct {
-    yasm_module_type type;
-    void (*printfunc) (const char *name, const char *keyword);
-} list_one_data;
+void
+yasm_register_module_table(const yasm_module_entry *table, size_t n)
+{
+    module_tables =
+        yasm_xrealloc(module_tables,
+                      (num_module_tables+1)*sizeof(module_table));
+    module_tables[num_module_tables].entries = table;
+    module_tables[num_module_tables].n = n;
+    num_module_tables++;
+}
 
-static int
-yasm_list_one_module(void *node, void *d)
+static void
+yasm_list_one_module(yasm_module_type type, void *data,
+                     void (*printfunc) (const char *name, const char *keyword))
 {
-    list_one_data *data = (list_one_data *)d;
     yasm_arch_module *arch;
     yasm_dbgfmt_module *dbgfmt;
     yasm_objfmt_module *objfmt;
@@ -80,47 +127,50 @@ yasm_list_one_module(void *node, void *d)
     yasm_parser_module *parser;
     yasm_preproc_module *preproc;
 
-    switch (data->type) {
+    switch (type) {
         case YASM_MODULE_ARCH:
-            arch = node;
-            data->printfunc(arch->name, arch->keyword);
+            arch = data;
+            printfunc(arch->name, arch->keyword);
             break;
         case YASM_MODULE_DBGFMT:
-            dbgfmt = node;
-            data->printfunc(dbgfmt->name, dbgfmt->keyword);
+            dbgfmt = data;
+            printfunc(dbgfmt->name, dbgfmt->keyword);
             break;
         case YASM_MODULE_OBJFMT:
-            objfmt = node;
-            data->printfunc(objfmt->name, objfmt->keyword);
+            objfmt = data;
+            printfunc(objfmt->name, objfmt->keyword);
             break;
         case YASM_MODULE_LISTFMT:
-            listfmt = node;
-            data->printfunc(listfmt->name, listfmt->keyword);
+            listfmt = data;
+            printfunc(listfmt->name, listfmt->keyword);
             break;
         case YASM_MODULE_PARSER:
-            parser = node;
-            data->printfunc(parser->name, parser->keyword);
+            parser = data;
+            printfunc(parser->name, parser->keyword);
             break;
         case YASM_MODULE_PREPROC:
-            preproc = node;
-            data->printfunc(preproc->name, preproc->keyword);
+            preproc = data;
+            printfunc(preproc->name, preproc->keyword);
             break;
     }
-    return 0;
 }
 
 void
 yasm_list_modules(yasm_module_type type,
                   void (*printfunc) (const char *name, const char *keyword))
 {
-    list_one_data data;
-
-    /* Go through available list, and try to load each one */
-    if (!loaded_modules[type])
-        return;
-
-    data.type = type;
-    data.printfunc = printfunc;
+    size_t i, j;
+
+    for (i=0; i<num_module_tables; i++) {
+        for (j=0; j<module_tables[i].n; j++) {
+            if (module_tables[i].entries[j].type == type)
+                yasm_list_one_module(type, module_tables[i].entries[j].data,
+                                     printfunc);
+        }
+    }
 
-    HAMT_traverse(loaded_modules[type], &data, yasm_list_one_module);
+    for (i=0; i<num_loaded_modules; i++) {
+        if (loaded_modules[i].type == type)
+            yasm_list_one_module(type, loaded_modules[i].data, printfunc);
+    }
 }
@@ -33,6 +33,7 @@
 
 #include "linemap.h"
 #include "errwarn.h"
+#include "hamt.h"
 
 
 #define MSG_MAXSIZE     1024
@@ -74,8 +75,6 @@ static STAILQ_HEAD(warn_head, warn) yasm_warns;
 static unsigned long warn_class_enabled;
 
 typedef struct errwarn_data {
-    /*@reldef@*/ SLIST_ENTRY(errwarn_data) link;
-
     enum { WE_UNKNOWN, WE_ERROR, WE_WARNING, WE_PARSERERROR } type;
 
     unsigned long line;
@@ -84,8 +83,28 @@ typedef struct errwarn_data {
     /*@owned@*/ char *xrefmsg;
 } errwarn_data;
 
+/* Count of identical messages, for limiting repeats */
+typedef struct errwarn_repeat {
+    int is_error;               /* error (vs warning) message */
+    /*@owned@*/ char *msg;      /* message text (also the HAMT key) */
+    unsigned long count;        /* number of times message propagated */
+    unsigned long line;         /* virtual line of last one kept */
+} errwarn_repeat;
+
 struct yasm_errwarns {
-    /*@reldef@*/ SLIST_HEAD(errwarn_head, errwarn_data) errwarns;
+    /* Errors and warnings in the order propagated.  Generally each phase of
+     * assembly adds them in line order, so they are only sorted (once) when
+     * output.
+     */
+    /*@owned@*/ /*@null@*/ errwarn_data *we;
+    size_t num_we;
+    size_t size_we;
+
+    /* Nonzero if we[] is known to be in line order */
+    int sorted;
+
+    /* Number of WE_PARSERERROR entries in we[] */
+    unsigned long num_parsererrors;
 
     /* Total error count */
     unsigned int ecount;
@@ -93,8 +112,25 @@ struct yasm_errwarns {
     /* Total warning count */
     unsigned int wcount;
 
-    /* Last inserted error/warning.  Used to speed up insertions. */
-    /*@null@*/ errwarn_data *previous_we;
+    /* If nonzero, "warnings being treated as errors" has been output */
+    int werror_noted;
+
+    /* Streaming output (see yasm_errwarns_stream()); stream_lm is NULL if
+     * not streaming.  When streaming, we[] holds at most the one most recent
+     * entry, as it may still be overwritten by a following error.
+     */
+    /*@null@*/ /*@dependent@*/ yasm_linemap *stream_lm;
+    int stream_warning_as_error;
+    /*@null@*/ yasm_print_error_func stream_print_error;
+    /*@null@*/ yasm_print_warning_func stream_print_warning;
+
+    /* Repeat limiting (see yasm_errwarns_set_max_repeat()); 0=unlimited */
+    unsigned long max_repeat;
+    /*@null@*/ /*@owned@*/ HAMT *repeat_errors;
+    /*@null@*/ /*@owned@*/ HAMT *repeat_warnings;
+    /* All repeat counts, in first-propagated order */
+    /*@null@*/ /*@owned@*/ errwarn_repeat **repeats;
+    size_t num_repeats;
 };
 
 /* Static buffer for use by conv_unprint(). */
@@ -183,67 +219,167 @@ def_fatal(const char *fmt, va_list va)
     exit(EXIT_FAILURE);
 }
 
-/* Create an errwarn structure in the correct linked list location.
- * If replace_parser_error is nonzero, overwrites the last error if its
- * type is WE_PARSERERROR.
+/* Find the error/warning an entry for line would follow once sorted, and
+ * return it if it has type WE_PARSERERROR (so should be overwritten by a new
+ * error on line), otherwise NULL.
  */
-static errwarn_data *
-errwarn_data_new(yasm_errwarns *errwarns, unsigned long line,
-                 int replace_parser_error)
+static /*@null@*/ errwarn_data *
+errwarn_find_parser_error(yasm_errwarns *errwarns, unsigned long line)
 {
-    errwarn_data *first, *next, *ins_we, *we;
-    enum { INS_NONE, INS_HEAD, INS_AFTER } action = INS_NONE;
+    errwarn_data *prev = NULL;
+    size_t i;
 
-    /* Find the entry with either line=line or the last one with line<line.
-     * Start with the last entry added to speed the search.
+    /* Parser errors only occur while parsing, when lines increase, so
+     * searching is rarely needed.
      */
-    ins_we = errwarns->previous_we;
-    first = SLIST_FIRST(&errwarns->errwarns);
-    if (!ins_we || !first)
-        action = INS_HEAD;
-    while (action == INS_NONE) {
-        next = SLIST_NEXT(ins_we, link);
-        if (line < ins_we->line) {
-            if (ins_we == first)
-                action = INS_HEAD;
-            else
-                ins_we = first;
-        } else if (!next)
-            action = INS_AFTER;
-        else if (line >= ins_we->line && line < next->line)
-            action = INS_AFTER;
-        else
-            ins_we = next;
+    if (errwarns->num_parsererrors == 0 || errwarns->num_we == 0)
+        return NULL;
+
+    if (errwarns->sorted && errwarns->we[errwarns->num_we-1].line <= line)
+        prev = &errwarns->we[errwarns->num_we-1];
+    else {
+        /* Last entry with the greatest line <= line */
+        for (i=0; i<errwarns->num_we; i++) {
+            if (errwarns->we[i].line <= line &&
+                (!prev || errwarns->we[i].line >= prev->line))
+                prev = &errwarns->we[i];
+        }
     }
 
-    if (replace_parser_error && ins_we && ins_we->type == WE_PARSERERROR) {
-        /* overwrite last error */
-        we = ins_we;
-    } else {
-        /* add a new error */
-        we = yasm_xmalloc(sizeof(errwarn_data));
-
-        we->type = WE_UNKNOWN;
-        we->line = line;
-        we->xrefline = 0;
-        we->msg = NULL;
-        we->xrefmsg = NULL;
-
-        if (action == INS_HEAD)
-            SLIST_INSERT_HEAD(&errwarns->errwarns, we, link);
-        else if (action == INS_AFTER) {
-            assert(ins_we != NULL);
-            SLIST_INSERT_AFTER(ins_we, we, link);
-        } else
-            yasm_internal_error(N_("Unexpected errwarn insert action"));
+    if (prev && prev->type == WE_PARSERERROR)
+        return prev;
+    return NULL;
+}
+
+static void
+errwarn_output(yasm_errwarns *errwarns, const errwarn_data *we,
+               yasm_linemap *lm, int warning_as_error,
+               yasm_print_error_func print_error,
+               yasm_print_warning_func print_warning)
+{
+    const char *filename, *xref_filename;
+    unsigned long line, xref_line;
+
+    yasm_linemap_lookup(lm, we->line, &filename, &line);
+    if (we->xrefline)
+        yasm_linemap_lookup(lm, we->xrefline, &xref_filename, &xref_line);
+    else {
+        xref_filename = NULL;
+        xref_line = 0;
+    }
+    if (we->type == WE_ERROR || we->type == WE_PARSERERROR)
+        print_error(filename, line, we->msg, xref_filename, xref_line,
+                    we->xrefmsg);
+    else {
+        print_warning(filename, line, we->msg);
+
+        /* If we're treating warnings as errors, tell the user about it. */
+        if (warning_as_error && !errwarns->werror_noted) {
+            const char *msg =
+                yasm_gettext_hook(N_("warnings being treated as errors"));
+            print_error(filename, line, msg, NULL, 0, NULL);
+            errwarns->werror_noted = 1;
+        }
+    }
+}
+
+/* Output and delete all held errors/warnings in the order propagated. */
+static void
+errwarn_flush_stream(yasm_errwarns *errwarns)
+{
+    size_t i;
+
+    for (i=0; i<errwarns->num_we; i++) {
+        errwarn_data *we = &errwarns->we[i];
+        errwarn_output(errwarns, we, errwarns->stream_lm,
+                       errwarns->stream_warning_as_error,
+                       errwarns->stream_print_error,
+                       errwarns->stream_print_warning);
+        yasm_xfree(we->msg);
+        if (we->xrefmsg)
+            yasm_xfree(we->xrefmsg);
+    }
+    errwarns->num_we = 0;
+    errwarns->num_parsererrors = 0;
+    errwarns->sorted = 1;
+}
+
+/* Add a new, empty, error/warning. */
+static errwarn_data *
+errwarn_data_new(yasm_errwarns *errwarns, unsigned long line)
+{
+    errwarn_data *we;
+
+    if (errwarns->stream_lm)
+        errwarn_flush_stream(errwarns);
+
+    if (errwarns->num_we >= errwarns->size_we) {
+        errwarns->size_we = errwarns->size_we ? errwarns->size_we*2 : 16;
+        errwarns->we = yasm_xrealloc(errwarns->we,
+                                     errwarns->size_we*sizeof(errwarn_data));
     }
 
-    /* Remember previous err/warn */
-    errwarns->previous_we = we;
+    if (errwarns->num_we > 0 && line < errwarns->we[errwarns->num_we-1].line)
+        errwarns->sorted = 0;
 
+    we = &errwarns->we[errwarns->num_we++];
+    we->type = WE_UNKNOWN;
+    we->line = line;
+    we->xrefline = 0;
+    we->msg = NULL;
+    we->xrefmsg = NULL;
     return we;
 }
 
+static void
+errwarn_repeat_destroy(/*@only@*/ void *data)
+{
+    errwarn_repeat *rep = (errwarn_repeat *)data;
+    yasm_xfree(rep->msg);
+    yasm_xfree(rep);
+}
+
+/* Count a message, returning nonzero if it has been seen more than the
+ * maximum number of times and should not be kept.
+ */
+static int
+errwarn_repeated(yasm_errwarns *errwarns, int is_error, const char *msg,
+                 unsigned long line)
+{
+    HAMT **table;
+    errwarn_repeat *rep;
+
+    if (errwarns->max_repeat == 0)
+        return 0;
+
+    table = is_error ? &errwarns->repeat_errors : &errwarns->repeat_warnings;
+    if (!*table)
+        *table = HAMT_create(0, yasm_internal_error_);
+
+    rep = HAMT_search(*table, msg);
+    if (!rep) {
+        int replace = 0;
+
+        rep = yasm_xmalloc(sizeof(errwarn_repeat));
+        rep->is_error = is_error;
+        rep->msg = yasm__xstrdup(msg);
+        rep->count = 0;
+        rep->line = line;
+        HAMT_insert(*table, rep->msg, rep, &replace, errwarn_repeat_destroy);
+
+        errwarns->repeats =
+            yasm_xrealloc(errwarns->repeats,
+                          (errwarns->num_repeats+1)*sizeof(errwarn_repeat *));
+        errwarns->repeats[errwarns->num_repeats++] = rep;
+    }
+
+    rep->count++;
+    if (rep->count > errwarns->max_repeat)
+        return 1;
+    rep->line = line;
+    return 0;
+}
+
 void
 yasm_error_clear(void)
 {
@@ -420,56 +556,122 @@ yasm_errwarns *
 yasm_errwarns_create(void)
 {
     yasm_errwarns *errwarns = yasm_xmalloc(sizeof(yasm_errwarns));
-    SLIST_INIT(&errwarns->errwarns);
+    errwarns->we = NULL;
+    errwarns->num_we = 0;
+    errwarns->size_we = 0;
+    errwarns->sorted = 1;
+    errwarns->num_parsererrors = 0;
     errwarns->ecount = 0;
     errwarns->wcount = 0;
-    errwarns->previous_we = NULL;
+    errwarns->werror_noted = 0;
+    errwarns->stream_lm = NULL;
+    errwarns->stream_warning_as_error = 0;
+    errwarns->stream_print_error = NULL;
+    errwarns->stream_print_warning = NULL;
+    errwarns->max_repeat = 0;
+    errwarns->repeat_errors = NULL;
+    errwarns->repeat_warnings = NULL;
+    errwarns->repeats = NULL;
+    errwarns->num_repeats = 0;
     return errwarns;
 }
 
 void
 yasm_errwarns_destroy(yasm_errwarns *errwarns)
 {
-    errwarn_data *we;
+    size_t i;
 
     /* Delete all error/warnings */
-    while (!SLIST_EMPTY(&errwarns->errwarns)) {
-        we = SLIST_FIRST(&errwarns->errwarns);
-        if (we->msg)
-            yasm_xfree(we->msg);
-        if (we->xrefmsg)
-            yasm_xfree(we->xrefmsg);
-
-        SLIST_REMOVE_HEAD(&errwarns->errwarns, link);
-        yasm_xfree(we);
+    for (i=0; i<errwarns->num_we; i++) {
+        if (errwarns->we[i].msg)
+            yasm_xfree(errwarns->we[i].msg);
+        if (errwarns->we[i].xrefmsg)
+            yasm_xfree(errwarns->we[i].xrefmsg);
     }
+    if (errwarns->we)
+        yasm_xfree(errwarns->we);
+
+    if (errwarns->repeat_errors)
+        HAMT_destroy(errwarns->repeat_errors, errwarn_repeat_destroy);
+    if (errwarns->repeat_warnings)
+        HAMT_destroy(errwarns->repeat_warnings, errwarn_repeat_destroy);
+    if (errwarns->repeats)
+        yasm_xfree(errwarns->repeats);
 
     yasm_xfree(errwarns);
 }
 
+void
+yasm_errwarns_stream(yasm_errwarns *errwarns, yasm_linemap *lm,
+                     int warning_as_error,
+                     yasm_print_error_func print_error,
+                     yasm_print_warning_func print_warning)
+{
+    errwarns->stream_lm = lm;
+    errwarns->stream_warning_as_error = warning_as_error;
+    errwarns->stream_print_error = print_error;
+    errwarns->stream_print_warning = print_warning;
+}
+
+void
+yasm_errwarns_set_max_repeat(yasm_errwarns *errwarns, unsigned long max)
+{
+    errwarns->max_repeat = max;
+}
+
 void
 yasm_errwarn_propagate(yasm_errwarns *errwarns, unsigned long line)
 {
     if (yasm_eclass != YASM_ERROR_NONE) {
-        errwarn_data *we = errwarn_data_new(errwarns, line, 1);
+        errwarn_data *we;
         yasm_error_class eclass;
+        char *msg, *xrefmsg;
+        unsigned long xrefline;
 
-        yasm_error_fetch(&eclass, &we->msg, &we->xrefline, &we->xrefmsg);
-        if (eclass != YASM_ERROR_GENERAL
-            && (eclass & YASM_ERROR_PARSE) == YASM_ERROR_PARSE)
-            we->type = WE_PARSERERROR;
-        else
-            we->type = WE_ERROR;
+        yasm_error_fetch(&eclass, &msg, &xrefline, &xrefmsg);
         errwarns->ecount++;
+
+        we = errwarn_find_parser_error(errwarns, line);
+        if (we) {
+            /* overwrite last error */
+            yasm_xfree(we->msg);
+            if (we->xrefmsg)
+                yasm_xfree(we->xrefmsg);
+            errwarns->num_parsererrors--;
+        } else if (errwarn_repeated(errwarns, 1, msg, line)) {
+            yasm_xfree(msg);
+            if (xrefmsg)
+                yasm_xfree(xrefmsg);
+        } else
+            we = errwarn_data_new(errwarns, line);
+
+        if (we) {
+            we->msg = msg;
+            we->xrefline = xrefline;
+            we->xrefmsg = xrefmsg;
+            if (eclass != YASM_ERROR_GENERAL
+                && (eclass & YASM_ERROR_PARSE) == YASM_ERROR_PARSE) {
+                we->type = WE_PARSERERROR;
+                errwarns->num_parsererrors++;
+            } else
+                we->type = WE_ERROR;
+        }
     }
 
     while (!STAILQ_EMPTY(&yasm_warns)) {
-        errwarn_data *we = errwarn_data_new(errwarns, line, 0);
         yasm_warn_class wclass;
+        char *msg;
 
-        yasm_warn_fetch(&wclass, &we->msg);
-        we->type = WE_WARNING;
+        yasm_warn_fetch(&wclass, &msg);
         errwarns->wcount++;
+
+        if (errwarn_repeated(errwarns, 0, msg, line))
+            yasm_xfree(msg);
+        else {
+            errwarn_data *we = errwarn_data_new(errwarns, line);
+            we->msg = msg;
+            we->type = WE_WARNING;
+        }
     }
 }
 
@@ -482,41 +684,61 @@ yasm_errwarns_num_errors(yasm_errwarns *errwarns, int warning_as_error)
         return errwarns->ecount;
 }
 
+static int
+errwarn_data_compare(const void *a, const void *b)
+{
+    const errwarn_data *we_a = (const errwarn_data *)a;
+    const errwarn_data *we_b = (const errwarn_data *)b;
+
+    if (we_a->line < we_b->line)
+        return -1;
+    if (we_a->line > we_b->line)
+        return 1;
+    return 0;
+}
+
 void
 yasm_errwarns_output_all(yasm_errwarns *errwarns, yasm_linemap *lm,
                          int warning_as_error,
                          yasm_print_error_func print_error,
                          yasm_print_warning_func print_warning)
 {
-    errwarn_data *we;
-    const char *filename, *xref_filename;
-    unsigned long line, xref_line;
+    size_t i;
+
+    /* Sort by line; the sort is stable, so errors/warnings on the same line
+     * stay in the order they were propagated.
+     */
+    if (!errwarns->sorted) {
+        yasm__mergesort(errwarns->we, errwarns->num_we, sizeof(errwarn_data),
+                        errwarn_data_compare);
+        errwarns->sorted = 1;
+    }
 
     /* Output error/warnings. */
-    SLIST_FOREACH(we, &errwarns->errwarns, link) {
-        /* Output error/warning */
-        yasm_linemap_lookup(lm, we->line, &filename, &line);
-        if (we->xrefline)
-            yasm_linemap_lookup(lm, we->xrefline, &xref_filename, &xref_line);
-        else {
-            xref_filename = NULL;
-            xref_line = 0;
-        }
-        if (we->type == WE_ERROR || we->type == WE_PARSERERROR)
-            print_error(filename, line, we->msg, xref_filename, xref_line,
-                        we->xrefmsg);
+    for (i=0; i<errwarns->num_we; i++)
+        errwarn_output(errwarns, &errwarns->we[i], lm, warning_as_error,
+                       print_error, print_warning);
+
+    /* Summarize messages not kept due to the repeat limit. */
+    for (i=0; i<errwarns->num_repeats; i++) {
+        errwarn_repeat *rep = errwarns->repeats[i];
+        const char *fmt;
+        char *msg;
+        const char *filename;
+        unsigned long line;
+
+        if (rep->count <= errwarns->max_repeat)
+            continue;
+
+        fmt = yasm_gettext_hook(N_("%s (repeated %lu more times)"));
+        msg = yasm_xmalloc(strlen(fmt)+strlen(rep->msg)+32);
+        sprintf(msg, fmt, rep->msg, rep->count-errwarns->max_repeat);
+        yasm_linemap_lookup(lm, rep->line, &filename, &line);
+        if (rep->is_error)
+            print_error(filename, line, msg, NULL, 0, NULL);
         else
-        {
-            print_warning(filename, line, we->msg);
-
-            /* If we're treating warnings as errors, tell the user about it. */
-            if (warning_as_error && warning_as_error != 2) {
-                const char *msg =
-                    yasm_gettext_hook(N_("warnings being treated as errors"));
-                print_error(filename, line, msg, NULL, 0, NULL);
-                warning_as_error = 2;
-            }
-        }
+            print_warning(filename, line, msg);
+        yasm_xfree(msg);
     }
 }
 
@@ -278,8 +278,8 @@ void yasm_errwarns_destroy(/*@only@*/ yasm_errwarns *errwarns);
 
 /** Propagate error indicator and warning indicator(s) to an error/warning set.
  * Has no effect if the error indicator and warning indicator are not set.
- * Does not print immediately; yasm_errwarn_output_all() outputs
- * accumulated errors and warnings.
+ * Does not print immediately (unless streaming, see yasm_errwarns_stream());
+ * yasm_errwarn_output_all() outputs accumulated errors and warnings.
  * Generally multiple errors on the same line will be reported, but errors
  * of class YASM_ERROR_PARSE will get overwritten by any other class on the
  * same line.
@@ -319,7 +319,37 @@ typedef void (*yasm_print_error_func)
 typedef void (*yasm_print_warning_func)
     (const char *fn, unsigned long line, const char *msg);
 
+/** Output errors and warnings as they are propagated to an error/warning set,
+ * in the order they occur, rather than sorted by line when
+ * yasm_errwarns_output_all() is called.  The most recent error/warning is
+ * held back until the next one is propagated (as it may be overwritten by
+ * an error on the same line) or yasm_errwarns_output_all() is called.
+ * \param errwarns          error/warning set
+ * \param lm    line map (to convert virtual lines into filename/line pairs)
+ * \param warning_as_error  if nonzero, treat warnings as errors.
+ * \param print_error       function called to print out errors
+ * \param print_warning     function called to print out warnings
+ */
+YASM_LIB_DECL
+void yasm_errwarns_stream
+    (yasm_errwarns *errwarns, yasm_linemap *lm, int warning_as_error,
+     yasm_print_error_func print_error, yasm_print_warning_func print_warning);
+
+/** Limit the number of times an identical error or warning message is kept
+ * (and output).  Further occurrences are only counted, and the count is
+ * output once by yasm_errwarns_output_all(), after all other errors and
+ * warnings.  Repeated messages still count towards
+ * yasm_errwarns_num_errors().
+ * \param errwarns  error/warning set
+ * \param max       maximum number of times to keep each message
+ *                  (0=unlimited, the default)
+ */
+YASM_LIB_DECL
+void yasm_errwarns_set_max_repeat(yasm_errwarns *errwarns, unsigned long max);
+
 /** Outputs error/warning set in sorted order (sorted by virtual line number).
+ * When streaming, only outputs any held back error/warning.  In either case,
+ * then outputs counts of messages not kept due to the repeat limit.
  * \param errwarns          error/warning set
  * \param lm    line map (to convert virtual lines into filename/line pairs)
  * \param warning_as_error  if nonzero, treat warnings as errors.
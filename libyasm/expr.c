@@ -807,6 +807,34 @@ typedef struct yasm__exprentry {
     /*@null@*/ const yasm_expr *e;
 } yasm__exprentry;
 
+/* Returns nonzero if e consists only of integer terms (at any depth), and
+ * thus will level down to a single intnum regardless of context.
+ */
+static int
+expr_is_const_tree(const yasm_expr *e)
+{
+    int i;
+    for (i=0; i<e->numterms; i++) {
+        switch (e->terms[i].type) {
+            case YASM_EXPR_INT:
+                break;
+            case YASM_EXPR_EXPR:
+                if (!expr_is_const_tree(e->terms[i].data.expn))
+                    return 0;
+                break;
+            default:
+                return 0;
+        }
+    }
+    return 1;
+}
+
+static yasm_expr *
+expr_level_tree(yasm_expr *e, int fold_const, int simplify_ident,
+                int simplify_reg_mul, int calc_bc_dist,
+                yasm_expr_xform_func expr_xform_extra,
+                void *expr_xform_extra_data);
+
 static yasm_expr *
 expr_expand_equ(yasm_expr *e, yasm__exprhead *eh)
 {
@@ -820,8 +848,17 @@ expr_expand_equ(yasm_expr *e, yasm__exprhead *eh)
         /* Expand equ's. */
         if (e->terms[i].type == YASM_EXPR_SYM &&
             (equ_expr = yasm_symrec_get_equ(e->terms[i].data.sym))) {
+            yasm_symrec *sym = e->terms[i].data.sym;
+            const yasm_intnum *equ_intn = yasm_symrec__get_equ_intnum(sym);
             yasm__exprentry *np;
 
+            /* Constant equ's already folded on an earlier use. */
+            if (equ_intn) {
+                e->terms[i].type = YASM_EXPR_INT;
+                e->terms[i].data.intn = yasm_intnum_copy(equ_intn);
+                continue;
+            }
+
             /* Check for circular reference */
             SLIST_FOREACH(np, eh, next) {
                 if (np->e == equ_expr) {
@@ -839,6 +876,21 @@ expr_expand_equ(yasm_expr *e, yasm__exprhead *eh)
             SLIST_INSERT_HEAD(eh, &ee, next);
             e->terms[i].data.expn = expr_expand_equ(e->terms[i].data.expn, eh);
             SLIST_REMOVE_HEAD(eh, next);
+
+            /* If the fully expanded equ is constant, fold it now and cache
+             * the result in the symbol so later uses need not copy and
+             * re-fold the equ's expression tree.
+             */
+            if (!yasm_error_occurred() &&
+                expr_is_const_tree(e->terms[i].data.expn)) {
+                yasm_expr *sube = expr_level_tree(e->terms[i].data.expn, 1, 1,
+                                                  1, 0, NULL, NULL);
+                e->terms[i].data.expn = sube;
+                if (!yasm_error_occurred() && sube->op == YASM_EXPR_IDENT &&
+                    sube->terms[0].type == YASM_EXPR_INT)
+                    yasm_symrec__set_equ_intnum(sym,
+                        yasm_intnum_copy(sube->terms[0].data.intn));
+            }
         } else if (e->terms[i].type == YASM_EXPR_EXPR)
             /* Recurse */
             e->terms[i].data.expn = expr_expand_equ(e->terms[i].data.expn, eh);
@@ -1262,6 +1314,11 @@ yasm_expr_extract_wrt(yasm_expr **ep)
 yasm_intnum *
 yasm_expr_get_intnum(yasm_expr **ep, int calc_bc_dist)
 {
+    /* Plain integers (e.g. most data values) need no simplification */
+    if (*ep && (*ep)->op == YASM_EXPR_IDENT &&
+        (*ep)->terms[0].type == YASM_EXPR_INT)
+        return (*ep)->terms[0].data.intn;
+
     *ep = yasm_expr_simplify(*ep, calc_bc_dist);
 
     if (*ep && (*ep)->op == YASM_EXPR_IDENT && (*ep)->terms[0].type == YASM_EXPR_INT)
@@ -43,11 +43,16 @@
 #include <sys/stat.h>
 #endif
 
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+
 #include <ctype.h>
 #include <errno.h>
 
 #include "errwarn.h"
 #include "file.h"
+#include "hamt.h"
 
 #define BSIZE   8192        /* Fill block size */
 
@@ -534,44 +539,282 @@ typedef struct incpath {
 
 STAILQ_HEAD(incpath_head, incpath) incpaths = STAILQ_HEAD_INITIALIZER(incpaths);
 
+static /*@null@*/ yasm_fopen_hook_func fopen_hook = NULL;
+static /*@null@*/ void *fopen_hook_data = NULL;
+
+void
+yasm_set_fopen_hook(yasm_fopen_hook_func hook, void *d)
+{
+    fopen_hook = hook;
+    fopen_hook_data = d;
+}
+
+void
+yasm_get_fopen_hook(yasm_fopen_hook_func *hook, void **d)
+{
+    *hook = fopen_hook;
+    *d = fopen_hook_data;
+}
+
 FILE *
-yasm_fopen_include(const char *iname, const char *from, const char *mode,
-                   char **oname)
+yasm_fopen_source(const char *filename, const char *mode)
+{
+    if (fopen_hook) {
+        FILE *f = fopen_hook(filename, mode, fopen_hook_data);
+        if (f)
+            return f;
+    }
+    if (strcmp(filename, "-") == 0)
+        return stdin;
+    return fopen(filename, mode);
+}
+
+/* Include resolution cache.  Builds commonly pass many include paths, and
+ * the same files are looked up repeatedly (each %include of a common file,
+ * and incbin files at each optimizer and output pass), so remember where each
+ * (including directory, name) pair was found, or that it wasn't.  The cache
+ * lasts (as do the directory listings below) until the include paths change,
+ * and is bypassed while an fopen hook is set, as the hook may supply files
+ * that aren't on disk.
+ */
+typedef struct include_result {
+    /*@owned@*/ char *key;              /* HAMT key */
+    /*@null@*/ /*@owned@*/ char *path;  /* pathname found; NULL if none */
+} include_result;
+
+static /*@null@*/ /*@only@*/ HAMT *include_results = NULL;
+
+/* Directory listings, so that include paths not containing a file can be
+ * skipped without trying to open it there.
+ */
+typedef struct include_dir {
+    /*@owned@*/ char *path;             /* HAMT key */
+    enum {
+        INCDIR_UNKNOWN = 0,     /* couldn't list; must try opening */
+        INCDIR_LISTED,          /* names holds all entries */
+        INCDIR_MISSING          /* doesn't exist; nothing can be opened */
+    } state;
+    /*@null@*/ /*@only@*/ HAMT *names;
+} include_dir;
+
+static /*@null@*/ /*@only@*/ HAMT *include_dirs = NULL;
+
+static void
+include_result_delete(/*@only@*/ void *data)
+{
+    include_result *result = (include_result *)data;
+    yasm_xfree(result->key);
+    if (result->path)
+        yasm_xfree(result->path);
+    yasm_xfree(result);
+}
+
+static void
+include_dir_delete(/*@only@*/ void *data)
+{
+    include_dir *dir = (include_dir *)data;
+    yasm_xfree(dir->path);
+    if (dir->names)
+        HAMT_destroy(dir->names, yasm_xfree);
+    yasm_xfree(dir);
+}
+
+static void
+include_cache_clear(void)
+{
+    if (include_results) {
+        HAMT_destroy(include_results, include_result_delete);
+        include_results = NULL;
+    }
+    if (include_dirs) {
+        HAMT_destroy(include_dirs, include_dir_delete);
+        include_dirs = NULL;
+    }
+}
+
+/* Read the listing of a directory (an empty string for the current one). */
+static /*@dependent@*/ include_dir *
+include_dir_get(const char *path)
+{
+    include_dir *dir;
+    int replace = 0;
+#ifdef HAVE_DIRENT_H
+    DIR *d;
+    struct dirent *de;
+#endif
+
+    if (!include_dirs)
+        include_dirs = HAMT_create(0, yasm_internal_error_);
+    dir = HAMT_search(include_dirs, path);
+    if (dir)
+        return dir;
+
+    dir = yasm_xmalloc(sizeof(include_dir));
+    dir->path = yasm__xstrdup(path);
+    dir->state = INCDIR_UNKNOWN;
+    dir->names = NULL;
+
+#ifdef HAVE_DIRENT_H
+    d = opendir(path[0] == '\0' ? "." : path);
+    if (d) {
+        /* Case-insensitive, so that names are never wrongly missed on
+         * case-insensitive filesystems; a false match just costs an open.
+         */
+        dir->names = HAMT_create(1, yasm_internal_error_);
+        while ((de = readdir(d)) != NULL) {
+            char *name = yasm__xstrdup(de->d_name);
+            replace = 0;
+            HAMT_insert(dir->names, name, name, &replace, yasm_xfree);
+        }
+        closedir(d);
+        dir->state = INCDIR_LISTED;
+    } else if (errno == ENOENT || errno == ENOTDIR)
+        dir->state = INCDIR_MISSING;
+#endif
+
+    replace = 0;
+    HAMT_insert(include_dirs, dir->path, dir, &replace, include_dir_delete);
+    return dir;
+}
+
+/* Returns nonzero if pathname might exist (and so is worth opening). */
+static int
+include_may_exist(const char *pathname)
+{
+    const char *tail, *c;
+    size_t headlen;
+    char *head;
+    include_dir *dir;
+    int exists = 1;
+
+    headlen = yasm__splitpath(pathname, &tail);
+
+    /* Only ASCII names can be reliably matched case-insensitively */
+    for (c = tail; *c != '\0'; c++) {
+        if ((unsigned char)*c >= 0x80)
+            return 1;
+    }
+
+    head = yasm_xmalloc(headlen+1);
+    memcpy(head, pathname, headlen);
+    head[headlen] = '\0';
+    dir = include_dir_get(head);
+    yasm_xfree(head);
+
+    if (dir->state == INCDIR_MISSING)
+        exists = 0;
+    else if (dir->state == INCDIR_LISTED && tail[0] != '\0')
+        exists = HAMT_search(dir->names, tail) != NULL;
+    return exists;
+}
+
+/* Try to open iname relative to dir, if it might exist there. */
+static /*@null@*/ FILE *
+include_try(const char *dir, const char *iname, const char *mode,
+            /*@out@*/ char **oname)
+{
+    FILE *f = NULL;
+    char *combine = yasm__combpath(dir, iname);
+
+    if (fopen_hook || include_may_exist(combine))
+        f = yasm_fopen_source(combine, mode);
+    if (f)
+        *oname = combine;
+    else
+        yasm_xfree(combine);
+    return f;
+}
+
+static /*@null@*/ FILE *
+include_search(const char *iname, const char *from, const char *mode,
+               /*@out@*/ char **oname)
 {
     FILE *f;
-    char *combine;
     incpath *np;
 
     /* Try directly relative to from first, then each of the include paths */
     if (from) {
-        combine = yasm__combpath(from, iname);
-        f = fopen(combine, mode);
-        if (f) {
-            if (oname)
-                *oname = combine;
-            else
-                yasm_xfree(combine);
+        f = include_try(from, iname, mode, oname);
+        if (f)
             return f;
-        }
-        yasm_xfree(combine);
     }
 
     STAILQ_FOREACH(np, &incpaths, link) {
-        combine = yasm__combpath(np->path, iname);
-        f = fopen(combine, mode);
-        if (f) {
-            if (oname)
-                *oname = combine;
-            else
-                yasm_xfree(combine);
+        f = include_try(np->path, iname, mode, oname);
+        if (f)
             return f;
+    }
+
+    *oname = NULL;
+    return NULL;
+}
+
+FILE *
+yasm_fopen_include(const char *iname, const char *from, const char *mode,
+                   char **oname)
+{
+    FILE *f = NULL;
+    char *combine;
+    char *key;
+    const char *tail;
+    size_t fromlen = 0;
+    include_result *result;
+    int replace = 1;
+
+    if (fopen_hook) {
+        f = include_search(iname, from, mode, &combine);
+        if (oname)
+            *oname = combine;
+        else if (combine)
+            yasm_xfree(combine);
+        return f;
+    }
+
+    /* Results depend on the directory of from (not its filename) and iname;
+     * the key is prefixed by that directory's length to keep them apart.
+     */
+    if (from)
+        fromlen = yasm__splitpath(from, &tail);
+    key = yasm_xmalloc(fromlen+strlen(iname)+24);
+    if (from) {
+        sprintf(key, "%lu:", (unsigned long)fromlen);
+        strncat(key, from, fromlen);
+    } else
+        strcpy(key, "-:");
+    strcat(key, iname);
+
+    if (!include_results)
+        include_results = HAMT_create(0, yasm_internal_error_);
+    result = HAMT_search(include_results, key);
+    if (result) {
+        /* Not found before, so won't be now */
+        if (!result->path) {
+            yasm_xfree(key);
+            if (oname)
+                *oname = NULL;
+            return NULL;
         }
-        yasm_xfree(combine);
+        f = fopen(result->path, mode);
+        if (f)
+            combine = yasm__xstrdup(result->path);
     }
 
+    /* Not looked up yet (or no longer openable where found before) */
+    if (!f) {
+        f = include_search(iname, from, mode, &combine);
+        result = yasm_xmalloc(sizeof(include_result));
+        result->key = key;
+        result->path = combine ? yasm__xstrdup(combine) : NULL;
+        HAMT_insert(include_results, key, result, &replace,
+                    include_result_delete);
+    } else
+        yasm_xfree(key);
+
     if (oname)
-        *oname = NULL;
-    return NULL;
+        *oname = combine;
+    else if (combine)
+        yasm_xfree(combine);
+    return f;
 }
 
 void
@@ -587,6 +830,7 @@ yasm_delete_include_paths(void)
         n1 = n2;
     }
     STAILQ_INIT(&incpaths);
+    include_cache_clear();
 }
 
 const char *
@@ -621,6 +865,12 @@ yasm_add_include_path(const char *path)
     }
 
     STAILQ_INSERT_TAIL(&incpaths, np, link);
+
+    /* Files not found before may now be found in the new path.  Start over
+     * on the directory listings too, as in a long-running process they may
+     * be out of date by now.
+     */
+    include_cache_clear();
 }
 
 size_t
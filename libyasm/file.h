@@ -210,6 +210,14 @@ size_t yasm__createpath_common(const char *path, int win);
  * is saved into oname, and the fopen'ed FILE * is returned.  If not found,
  * NULL is returned.
  *
+ * Where each file was found (or that it was not found) is remembered until
+ * the include paths are changed, so files should not be created or deleted
+ * while they may be included.  Directories are listed (once) to avoid trying
+ * to open files in directories that don't contain them; the listings are
+ * also dropped when the include paths change.  A long-running process that
+ * assembles several times should therefore reset the include paths (with
+ * yasm_delete_include_paths()) between runs.
+ *
  * \param iname     file to include
  * \param from      file doing the including
  * \param mode      fopen mode string
@@ -222,6 +230,43 @@ YASM_LIB_DECL
     (const char *iname, const char *from, const char *mode,
      /*@null@*/ /*@out@*/ /*@only@*/ char **oname);
 
+/** Function that opens source files in place of the filesystem.
+ * \param filename  pathname of file to open
+ * \param mode      fopen mode string
+ * \param d         data pointer passed to yasm_set_fopen_hook()
+ * \return Opened file, or NULL to open filename from the filesystem instead.
+ */
+typedef /*@null@*/ FILE * (*yasm_fopen_hook_func)
+    (const char *filename, const char *mode, /*@null@*/ void *d);
+
+/** Set the function used by yasm_fopen_source() (and thus by
+ * yasm_fopen_include()) to open files before trying the filesystem.
+ * \param hook      hook function, or NULL to use only the filesystem
+ * \param d         data pointer to pass to hook
+ */
+YASM_LIB_DECL
+void yasm_set_fopen_hook(/*@null@*/ yasm_fopen_hook_func hook,
+                         /*@null@*/ void *d);
+
+/** Get the hook currently set with yasm_set_fopen_hook(), e.g. to restore
+ * it after temporarily replacing it.
+ * \param hook      hook function (output, NULL if none)
+ * \param d         data pointer passed to hook (output)
+ */
+YASM_LIB_DECL
+void yasm_get_fopen_hook(/*@out@*/ yasm_fopen_hook_func *hook,
+                         /*@out@*/ void **d);
+
+/** Open a source file.  Preprocessors use this to open their initial input
+ * file so that it may be supplied by the hook set with yasm_set_fopen_hook().
+ * A filename of "-" not supplied by the hook is standard input.
+ * \param filename  pathname of file to open
+ * \param mode      fopen mode string
+ * \return Opened file, or NULL if it could not be opened.
+ */
+YASM_LIB_DECL
+/*@null@*/ FILE *yasm_fopen_source(const char *filename, const char *mode);
+
 /** Delete any stored include paths added by yasm_add_include_path().
  */
 YASM_LIB_DECL
@@ -67,9 +67,19 @@ struct yasm_floatnum {
 /* Flag settings for flags field */
 #define FLAG_ISZERO     1<<0
 
-/* Note this structure integrates the floatnum structure */
+/* All arithmetic on mantissas is done on fixed-size arrays of 16-bit words
+ * (least significant word first) held in unsigned longs, so that products
+ * of two words and a carry never overflow and no BitVectors need to be
+ * allocated.  The results are identical to doing the same operations on
+ * MANT_BITS-bit BitVectors.
+ */
+#define MANT_WORDS      (MANT_BITS/16)
+
+typedef unsigned long mantissa_t[MANT_WORDS];
+
 typedef struct POT_Entry_s {
-    yasm_floatnum f;
+    mantissa_t mantissa;
+    unsigned short exponent;
     int dec_exponent;
 } POT_Entry;
 
@@ -89,7 +99,7 @@ typedef struct POT_Entry_Source_s {
  * entry[12-n] = 10 ** (-2 ** n) for 0 <= n <= 12.
  * entry[13] = 1.0
  */
-static /*@only@*/ POT_Entry *POT_TableN;
+static POT_Entry POT_TableN[14];
 static POT_Entry_Source POT_TableN_Source[] = {
     {{0xe3,0x2d,0xde,0x9f,0xce,0xd2,0xc8,0x04,0xdd,0xa6},0x4ad8}, /* 1e-4096 */
     {{0x25,0x49,0xe4,0x2d,0x36,0x34,0x4f,0x53,0xae,0xce},0x656b}, /* 1e-2048 */
@@ -117,7 +127,8 @@ static POT_Entry_Source POT_TableN_Source[] = {
  * before the table.  This -1 entry is created at runtime by duplicating the
  * 0 entry.
  */
-static /*@only@*/ POT_Entry *POT_TableP;
+static POT_Entry POT_TableP_Entries[15];    /* note 1 extra for -1 */
+static /*@dependent@*/ POT_Entry *POT_TableP;
 static POT_Entry_Source POT_TableP_Source[] = {
     {{0x4c,0xc9,0x9a,0x97,0x20,0x8a,0x02,0x52,0x60,0xc4},0xb525}, /* 1e+4096 */
     {{0x4d,0xa7,0xe4,0x5d,0x3d,0xc5,0x5d,0x3b,0x8b,0x9e},0x9a92}, /* 1e+2048 */
@@ -139,21 +150,18 @@ static POT_Entry_Source POT_TableP_Source[] = {
 static void
 POT_Table_Init_Entry(/*@out@*/ POT_Entry *e, POT_Entry_Source *s, int dec_exp)
 {
+    int i;
+
     /* Save decimal exponent */
     e->dec_exponent = dec_exp;
 
     /* Initialize mantissa */
-    e->f.mantissa = BitVector_Create(MANT_BITS, FALSE);
-    BitVector_Block_Store(e->f.mantissa, s->mantissa, MANT_BYTES);
+    for (i=0; i<MANT_WORDS; i++)
+        e->mantissa[i] = ((unsigned long)s->mantissa[2*i+1] << 8)
+            | s->mantissa[2*i];
 
     /* Initialize exponent */
-    e->f.exponent = s->exponent;
-
-    /* Set sign to 0 (positive) */
-    e->f.sign = 0;
-
-    /* Clear flags */
-    e->f.flags = 0;
+    e->exponent = s->exponent;
 }
 
 /*@-compdef@*/
@@ -165,9 +173,7 @@ yasm_floatnum_initialize(void)
     int dec_exp = 1;
     int i;
 
-    /* Allocate space for two POT tables */
-    POT_TableN = yasm_xmalloc(14*sizeof(POT_Entry));
-    POT_TableP = yasm_xmalloc(15*sizeof(POT_Entry)); /* note 1 extra for -1 */
+    POT_TableP = POT_TableP_Entries;
 
     /* Initialize entry[0..12] */
     for (i=12; i>=0; i--) {
@@ -191,93 +197,144 @@ yasm_floatnum_initialize(void)
 /*@-globstate@*/
 void
 yasm_floatnum_cleanup(void)
+{
+    /* The POT tables are static; nothing to free. */
+    POT_TableP = NULL;
+}
+/*@=globstate@*/
+
+/* Returns the index of the highest set bit in the nwords-word number m,
+ * or -1 if m is zero.
+ */
+static long
+words_max_bit(const unsigned long *m, int nwords)
 {
     int i;
+    long bit;
+    unsigned long w;
+
+    for (i=nwords-1; i>=0; i--) {
+        if (m[i] == 0)
+            continue;
+        bit = (long)i*16;
+        for (w = m[i] >> 1; w != 0; w >>= 1)
+            bit++;
+        return bit;
+    }
+    return -1;
+}
 
-    /* Un-offset POT_TableP */
-    POT_TableP--;
+/* m <<= amt, for the nwords-word number m; bits shifted off the top are
+ * lost.
+ */
+static void
+words_shift_left(unsigned long *m, int nwords, long amt)
+{
+    int wshift = (int)(amt/16), bshift = (int)(amt%16);
+    int i;
 
-    for (i=0; i<14; i++) {
-        BitVector_Destroy(POT_TableN[i].f.mantissa);
-        BitVector_Destroy(POT_TableP[i].f.mantissa);
+    if (amt <= 0)
+        return;
+    for (i=nwords-1; i>=0; i--) {
+        unsigned long w = 0;
+        if (i-wshift >= 0)
+            w = m[i-wshift] << bshift;
+        if (bshift != 0 && i-wshift-1 >= 0)
+            w |= m[i-wshift-1] >> (16-bshift);
+        m[i] = w & 0xFFFF;
     }
-    BitVector_Destroy(POT_TableP[14].f.mantissa);
+}
+
+/* Returns the 16 bits of the nwords-word number m starting at bit. */
+static unsigned long
+words_get16(const unsigned long *m, int nwords, long bit)
+{
+    int w = (int)(bit/16), s = (int)(bit%16);
+    unsigned long v = m[w] >> s;
 
-    yasm_xfree(POT_TableN);
-    yasm_xfree(POT_TableP);
+    if (s != 0 && w+1 < nwords)
+        v |= m[w+1] << (16-s);
+    return v & 0xFFFF;
+}
+
+static int
+mantissa_is_empty(const mantissa_t m)
+{
+    int i;
+    for (i=0; i<MANT_WORDS; i++) {
+        if (m[i] != 0)
+            return 0;
+    }
+    return 1;
 }
-/*@=globstate@*/
 
 static void
-floatnum_normalize(yasm_floatnum *flt)
+floatnum_normalize(mantissa_t mant, unsigned short *exponent)
 {
     long norm_amt;
 
-    if (BitVector_is_empty(flt->mantissa)) {
-        flt->exponent = 0;
+    if (mantissa_is_empty(mant)) {
+        *exponent = 0;
         return;
     }
 
     /* Look for the highest set bit, shift to make it the MSB, and adjust
      * exponent.  Don't let exponent go negative. */
-    norm_amt = (MANT_BITS-1)-Set_Max(flt->mantissa);
-    if (norm_amt > (long)flt->exponent)
-        norm_amt = (long)flt->exponent;
-    BitVector_Move_Left(flt->mantissa, (N_int)norm_amt);
-    flt->exponent -= (unsigned short)norm_amt;
+    norm_amt = (MANT_BITS-1)-words_max_bit(mant, MANT_WORDS);
+    if (norm_amt > (long)*exponent)
+        norm_amt = (long)*exponent;
+    words_shift_left(mant, MANT_WORDS, norm_amt);
+    *exponent -= (unsigned short)norm_amt;
 }
 
-/* acc *= op */
+/* acc *= op (the sign is handled by the caller, POT entries are positive) */
 static void
-floatnum_mul(yasm_floatnum *acc, const yasm_floatnum *op)
+floatnum_mul(mantissa_t acc, unsigned short *acc_exponent, const POT_Entry *op)
 {
     long expon;
-    wordptr product, op1, op2;
+    unsigned long product[MANT_WORDS*2];
     long norm_amt;
-
-    /* Compute the new sign */
-    acc->sign ^= op->sign;
+    int i, j;
 
     /* Check for multiply by 0 */
-    if (BitVector_is_empty(acc->mantissa) || BitVector_is_empty(op->mantissa)) {
-        BitVector_Empty(acc->mantissa);
-        acc->exponent = EXP_ZERO;
+    if (mantissa_is_empty(acc) || mantissa_is_empty(op->mantissa)) {
+        memset(acc, 0, sizeof(mantissa_t));
+        *acc_exponent = EXP_ZERO;
         return;
     }
 
     /* Add exponents, checking for overflow/underflow. */
-    expon = (((int)acc->exponent)-EXP_BIAS) + (((int)op->exponent)-EXP_BIAS);
+    expon = (((int)*acc_exponent)-EXP_BIAS) + (((int)op->exponent)-EXP_BIAS);
     expon += EXP_BIAS;
     if (expon > EXP_MAX) {
         /* Overflow; return infinity. */
-        BitVector_Empty(acc->mantissa);
-        acc->exponent = EXP_INF;
+        memset(acc, 0, sizeof(mantissa_t));
+        *acc_exponent = EXP_INF;
         return;
     } else if (expon < EXP_MIN) {
         /* Underflow; return zero. */
-        BitVector_Empty(acc->mantissa);
-        acc->exponent = EXP_ZERO;
+        memset(acc, 0, sizeof(mantissa_t));
+        *acc_exponent = EXP_ZERO;
         return;
     }
 
     /* Add one to the final exponent, as the multiply shifts one extra time. */
-    acc->exponent = (unsigned short)(expon+1);
-
-    /* Allocate space for the multiply result */
-    product = BitVector_Create((N_int)((MANT_BITS+1)*2), FALSE);
-
-    /* Allocate 1-bit-longer fields to force the operands to be unsigned */
-    op1 = BitVector_Create((N_int)(MANT_BITS+1), FALSE);
-    op2 = BitVector_Create((N_int)(MANT_BITS+1), FALSE);
+    *acc_exponent = (unsigned short)(expon+1);
 
-    /* Make the operands unsigned after copying from original operands */
-    BitVector_Copy(op1, acc->mantissa);
-    BitVector_MSB(op1, 0);
-    BitVector_Copy(op2, op->mantissa);
-    BitVector_MSB(op2, 0);
-
-    /* Compute the product of the mantissas */
-    BitVector_Multiply(product, op1, op2);
+    /* Compute the product of the mantissas.  Each column sum (product of
+     * two 16-bit words plus a 16-bit partial result plus a 16-bit carry)
+     * fits in 32 bits.
+     */
+    memset(product, 0, sizeof(product));
+    for (i=0; i<MANT_WORDS; i++) {
+        unsigned long carry = 0;
+        for (j=0; j<MANT_WORDS; j++) {
+            unsigned long t = acc[i]*op->mantissa[j] + product[i+j] + carry;
+            product[i+j] = t & 0xFFFF;
+            carry = t >> 16;
+        }
+        product[i+MANT_WORDS] = carry;
+    }
 
     /* Normalize the product.  Note: we know the product is non-zero because
      * both of the original operands were non-zero.
@@ -285,39 +342,57 @@ floatnum_mul(yasm_floatnum *acc, const yasm_floatnum *op)
      * Look for the highest set bit, shift to make it the MSB, and adjust
      * exponent.  Don't let exponent go negative.
      */
-    norm_amt = (MANT_BITS*2-1)-Set_Max(product);
-    if (norm_amt > (long)acc->exponent)
-        norm_amt = (long)acc->exponent;
-    BitVector_Move_Left(product, (N_int)norm_amt);
-    acc->exponent -= (unsigned short)norm_amt;
+    norm_amt = (MANT_BITS*2-1)-words_max_bit(product, MANT_WORDS*2);
+    if (norm_amt > (long)*acc_exponent)
+        norm_amt = (long)*acc_exponent;
+    words_shift_left(product, MANT_WORDS*2, norm_amt);
+    *acc_exponent -= (unsigned short)norm_amt;
 
     /* Store the highest bits of the result */
-    BitVector_Interval_Copy(acc->mantissa, product, 0, MANT_BITS, MANT_BITS);
+    memcpy(acc, &product[MANT_WORDS], sizeof(mantissa_t));
+}
+
+/* mant = mant*10 + digit (modulo 2^MANT_BITS) */
+static void
+mantissa_mul10_add(mantissa_t mant, unsigned int digit)
+{
+    unsigned long carry = digit;
+    int i;
+
+    for (i=0; i<MANT_WORDS; i++) {
+        unsigned long t = mant[i]*10 + carry;
+        mant[i] = t & 0xFFFF;
+        carry = t >> 16;
+    }
+}
 
-    /* Free allocated variables */
-    BitVector_Destroy(product);
-    BitVector_Destroy(op1);
-    BitVector_Destroy(op2);
+/* Loads the mantissa of flt into mant. */
+static void
+floatnum_load_mantissa(const yasm_floatnum *flt, /*@out@*/ mantissa_t mant)
+{
+    int i;
+    for (i=0; i<MANT_WORDS; i++)
+        mant[i] = (unsigned long)BitVector_Chunk_Read(flt->mantissa, 16,
+                                                      (N_int)(i*16));
 }
 
 yasm_floatnum *
 yasm_floatnum_create(const char *str)
 {
     yasm_floatnum *flt;
+    mantissa_t mant;
     int dec_exponent, dec_exp_add;      /* decimal (powers of 10) exponent */
     int POT_index;
-    wordptr operand[2];
     int sig_digits;
     int decimal_pt;
-    boolean carry;
+    int i;
 
     flt = yasm_xmalloc(sizeof(yasm_floatnum));
 
     flt->mantissa = BitVector_Create(MANT_BITS, TRUE);
 
-    /* allocate and initialize calculation variables */
-    operand[0] = BitVector_Create(MANT_BITS, TRUE);
-    operand[1] = BitVector_Create(MANT_BITS, TRUE);
+    /* initialize calculation variables */
+    memset(mant, 0, sizeof(mantissa_t));
     dec_exponent = 0;
     sig_digits = 0;
     decimal_pt = 1;
@@ -355,18 +430,8 @@ yasm_floatnum_create(const char *str)
         while (isdigit(*str)) {
             /* See if we've processed more than the max significant digits: */
             if (sig_digits < MANT_SIGDIGITS) {
-                /* Multiply mantissa by 10 [x = (x<<1)+(x<<3)] */
-                BitVector_shift_left(flt->mantissa, 0);
-                BitVector_Copy(operand[0], flt->mantissa);
-                BitVector_Move_Left(flt->mantissa, 2);
-                carry = 0;
-                BitVector_add(operand[1], operand[0], flt->mantissa, &carry);
-
-                /* Add in current digit */
-                BitVector_Empty(operand[0]);
-                BitVector_Chunk_Store(operand[0], 4, 0, (N_long)(*str-'0'));
-                carry = 0;
-                BitVector_add(flt->mantissa, operand[1], operand[0], &carry);
+                /* Multiply mantissa by 10 and add in current digit */
+                mantissa_mul10_add(mant, (unsigned int)(*str-'0'));
             } else {
                 /* Can't integrate more digits with mantissa, so instead just
                  * raise by a power of ten.
@@ -391,18 +456,8 @@ yasm_floatnum_create(const char *str)
                 /* Raise by a power of ten */
                 dec_exponent--;
 
-                /* Multiply mantissa by 10 [x = (x<<1)+(x<<3)] */
-                BitVector_shift_left(flt->mantissa, 0);
-                BitVector_Copy(operand[0], flt->mantissa);
-                BitVector_Move_Left(flt->mantissa, 2);
-                carry = 0;
-                BitVector_add(operand[1], operand[0], flt->mantissa, &carry);
-
-                /* Add in current digit */
-                BitVector_Empty(operand[0]);
-                BitVector_Chunk_Store(operand[0], 4, 0, (N_long)(*str-'0'));
-                carry = 0;
-                BitVector_add(flt->mantissa, operand[1], operand[0], &carry);
+                /* Multiply mantissa by 10 and add in current digit */
+                mantissa_mul10_add(mant, (unsigned int)(*str-'0'));
             }
             sig_digits++;
             str++;
@@ -419,12 +474,8 @@ yasm_floatnum_create(const char *str)
         dec_exponent += dec_exp_add;
     }
 
-    /* Free calculation variables. */
-    BitVector_Destroy(operand[1]);
-    BitVector_Destroy(operand[0]);
-
     /* Normalize the number, checking for 0 first. */
-    if (BitVector_is_empty(flt->mantissa)) {
+    if (mantissa_is_empty(mant)) {
         /* Mantissa is 0, zero exponent too. */
         flt->exponent = 0;
         /* Set zero flag so output functions don't see 0 value as underflow. */
@@ -434,7 +485,7 @@ yasm_floatnum_create(const char *str)
     }
     /* Exponent if already norm. */
     flt->exponent = (unsigned short)(0x7FFF+(MANT_BITS-1));
-    floatnum_normalize(flt);
+    floatnum_normalize(mant, &flt->exponent);
 
     /* The number is normalized.  Now multiply by 10 the number of times
      * specified in DecExponent.  This uses the power of ten tables to speed
@@ -456,7 +507,7 @@ yasm_floatnum_create(const char *str)
                 dec_exponent -= POT_TableP[POT_index].dec_exponent;
 
                 /* Multiply by current power of 10 */
-                floatnum_mul(flt, &POT_TableP[POT_index].f);
+                floatnum_mul(mant, &flt->exponent, &POT_TableP[POT_index]);
             }
         }
     } else if (dec_exponent < 0) {
@@ -475,7 +526,7 @@ yasm_floatnum_create(const char *str)
                 dec_exponent -= POT_TableN[POT_index].dec_exponent;
 
                 /* Multiply by current power of 10 */
-                floatnum_mul(flt, &POT_TableN[POT_index].f);
+                floatnum_mul(mant, &flt->exponent, &POT_TableN[POT_index]);
             }
         }
     }
@@ -483,9 +534,21 @@ yasm_floatnum_create(const char *str)
     /* Round the result. (Don't round underflow or overflow).  Also don't
      * increment if this would cause the mantissa to wrap.
      */
-    if ((flt->exponent != EXP_INF) && (flt->exponent != EXP_ZERO) &&
-        !BitVector_is_full(flt->mantissa))
-        BitVector_increment(flt->mantissa);
+    if ((flt->exponent != EXP_INF) && (flt->exponent != EXP_ZERO)) {
+        for (i=0; i<MANT_WORDS && mant[i] == 0xFFFF; i++)
+            ;
+        if (i < MANT_WORDS) {
+            for (i=0; i<MANT_WORDS; i++) {
+                mant[i] = (mant[i]+1) & 0xFFFF;
+                if (mant[i] != 0)
+                    break;
+            }
+        }
+    }
+
+    for (i=0; i<MANT_WORDS; i++)
+        BitVector_Chunk_Store(flt->mantissa, 16, (N_int)(i*16),
+                              (N_long)mant[i]);
 
     return flt;
 }
@@ -554,29 +617,38 @@ floatnum_get_common(const yasm_floatnum *flt, /*@out@*/ unsigned char *ptr,
                     N_int exp_bits)
 {
     long exponent = (long)flt->exponent;
-    wordptr output;
-    charptr buf;
-    unsigned int len;
+    mantissa_t mant;
+    unsigned long output[MANT_WORDS];
     unsigned int overflow = 0, underflow = 0;
     int retval = 0;
     long exp_bias = (1<<(exp_bits-1))-1;
     long exp_inf = (1<<exp_bits)-1;
+    long first_bit = (long)((MANT_BITS-implicit1)-mant_bits);
+    N_int i;
 
-    output = BitVector_Create(byte_size*8, TRUE);
+    floatnum_load_mantissa(flt, mant);
 
     /* copy mantissa */
-    BitVector_Interval_Copy(output, flt->mantissa, 0,
-                            (N_int)((MANT_BITS-implicit1)-mant_bits),
-                            mant_bits);
+    memset(output, 0, sizeof(output));
+    for (i=0; i*16<mant_bits; i++)
+        output[i] = words_get16(mant, MANT_WORDS, first_bit+(long)(i*16));
+    if (mant_bits%16 != 0)
+        output[mant_bits/16] &= (1UL<<(mant_bits%16))-1;
 
     /* round mantissa */
-    if (BitVector_bit_test(flt->mantissa, (MANT_BITS-implicit1)-(mant_bits+1)))
-        BitVector_increment(output);
+    if ((mant[(first_bit-1)/16] >> ((first_bit-1)%16)) & 1) {
+        for (i=0; i<MANT_WORDS; i++) {
+            output[i] = (output[i]+1) & 0xFFFF;
+            if (output[i] != 0)
+                break;
+        }
+    }
 
-    if (BitVector_bit_test(output, mant_bits)) {
+    if ((output[mant_bits/16] >> (mant_bits%16)) & 1) {
         /* overflowed, so zero mantissa (and set explicit bit if necessary) */
-        BitVector_Empty(output);
-        BitVector_Bit_Copy(output, mant_bits-1, !implicit1);
+        memset(output, 0, sizeof(output));
+        if (!implicit1)
+            output[(mant_bits-1)/16] |= 1UL<<((mant_bits-1)%16);
         /* and up the exponent (checking for overflow) */
         if (exponent+1 >= EXP_INF)
             overflow = 1;
@@ -597,35 +669,30 @@ floatnum_get_common(const yasm_floatnum *flt, /*@out@*/ unsigned char *ptr,
 
     /* check for underflow or overflow and set up appropriate output */
     if (underflow) {
-        BitVector_Empty(output);
+        memset(output, 0, sizeof(output));
         exponent = 0;
         if (!(flt->flags & FLAG_ISZERO))
             retval = -1;
     } else if (overflow) {
-        BitVector_Empty(output);
+        memset(output, 0, sizeof(output));
         exponent = exp_inf;
         retval = 1;
     }
 
-    /* move exponent into place */
-    BitVector_Chunk_Store(output, exp_bits, mant_bits, (N_long)exponent);
+    /* move exponent into place (the bits above the mantissa are clear) */
+    output[mant_bits/16] |= ((unsigned long)exponent << (mant_bits%16))
+        & 0xFFFF;
+    if ((mant_bits%16)+exp_bits > 16)
+        output[mant_bits/16+1] |= (unsigned long)exponent
+            >> (16-(mant_bits%16));
 
     /* merge in sign bit */
-    BitVector_Bit_Copy(output, byte_size*8-1, flt->sign);
-
-    /* get little-endian bytes */
-    buf = BitVector_Block_Read(output, &len);
-    if (len < byte_size)
-        yasm_internal_error(
-            N_("Byte length of BitVector does not match bit length"));
-
-    /* copy to output */
-    memcpy(ptr, buf, byte_size*sizeof(unsigned char));
-
-    /* free allocated resources */
-    yasm_xfree(buf);
+    if (flt->sign)
+        output[(byte_size*8-1)/16] |= 1UL<<((byte_size*8-1)%16);
 
-    BitVector_Destroy(output);
+    /* copy little-endian bytes to output */
+    for (i=0; i<byte_size; i++)
+        ptr[i] = (unsigned char)((output[i/2] >> ((i%2)*8)) & 0xFF);
 
     return retval;
 }
@@ -32,6 +32,7 @@
 #include "errwarn.h"
 #include "expr.h"
 #include "value.h"
+#include "symrec.h"
 
 #include "bytecode.h"
 #include "insn.h"
@@ -293,3 +294,65 @@ yasm_insn_finalize(yasm_insn *insn)
         }
     }
 }
+
+/* Maximum depth of nested EQUs followed by insn_expr_known(); anything
+ * deeper is simply treated as not yet known.
+ */
+#define MAX_EQU_DEPTH   8
+
+static int
+insn_expr_known(const yasm_expr *e, int depth)
+{
+    int i;
+
+    if (!e)
+        return 1;
+
+    for (i=0; i<e->numterms; i++) {
+        const yasm_expr__item *term = &e->terms[i];
+        /*@dependent@*/ yasm_symrec_get_label_bytecodep precbc;
+        const yasm_expr *equ;
+
+        switch (term->type) {
+            case YASM_EXPR_EXPR:
+                if (!insn_expr_known(term->data.expn, depth))
+                    return 0;
+                break;
+            case YASM_EXPR_SYM:
+                if (yasm_symrec_get_label(term->data.sym, &precbc))
+                    break;
+                equ = yasm_symrec_get_equ(term->data.sym);
+                if (!equ || depth >= MAX_EQU_DEPTH ||
+                    !insn_expr_known(equ, depth+1))
+                    return 0;
+                break;
+            default:
+                break;
+        }
+    }
+    return 1;
+}
+
+int
+yasm_insn_operands_known(yasm_insn *insn)
+{
+    yasm_insn_operand *op;
+
+    for (op = yasm_insn_ops_first(insn); op; op = yasm_insn_op_next(op)) {
+        if (!insn_expr_known(op->seg, 0))
+            return 0;
+        switch (op->type) {
+            case YASM_INSN__OPERAND_MEMORY:
+                if (op->data.ea && !insn_expr_known(op->data.ea->disp.abs, 0))
+                    return 0;
+                break;
+            case YASM_INSN__OPERAND_IMM:
+                if (!insn_expr_known(op->data.val, 0))
+                    return 0;
+                break;
+            default:
+                break;
+        }
+    }
+    return 1;
+}
@@ -266,4 +266,14 @@ void yasm_insn_print(const yasm_insn *insn, FILE *f, int indent_level);
 YASM_LIB_DECL
 void yasm_insn_finalize(yasm_insn *insn);
 
+/** Determine if an instruction's operands already have their final meaning.
+ * This is true if every symbol they reference is a label or an EQU of such
+ * symbols; an undefined symbol may still become an EQU (or a label in
+ * another section) later in the source.
+ * \param insn          instruction
+ * \return Nonzero if the operands are fully known, 0 if not.
+ */
+YASM_LIB_DECL
+int yasm_insn_operands_known(yasm_insn *insn);
+
 #endif
@@ -40,6 +40,12 @@
 /* "Native" "word" size for intnum calculations. */
 #define BITVECT_NATIVE_SIZE     256
 
+/* Values of up to this many 16-bit limbs (128 bits) are parsed and
+ * written out directly rather than through bitvect conversions.  A limb
+ * times 10000 plus a carry still fits in an unsigned long.
+ */
+#define FAST_LIMBS      8
+
 struct yasm_intnum {
     union val {
         long l;                 /* integer value (for integers <32 bits) */
@@ -127,12 +133,120 @@ intnum_tobv(/*@returned@*/ wordptr bv, const yasm_intnum *intn)
     }
     return bv;
 }
+/* Set intnum from FAST_LIMBS 16-bit limbs, least significant first. */
+static void
+intnum_fromlimbs(/*@out@*/ yasm_intnum *intn, const unsigned long *limbs)
+{
+    int top = FAST_LIMBS-1;
+
+    while (top > 1 && limbs[top] == 0)
+        top--;
+    if (top == 1 && limbs[1] < 0x8000) {
+        intn->type = INTNUM_L;
+        intn->val.l = (long)((limbs[1]<<16) | limbs[0]);
+        return;
+    }
+
+    BitVector_Empty(conv_bv);
+    for (; top >= 0; top--)
+        BitVector_Chunk_Store(conv_bv, 16, (N_int)top*16, limbs[top]);
+    intn->type = INTNUM_BV;
+    intn->val.bv = BitVector_Clone(conv_bv);
+}
+
+/* Parse a decimal literal of up to 128 bits, four digits at a time.
+ * Returns 0 without touching intn if the literal is larger or isn't
+ * plain digits (leaving BitVector_from_Dec_static() to deal with it).
+ */
+static int
+intnum_fromdec_fast(/*@out@*/ yasm_intnum *intn, const char *str)
+{
+    unsigned long limbs[FAST_LIMBS];
+    unsigned long chunk, scale, carry;
+    int nlimbs = 1, i;
+
+    if (*str == '\0')
+        return 0;
+
+    limbs[0] = 0;
+    while (*str != '\0') {
+        chunk = 0;
+        scale = 1;
+        for (i=0; i<4 && *str != '\0'; i++, str++) {
+            if (*str < '0' || *str > '9')
+                return 0;
+            chunk = chunk*10 + (unsigned long)(*str - '0');
+            scale *= 10;
+        }
+
+        carry = chunk;
+        for (i=0; i<nlimbs; i++) {
+            carry += limbs[i]*scale;
+            limbs[i] = carry & 0xffff;
+            carry >>= 16;
+        }
+        if (carry != 0) {
+            if (nlimbs == FAST_LIMBS)
+                return 0;
+            limbs[nlimbs++] = carry;
+        }
+    }
+
+    for (i=nlimbs; i<FAST_LIMBS; i++)
+        limbs[i] = 0;
+    intnum_fromlimbs(intn, limbs);
+    return 1;
+}
+
+/* Parse a hex literal of up to 128 bits (not counting leading zeros).
+ * Returns 0 without touching intn if the literal is larger or has
+ * characters other than hex digits and underscores.
+ */
+static int
+intnum_fromhex_fast(/*@out@*/ yasm_intnum *intn, const char *str)
+{
+    unsigned long limbs[FAST_LIMBS];
+    size_t len = strlen(str);
+    unsigned int ndigits = 0;
+    int i, digit;
+
+    for (i=0; i<FAST_LIMBS; i++)
+        limbs[i] = 0;
+
+    while (len > 0) {
+        digit = str[--len];
+        if (digit >= '0' && digit <= '9')
+            digit -= '0';
+        else if (digit >= 'a' && digit <= 'f')
+            digit -= 'a' - 10;
+        else if (digit >= 'A' && digit <= 'F')
+            digit -= 'A' - 10;
+        else if (digit == '_')
+            continue;
+        else
+            return 0;
+
+        if (ndigits == FAST_LIMBS*4) {
+            if (digit != 0)
+                return 0;
+            continue;
+        }
+        limbs[ndigits/4] |= (unsigned long)digit << ((ndigits%4)*4);
+        ndigits++;
+    }
+
+    intnum_fromlimbs(intn, limbs);
+    return 1;
+}
 
 yasm_intnum *
 yasm_intnum_create_dec(char *str)
 {
     yasm_intnum *intn = yasm_xmalloc(sizeof(yasm_intnum));
 
+    if (intnum_fromdec_fast(intn, str))
+        return intn;
+
     switch (BitVector_from_Dec_static(from_dec_data, conv_bv,
                                       (unsigned char *)str)) {
         case ErrCode_Pars:
@@ -194,6 +308,9 @@ yasm_intnum_create_hex(char *str)
 {
     yasm_intnum *intn = yasm_xmalloc(sizeof(yasm_intnum));
 
+    if (intnum_fromhex_fast(intn, str))
+        return intn;
+
     switch (BitVector_from_Hex(conv_bv, (unsigned char *)str)) {
         case ErrCode_Pars:
             yasm_error_set(YASM_ERROR_VALUE, N_("invalid hex literal"));
@@ -773,10 +890,53 @@ yasm_intnum_get_int(const yasm_intnum *intn)
     }
 }
 
-void
-yasm_intnum_get_sized(const yasm_intnum *intn, unsigned char *ptr,
+/* Write intn directly when the field is whole bytes at a byte offset in
+ * a little endian destination of at most 128 bits, which covers nearly
+ * every value emitted.  Returns 0 without writing anything otherwise.
+ */
+static int
+intnum_get_sized_fast(const yasm_intnum *intn, unsigned char *ptr,
                       size_t destsize, size_t valsize, int shift,
-                      int bigendian, int warn)
+                      int bigendian)
+{
+    unsigned long chunk;
+    unsigned char fill;
+    size_t i;
+
+    if (bigendian || destsize > FAST_LIMBS*2 || shift < 0 ||
+        (shift & 7) != 0 || (valsize & 7) != 0 ||
+        (size_t)shift + valsize > destsize*8)
+        return 0;
+
+    ptr += shift/8;
+    valsize /= 8;
+    if (intn->type == INTNUM_L) {
+        chunk = (unsigned long)intn->val.l;
+        fill = intn->val.l < 0 ? 0xff : 0;
+        for (i=0; i<valsize; i++) {
+            if (i < sizeof(unsigned long)) {
+                ptr[i] = (unsigned char)(chunk & 0xff);
+                chunk >>= 8;
+            } else
+                ptr[i] = fill;
+        }
+    } else {
+        chunk = 0;
+        for (i=0; i<valsize; i++) {
+            if ((i & 3) == 0)
+                chunk = BitVector_Chunk_Read(intn->val.bv, 32, (N_int)i*8);
+            ptr[i] = (unsigned char)(chunk & 0xff);
+            chunk >>= 8;
+        }
+    }
+    return 1;
+}
+
+/* General case of yasm_intnum_get_sized(), less the size warnings. */
+static void
+intnum_get_sized_bv(const yasm_intnum *intn, unsigned char *ptr,
+                    size_t destsize, size_t valsize, int shift,
+                    int bigendian, int warn)
 {
     wordptr op1 = op1static, op2;
     unsigned char *buf;
@@ -784,19 +944,6 @@ yasm_intnum_get_sized(const yasm_intnum *intn, unsigned char *ptr,
     size_t rshift = shift < 0 ? (size_t)(-shift) : 0;
     int carry_in;
 
-    /* Currently don't support destinations larger than our native size */
-    if (destsize*8 > BITVECT_NATIVE_SIZE)
-        yasm_internal_error(N_("destination too large"));
-
-    /* General size warnings */
-    if (warn<0 && !yasm_intnum_check_size(intn, valsize, rshift, 1))
-        yasm_warn_set(YASM_WARN_GENERAL,
-                      N_("value does not fit in signed %d bit field"),
-                      valsize);
-    if (warn>0 && !yasm_intnum_check_size(intn, valsize, rshift, 2))
-        yasm_warn_set(YASM_WARN_GENERAL,
-                      N_("value does not fit in %d bit field"), valsize);
-
     /* Read the original data into a bitvect */
     if (bigendian) {
         /* TODO */
@@ -837,6 +984,32 @@ yasm_intnum_get_sized(const yasm_intnum *intn, unsigned char *ptr,
     yasm_xfree(buf);
 }
 
+void
+yasm_intnum_get_sized(const yasm_intnum *intn, unsigned char *ptr,
+                      size_t destsize, size_t valsize, int shift,
+                      int bigendian, int warn)
+{
+    size_t rshift = shift < 0 ? (size_t)(-shift) : 0;
+
+    /* Currently don't support destinations larger than our native size */
+    if (destsize*8 > BITVECT_NATIVE_SIZE)
+        yasm_internal_error(N_("destination too large"));
+
+    /* General size warnings */
+    if (warn<0 && !yasm_intnum_check_size(intn, valsize, rshift, 1))
+        yasm_warn_set(YASM_WARN_GENERAL,
+                      N_("value does not fit in signed %d bit field"),
+                      valsize);
+    if (warn>0 && !yasm_intnum_check_size(intn, valsize, rshift, 2))
+        yasm_warn_set(YASM_WARN_GENERAL,
+                      N_("value does not fit in %d bit field"), valsize);
+
+    if (!intnum_get_sized_fast(intn, ptr, destsize, valsize, shift,
+                               bigendian))
+        intnum_get_sized_bv(intn, ptr, destsize, valsize, shift, bigendian,
+                            warn);
+}
+
 /* Return 1 if okay size, 0 if not */
 int
 yasm_intnum_check_size(const yasm_intnum *intn, size_t size, size_t rshift,
@@ -79,4 +79,22 @@ YASM_LIB_DECL
 void yasm_register_module(yasm_module_type type, const char *keyword,
                           void *data);
 
+/** Entry in a table of modules passed to yasm_register_module_table(). */
+typedef struct yasm_module_entry {
+    yasm_module_type type;      /**< Module type */
+    const char *keyword;        /**< Module keyword */
+    void *data;                 /**< Module structure */
+} yasm_module_entry;
+
+/** Register a table of modules at once.  The table is used in place (it is
+ * not copied), so must remain valid for the life of the program, and must be
+ * sorted by type and then by case-insensitive keyword so it can be searched
+ * without any setup cost.  Modules registered with yasm_register_module()
+ * take precedence over those in tables, and later tables over earlier ones.
+ * \param table     table of modules
+ * \param n         number of entries in table
+ */
+YASM_LIB_DECL
+void yasm_register_module_table(const yasm_module_entry *table, size_t n);
+
 #endif
@@ -146,6 +146,69 @@ phash_lookup(
 }
 
 
+/* phash_lookup_nocase() -- same as phash_lookup(), but hashes ASCII
+ * uppercase letters as if they were lowercase.  For keys that are lowercase
+ * the result is identical to phash_lookup(); this lets tables built from
+ * lowercase keys be probed with a mixed case key without copying it.
+ */
+#define fold(x) ((ub4)((x) >= 'A' && (x) <= 'Z' ? (x) | 0x20 : (x)))
+
+unsigned long
+phash_lookup_nocase(
+    register const char *sk, /* the key */
+    register size_t length,   /* the length of the key */
+    register unsigned long level) /* the previous hash, or an arbitrary value */
+{
+    register unsigned long a,b,c;
+    register size_t len;
+    register const unsigned char *k = (const unsigned char *)sk;
+
+    /* Set up the internal state */
+    len = length;
+    a = b = 0x9e3779b9;  /* the golden ratio; an arbitrary value */
+    c = level;           /* the previous hash value */
+
+    /*---------------------------------------- handle most of the key */
+    while (len >= 12)
+    {
+        a += (fold(k[0]) +(fold(k[1])<<8) +(fold(k[2])<<16) +(fold(k[3])<<24));
+        a &= 0xffffffff;
+        b += (fold(k[4]) +(fold(k[5])<<8) +(fold(k[6])<<16) +(fold(k[7])<<24));
+        b &= 0xffffffff;
+        c += (fold(k[8]) +(fold(k[9])<<8) +(fold(k[10])<<16)+(fold(k[11])<<24));
+        c &= 0xffffffff;
+        mix(a,b,c);
+        k += 12; len -= 12;
+    }
+
+    /*------------------------------------- handle the last 11 bytes */
+    c += (ub4)length;
+    switch(len)              /* all the case statements fall through */
+    {
+        case 11: c+=(fold(k[10])<<24);
+        case 10: c+=(fold(k[9])<<16);
+        case 9 : c+=(fold(k[8])<<8);
+                 c &= 0xffffffff;
+            /* the first byte of c is reserved for the length */
+        case 8 : b+=(fold(k[7])<<24);
+        case 7 : b+=(fold(k[6])<<16);
+        case 6 : b+=(fold(k[5])<<8);
+        case 5 : b+=fold(k[4]);
+                 b &= 0xffffffff;
+        case 4 : a+=(fold(k[3])<<24);
+        case 3 : a+=(fold(k[2])<<16);
+        case 2 : a+=(fold(k[1])<<8);
+        case 1 : a+=fold(k[0]);
+                 a &= 0xffffffff;
+        /* case 0: nothing left to add */
+    }
+    mix(a,b,c);
+    /*-------------------------------------------- report the result */
+    return c;
+}
+
+#undef fold
+
 /*
 --------------------------------------------------------------------
 mixc -- mixc 8 4-bit values as quickly and thoroughly as possible.
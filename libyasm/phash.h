@@ -16,4 +16,7 @@ YASM_LIB_DECL
 unsigned long phash_lookup(const char *k, size_t length,
                            unsigned long level);
 YASM_LIB_DECL
+unsigned long phash_lookup_nocase(const char *k, size_t length,
+                                  unsigned long level);
+YASM_LIB_DECL
 void phash_checksum(const char *k, size_t length, unsigned long *state);
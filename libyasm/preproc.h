@@ -40,6 +40,22 @@ typedef struct yasm_preproc_base {
 } yasm_preproc_base;
 #endif
 
+/** Source position of a line returned by yasm_preproc_get_line_info(). */
+typedef struct yasm_preproc_linepos {
+    /** Filename the line comes from, or NULL if the line simply follows the
+     * previous one.  Only valid until the next call to the preprocessor.
+     */
+    /*@null@*/ /*@dependent@*/ const char *filename;
+
+    /** Line number of the line (only valid if filename is non-NULL). */
+    unsigned long line;
+
+    /** Line number increment for following lines (only valid if filename
+     * is non-NULL).
+     */
+    unsigned long line_inc;
+} yasm_preproc_linepos;
+
 /** YASM preprocesor module interface. */
 typedef struct yasm_preproc_module {
     /** One-line description of the preprocessor. */
@@ -106,6 +122,15 @@ typedef struct yasm_preproc_module {
      * Call yasm_preproc_add_standard() instead of calling this function.
      */
     void (*add_standard) (yasm_preproc *preproc, const char **macros);
+
+    /** Module-level implementation of yasm_preproc_get_line_info().
+     * Call yasm_preproc_get_line_info() instead of calling this function.
+     * May be NULL if the preprocessor only provides lines with embedded
+     * line number directives through yasm_preproc_get_line().
+     */
+    /*@null@*/ char * (*get_line_info) (yasm_preproc *preproc,
+                                        /*@out@*/ size_t *len,
+                                        /*@out@*/ yasm_preproc_linepos *pos);
 } yasm_preproc_module;
 
 /** Initialize preprocessor.
@@ -134,6 +159,26 @@ void yasm_preproc_destroy(/*@only@*/ yasm_preproc *preproc);
  */
 char *yasm_preproc_get_line(yasm_preproc *preproc);
 
+/** Determine if a preprocessor supports yasm_preproc_get_line_info().
+ * \param preproc       preprocessor
+ * \return Nonzero if supported.
+ */
+int yasm_preproc_has_line_info(yasm_preproc *preproc);
+
+/** Gets a single line of preprocessed source code along with its length and
+ * source position.  Unlike yasm_preproc_get_line(), changes in source
+ * position are reported through pos rather than as separate line number
+ * directive lines.  Only available if yasm_preproc_has_line_info() is
+ * nonzero; calls should not be mixed with yasm_preproc_get_line().
+ * \param preproc       preprocessor
+ * \param len           length of the returned line (output)
+ * \param pos           source position of the returned line (output)
+ * \return Allocated line of code, without the trailing \n.
+ */
+char *yasm_preproc_get_line_info(yasm_preproc *preproc,
+                                 /*@out@*/ size_t *len,
+                                 /*@out@*/ yasm_preproc_linepos *pos);
+
 /** Get the next filename included by the source code.
  * \param preproc       preprocessor
  * \param buf           destination buffer for filename
@@ -189,6 +234,10 @@ void yasm_preproc_add_standard(yasm_preproc *preproc,
     ((yasm_preproc_base *)preproc)->module->destroy(preproc)
 #define yasm_preproc_get_line(preproc) \
     ((yasm_preproc_base *)preproc)->module->get_line(preproc)
+#define yasm_preproc_has_line_info(preproc) \
+    (((yasm_preproc_base *)preproc)->module->get_line_info != NULL)
+#define yasm_preproc_get_line_info(preproc, len, pos) \
+    ((yasm_preproc_base *)preproc)->module->get_line_info(preproc, len, pos)
 #define yasm_preproc_get_included_file(preproc, buf, max_size) \
     ((yasm_preproc_base *)preproc)->module->get_included_file(preproc, buf, max_size)
 #define yasm_preproc_add_include_file(preproc, filename) \
@@ -42,14 +42,31 @@
 #include "symrec.h"
 
 #include "bytecode.h"
+#include "insn.h"
 #include "arch.h"
 #include "section.h"
 
 #include "dbgfmt.h"
 #include "objfmt.h"
 
-#include "inttree.h"
+/* An error or warning raised by finalizing an instruction while parsing
+ * (see yasm_section_finalize_insn()).  Held until yasm_object_finalize()
+ * reaches the bytecode, so it is reported just as if the instruction had
+ * been finalized there.
+ */
+typedef struct finalize_msg {
+    /*@reldef@*/ STAILQ_ENTRY(finalize_msg) link;
+
+    /*@dependent@*/ /*@null@*/ yasm_bytecode *bc;
 
+    int is_error;
+    int mclass;                 /* yasm_error_class or yasm_warn_class */
+    /*@owned@*/ char *str;
+    unsigned long xrefline;
+    /*@owned@*/ /*@null@*/ char *xrefstr;
+} finalize_msg;
+
+/*@reldef@*/ STAILQ_HEAD(finalize_msghead, finalize_msg);
 
 struct yasm_section {
     /*@reldef@*/ STAILQ_ENTRY(yasm_section) link;
@@ -73,10 +90,18 @@ struct yasm_section {
     /* the bytecodes for the section's contents */
     /*@reldef@*/ STAILQ_HEAD(yasm_bytecodehead, yasm_bytecode) bcs;
 
-    /* the relocations for the section */
-    /*@reldef@*/ STAILQ_HEAD(yasm_relochead, yasm_reloc) relocs;
+    /* the relocations for the section, stored by value: num_relocs records
+     * of reloc_size bytes each in space for size_relocs records
+     */
+    /*@null@*/ /*@only@*/ unsigned char *relocs;
+    size_t reloc_size;
+    unsigned long num_relocs;
+    unsigned long size_relocs;
 
-    void (*destroy_reloc) (/*@only@*/ void *reloc);
+    /* messages from instructions finalized while parsing, in bytecode
+     * order
+     */
+    struct finalize_msghead finalize_msgs;
 };
 
 static void yasm_section_destroy(/*@only@*/ yasm_section *sect);
@@ -360,8 +385,12 @@ yasm_object_get_general(yasm_object *object, const char *name,
     STAILQ_INSERT_TAIL(&s->bcs, bc, link);
 
     /* Initialize relocs */
-    STAILQ_INIT(&s->relocs);
-    s->destroy_reloc = NULL;
+    s->relocs = NULL;
+    s->reloc_size = 0;
+    s->num_relocs = 0;
+    s->size_relocs = 0;
+
+    STAILQ_INIT(&s->finalize_msgs);
 
     s->code = code;
     s->res_only = res_only;
@@ -526,6 +555,78 @@ yasm_object_print(const yasm_object *object, FILE *f, int indent_level)
     }
 }
 
+/* Move the pending error (if any) and warnings onto the end of a message
+ * list, marked with bc.
+ */
+static void
+finalize_msgs_save(struct finalize_msghead *head, yasm_bytecode *bc)
+{
+    finalize_msg *msg;
+
+    if (yasm_error_occurred()) {
+        yasm_error_class eclass;
+
+        msg = yasm_xmalloc(sizeof(finalize_msg));
+        msg->bc = bc;
+        msg->is_error = 1;
+        yasm_error_fetch(&eclass, &msg->str, &msg->xrefline, &msg->xrefstr);
+        msg->mclass = (int)eclass;
+        STAILQ_INSERT_TAIL(head, msg, link);
+    }
+
+    while (yasm_warn_occurred() != YASM_WARN_NONE) {
+        yasm_warn_class wclass;
+
+        msg = yasm_xmalloc(sizeof(finalize_msg));
+        msg->bc = bc;
+        msg->is_error = 0;
+        yasm_warn_fetch(&wclass, &msg->str);
+        msg->mclass = (int)wclass;
+        msg->xrefline = 0;
+        msg->xrefstr = NULL;
+        STAILQ_INSERT_TAIL(head, msg, link);
+    }
+}
+
+/* Make the messages at the head of a list marked with bc pending again,
+ * removing them from the list.  Returns nonzero if one was an error.
+ */
+static int
+finalize_msgs_replay(struct finalize_msghead *head, yasm_bytecode *bc)
+{
+    finalize_msg *msg;
+    int error = 0;
+
+    while ((msg = STAILQ_FIRST(head)) && msg->bc == bc) {
+        STAILQ_REMOVE_HEAD(head, link);
+        if (msg->is_error) {
+            if (msg->xrefstr) {
+                yasm_error_set_xref(msg->xrefline, "%s", msg->xrefstr);
+                yasm_xfree(msg->xrefstr);
+            }
+            yasm_error_set((yasm_error_class)msg->mclass, "%s", msg->str);
+            error = 1;
+        } else
+            yasm_warn_set((yasm_warn_class)msg->mclass, "%s", msg->str);
+        yasm_xfree(msg->str);
+        yasm_xfree(msg);
+    }
+    return error;
+}
+
+static void
+finalize_msgs_delete(struct finalize_msghead *head)
+{
+    while (!STAILQ_EMPTY(head)) {
+        finalize_msg *msg = STAILQ_FIRST(head);
+        STAILQ_REMOVE_HEAD(head, link);
+        if (msg->xrefstr)
+            yasm_xfree(msg->xrefstr);
+        yasm_xfree(msg->str);
+        yasm_xfree(msg);
+    }
+}
+
 void
 yasm_object_finalize(yasm_object *object, yasm_errwarns *errwarns)
 {
@@ -542,8 +643,13 @@ yasm_object_finalize(yasm_object *object, yasm_errwarns *errwarns)
 
         /* Iterate through the remainder, if any. */
         while (cur) {
-            /* Finalize */
-            yasm_bc_finalize(cur, prev);
+            /* Finalize, first reporting any messages saved when finalizing
+             * an instruction while parsing.  After an error there, the
+             * instruction was left unconverted and must not be finalized
+             * again.
+             */
+            if (!finalize_msgs_replay(&sect->finalize_msgs, cur))
+                yasm_bc_finalize(cur, prev);
             yasm_errwarn_propagate(errwarns, cur->line);
             prev = cur;
             cur = STAILQ_NEXT(cur, link);
@@ -580,39 +686,50 @@ yasm_object_find_general(yasm_object *object, const char *name)
 }
 /*@=onlytrans@*/
 
-void
-yasm_section_add_reloc(yasm_section *sect, yasm_reloc *reloc,
-                       void (*destroy_func) (/*@only@*/ void *reloc))
+yasm_reloc *
+yasm_section_add_reloc(yasm_section *sect, const yasm_reloc *reloc,
+                       size_t size)
 {
-    STAILQ_INSERT_TAIL(&sect->relocs, reloc, link);
-    if (!destroy_func)
-        yasm_internal_error(N_("NULL destroy function given to add_reloc"));
-    else if (sect->destroy_reloc && destroy_func != sect->destroy_reloc)
-        yasm_internal_error(N_("different destroy function given to add_reloc"));
-    sect->destroy_reloc = destroy_func;
+    unsigned char *slot;
+
+    if (size < sizeof(yasm_reloc))
+        yasm_internal_error(N_("bad relocation size given to add_reloc"));
+    else if (sect->reloc_size && size != sect->reloc_size)
+        yasm_internal_error(N_("different relocation size given to add_reloc"));
+    sect->reloc_size = size;
+
+    if (sect->num_relocs >= sect->size_relocs) {
+        sect->size_relocs = sect->size_relocs ? sect->size_relocs*2 : 8;
+        sect->relocs = yasm_xrealloc(sect->relocs, sect->size_relocs*size);
+    }
+    slot = sect->relocs + sect->num_relocs*size;
+    memcpy(slot, reloc, size);
+    sect->num_relocs++;
+    return (yasm_reloc *)slot;
 }
 
-/*@null@*/ yasm_reloc *
-yasm_section_relocs_first(yasm_section *sect)
+/*@null@*/ void *
+yasm_section_get_relocs(yasm_section *sect, unsigned long *nrelocs)
 {
-    return STAILQ_FIRST(&sect->relocs);
+    *nrelocs = sect->num_relocs;
+    return sect->num_relocs ? sect->relocs : NULL;
 }
 
-#undef yasm_section_reloc_next
 /*@null@*/ yasm_reloc *
-yasm_section_reloc_next(yasm_reloc *reloc)
+yasm_section_get_reloc(yasm_section *sect, unsigned long n)
 {
-    return STAILQ_NEXT(reloc, link);
+    if (n >= sect->num_relocs)
+        return NULL;
+    return (yasm_reloc *)(sect->relocs + n*sect->reloc_size);
 }
 
 void
-yasm_reloc_get(yasm_reloc *reloc, yasm_intnum **addrp, yasm_symrec **symp)
+yasm_reloc_get(yasm_reloc *reloc, unsigned long *addrp, yasm_symrec **symp)
 {
     *addrp = reloc->addr;
     *symp = reloc->sym;
 }
 
-
 yasm_bytecode *
 yasm_section_bcs_first(yasm_section *sect)
 {
@@ -643,6 +760,26 @@ yasm_section_bcs_append(yasm_section *sect, yasm_bytecode *bc)
     return (yasm_bytecode *)NULL;
 }
 
+void
+yasm_section_finalize_insn(yasm_section *sect, yasm_bytecode *bc,
+                           yasm_bytecode *prev_bc)
+{
+    struct finalize_msghead line_msgs;
+    /*@null@*/ yasm_insn *insn = yasm_bc_get_insn(bc);
+
+    if (!insn || yasm_error_occurred() || !yasm_insn_operands_known(insn))
+        return;
+
+    /* Set aside warnings already raised while parsing the line */
+    STAILQ_INIT(&line_msgs);
+    finalize_msgs_save(&line_msgs, NULL);
+
+    bc->callback->finalize(bc, prev_bc);
+    finalize_msgs_save(&sect->finalize_msgs, bc);
+
+    finalize_msgs_replay(&line_msgs, NULL);
+}
+
 int
 yasm_section_bcs_traverse(yasm_section *sect,
                           /*@null@*/ yasm_errwarns *errwarns,
@@ -689,7 +826,6 @@ static void
 yasm_section_destroy(yasm_section *sect)
 {
     yasm_bytecode *cur, *next;
-    yasm_reloc *r_cur, *r_next;
 
     if (!sect)
         return;
@@ -706,13 +842,11 @@ yasm_section_destroy(yasm_section *sect)
     }
 
     /* Delete relocations */
-    r_cur = STAILQ_FIRST(&sect->relocs);
-    while (r_cur) {
-        r_next = STAILQ_NEXT(r_cur, link);
-        yasm_intnum_destroy(r_cur->addr);
-        sect->destroy_reloc(r_cur);
-        r_cur = r_next;
-    }
+    if (sect->relocs)
+        yasm_xfree(sect->relocs);
+
+    /* Delete messages never reported */
+    finalize_msgs_delete(&sect->finalize_msgs);
 
     yasm_xfree(sect);
 }
@@ -768,7 +902,7 @@ yasm_section_print(const yasm_section *sect, FILE *f, int indent_level,
  *  - handling of multiples
  *
  * Data structures:
- *  - Interval tree to store spans and associated data
+ *  - Interval index to store spans and associated data
  *  - Queues QA and QB
  *
  * Each span keeps track of:
@@ -808,8 +942,8 @@ yasm_section_print(const yasm_section *sect, FILE *f, int indent_level,
  *      next bytecode offset would be less than the old next bytecode offset,
  *      error.  Otherwise increase offset and update dependent spans.
  *
- * To reduce interval tree size, a first expansion pass is performed
- * before the spans are added to the tree.
+ * To reduce interval index size, a first expansion pass is performed
+ * before the spans are added to the index.
  *
  * Basic algorithm outline:
  *
@@ -828,7 +962,7 @@ yasm_section_print(const yasm_section *sect, FILE *f, int indent_level,
  *     expansion can result, mark span as inactive.
  *  c. Iterate over bytecodes to update all bytecode offsets based on new
  *     (expanded) lengths calculated in 1b.
- *  d. Iterate over active spans.  Add span to interval tree.  Update span's
+ *  d. Iterate over active spans.  Add span to interval index.  Update span's
  *     length based on new bytecode offsets determined in 1c.  If span's
  *     length exceeds long threshold, add that span to Q.
  * 2. Main loop:
@@ -898,10 +1032,245 @@ struct yasm_span {
     yasm_offset_setter *os;
 };
 
+/* Interval of bytecode indices covered by a span term, as a node of the
+ * span index.  Nodes are stored in pre-order, so a node's subtree is
+ * [node, nodes+end).
+ */
+typedef struct span_index_node {
+    long low, high;
+    long max_high;                  /* highest high in subtree */
+    long min_low;                   /* lowest low in subtree */
+    size_t end;                     /* index just past subtree */
+    /*@dependent@*/ yasm_span_term *term;
+} span_index_node;
+
+/* Point-stabbing index over span term intervals.  The intervals never change
+ * once Step 2 starts, so all intervals are added first and the index is then
+ * built once into a flat array.
+ *
+ * The shape of the tree is that of the red-black IntervalTree (inttree.c)
+ * given the same insertions, and queries report terms in the same (pre-)
+ * order as IT_enumerate() would.  With align and org the optimizer's result
+ * depends on that order, so this keeps the output the same.
+ */
+typedef struct span_index {
+    /* Nodes; in the order they were added until the index is built */
+    /*@only@*/ /*@null@*/ span_index_node *nodes;
+    size_t num, alloc;
+} span_index;
+
+static void
+span_index_initialize(span_index *idx)
+{
+    idx->nodes = NULL;
+    idx->num = 0;
+    idx->alloc = 0;
+}
+
+static void
+span_index_cleanup(span_index *idx)
+{
+    if (idx->nodes)
+        yasm_xfree(idx->nodes);
+    span_index_initialize(idx);
+}
+
+static void
+span_index_add(span_index *idx, long low, long high, yasm_span_term *term)
+{
+    span_index_node *node;
+
+    if (idx->num >= idx->alloc) {
+        idx->alloc = idx->alloc ? idx->alloc*2 : 64;
+        idx->nodes = yasm_xrealloc(idx->nodes,
+                                   idx->alloc*sizeof(span_index_node));
+    }
+    node = &idx->nodes[idx->num++];
+    node->low = low;
+    node->high = high;
+    node->term = term;
+}
+
+/* Red-black tree node while the index is being built; -1 is nil. */
+typedef struct span_index_link {
+    long low;
+    long left, right, parent;
+    int red;
+} span_index_link;
+
+static void
+span_index_rotate(span_index_link *ln, long *root, long x, int left)
+{
+    long y = left ? ln[x].right : ln[x].left;
+    long b = left ? ln[y].left : ln[y].right;
+    long p = ln[x].parent;
+
+    if (left) {
+        ln[x].right = b;
+        ln[y].left = x;
+    } else {
+        ln[x].left = b;
+        ln[y].right = x;
+    }
+    if (b >= 0)
+        ln[b].parent = x;
+    ln[y].parent = p;
+    if (p < 0)
+        *root = y;
+    else if (ln[p].left == x)
+        ln[p].left = y;
+    else
+        ln[p].right = y;
+    ln[x].parent = y;
+}
+
+/* Inserts node z as IT_insert() does. */
+static void
+span_index_insert(span_index_link *ln, long *root, long z)
+{
+    long x = *root, y = -1, u, p, g;
+
+    while (x >= 0) {
+        y = x;
+        x = ln[x].low > ln[z].low ? ln[x].left : ln[x].right;
+    }
+    ln[z].left = ln[z].right = -1;
+    ln[z].parent = y;
+    ln[z].red = 1;
+    if (y < 0)
+        *root = z;
+    else if (ln[y].low > ln[z].low)
+        ln[y].left = z;
+    else
+        ln[y].right = z;
+
+    /* A red parent is never the root, so the grandparent exists */
+    x = z;
+    while ((p = ln[x].parent) >= 0 && ln[p].red) {
+        int pleft;
+
+        g = ln[p].parent;
+        pleft = (ln[g].left == p);
+        u = pleft ? ln[g].right : ln[g].left;
+        if (u >= 0 && ln[u].red) {
+            ln[p].red = 0;
+            ln[u].red = 0;
+            ln[g].red = 1;
+            x = g;
+        } else {
+            if (x == (pleft ? ln[p].right : ln[p].left)) {
+                x = p;
+                span_index_rotate(ln, root, x, pleft);
+                p = ln[x].parent;
+            }
+            ln[p].red = 0;
+            ln[g].red = 1;
+            span_index_rotate(ln, root, g, !pleft);
+        }
+    }
+    ln[*root].red = 0;
+}
+
+static void
+span_index_build(span_index *idx)
+{
+    span_index_link *ln;
+    span_index_node *pre;
+    size_t *pos;
+    long *order;
+    long root = -1, x, p;
+    size_t i, n = 0;
+
+    if (idx->num == 0)
+        return;
+
+    ln = yasm_xmalloc(idx->num*sizeof(span_index_link));
+    for (i=0; i<idx->num; i++) {
+        ln[i].low = idx->nodes[i].low;
+        span_index_insert(ln, &root, (long)i);
+    }
+
+    /* Lay the nodes out in pre-order (walking the parent links) */
+    pre = yasm_xmalloc(idx->num*sizeof(span_index_node));
+    pos = yasm_xmalloc(idx->num*sizeof(size_t));
+    order = yasm_xmalloc(idx->num*sizeof(long));
+    x = root;
+    while (x >= 0) {
+        pos[x] = n;
+        order[n] = x;
+        pre[n++] = idx->nodes[x];
+        if (ln[x].left >= 0)
+            x = ln[x].left;
+        else if (ln[x].right >= 0)
+            x = ln[x].right;
+        else {
+            /* Up to the nearest ancestor with an unvisited right subtree */
+            while ((p = ln[x].parent) >= 0 &&
+                   (ln[p].right == x || ln[p].right < 0))
+                x = p;
+            x = p >= 0 ? ln[p].right : -1;
+        }
+    }
+
+    /* Fill in the subtree fields, children (later in pre-order) first */
+    for (i=n; i-- > 0; ) {
+        span_index_node *node = &pre[i];
+        long l, r;
+
+        x = order[i];
+        l = ln[x].left;
+        r = ln[x].right;
+        node->max_high = node->high;
+        node->min_low = node->low;
+        node->end = i+1;
+        if (l >= 0) {
+            const span_index_node *c = &pre[pos[l]];
+            if (c->max_high > node->max_high)
+                node->max_high = c->max_high;
+            node->min_low = c->min_low;
+            node->end = c->end;
+        }
+        if (r >= 0) {
+            const span_index_node *c = &pre[pos[r]];
+            if (c->max_high > node->max_high)
+                node->max_high = c->max_high;
+            node->end = c->end;
+        }
+    }
+
+    yasm_xfree(order);
+    yasm_xfree(pos);
+    yasm_xfree(ln);
+    yasm_xfree(idx->nodes);
+    idx->nodes = pre;
+}
+
+/* Calls func for the term of each interval containing point.  func must not
+ * query the index.
+ */
+static void
+span_index_enumerate(span_index *idx, long point, void *d,
+                     void (*func) (yasm_span_term *term, void *d))
+{
+    size_t i = 0;
+
+    while (i < idx->num) {
+        const span_index_node *node = &idx->nodes[i];
+
+        if (node->max_high < point || node->min_low > point) {
+            i = node->end;      /* nothing in this subtree */
+            continue;
+        }
+        if (node->low <= point && node->high >= point)
+            func(node->term, d);
+        i++;
+    }
+}
+
 typedef struct optimize_data {
     /*@reldef@*/ TAILQ_HEAD(yasm_span_head, yasm_span) spans;
     /*@reldef@*/ STAILQ_HEAD(yasm_span_shead, yasm_span) QA, QB;
-    /*@only@*/ IntervalTree *itree;
+    span_index sindex;
     /*@reldef@*/ STAILQ_HEAD(offset_setters_head, yasm_offset_setter)
         offset_setters;
     long len_diff;      /* used only for optimize_term_expand */
@@ -1139,7 +1508,7 @@ optimize_cleanup(optimize_data *optd)
     yasm_span *s1, *s2;
     yasm_offset_setter *os1, *os2;
 
-    IT_destroy(optd->itree);
+    span_index_cleanup(&optd->sindex);
 
     s1 = TAILQ_FIRST(&optd->spans);
     while (s1) {
@@ -1157,7 +1526,7 @@ optimize_cleanup(optimize_data *optd)
 }
 
 static void
-optimize_itree_add(IntervalTree *itree, yasm_span *span, yasm_span_term *term)
+optimize_index_add(span_index *idx, yasm_span *span, yasm_span_term *term)
 {
     long precbc_index, precbc2_index;
     unsigned long low, high;
@@ -1182,14 +1551,13 @@ optimize_itree_add(IntervalTree *itree, yasm_span *span, yasm_span_term *term)
     } else
         return;     /* difference is same bc - always 0! */
 
-    IT_insert(itree, (long)low, (long)high, term);
+    span_index_add(idx, (long)low, (long)high, term);
 }
 
 static void
-check_cycle(IntervalTreeNode *node, void *d)
+check_cycle(yasm_span_term *term, void *d)
 {
     optimize_data *optd = d;
-    yasm_span_term *term = node->data;
     yasm_span *depspan = term->span;
     int i;
     int depspan_bt_alloc;
@@ -1261,10 +1629,9 @@ check_cycle(IntervalTreeNode *node, void *d)
 }
 
 static void
-optimize_term_expand(IntervalTreeNode *node, void *d)
+optimize_term_expand(yasm_span_term *term, void *d)
 {
     optimize_data *optd = d;
-    yasm_span_term *term = node->data;
     yasm_span *span = term->span;
     long len_diff = optd->len_diff;
     long precbc_index, precbc2_index;
@@ -1319,7 +1686,7 @@ yasm_object_optimize(yasm_object *object, yasm_errwarns *errwarns)
 
     TAILQ_INIT(&optd.spans);
     STAILQ_INIT(&optd.offset_setters);
-    optd.itree = IT_create();
+    span_index_initialize(&optd.sindex);
 
     /* Create an placeholder offset setter for spans to point to; this will
      * get updated if/when we actually run into one.
@@ -1475,21 +1842,22 @@ yasm_object_optimize(yasm_object *object, yasm_errwarns *errwarns)
         os->cur_val = os->new_val;
     }
 
-    /* Build up interval tree */
+    /* Build up interval index */
     TAILQ_FOREACH(span, &optd.spans, link) {
         for (i=0; i<span->num_terms; i++)
-            optimize_itree_add(optd.itree, span, &span->terms[i]);
+            optimize_index_add(&optd.sindex, span, &span->terms[i]);
         if (span->rel_term)
-            optimize_itree_add(optd.itree, span, span->rel_term);
+            optimize_index_add(&optd.sindex, span, span->rel_term);
     }
+    span_index_build(&optd.sindex);
 
     /* Look for cycles in times expansion (span.id==0) */
     TAILQ_FOREACH(span, &optd.spans, link) {
         if (span->id > 0)
             continue;
         optd.span = span;
-        IT_enumerate(optd.itree, (long)span->bc->bc_index,
-                     (long)span->bc->bc_index, &optd, check_cycle);
+        span_index_enumerate(&optd.sindex, (long)span->bc->bc_index, &optd,
+                             check_cycle);
         if (yasm_error_occurred()) {
             yasm_errwarn_propagate(errwarns, span->bc->line);
             saw_error = 1;
@@ -1556,8 +1924,8 @@ yasm_object_optimize(yasm_object *object, yasm_errwarns *errwarns)
             continue;   /* didn't increase in size */
 
         /* Iterate over all spans dependent across the bc just expanded */
-        IT_enumerate(optd.itree, (long)span->bc->bc_index,
-                     (long)span->bc->bc_index, &optd, optimize_term_expand);
+        span_index_enumerate(&optd.sindex, (long)span->bc->bc_index, &optd,
+                             optimize_term_expand);
 
         /* Iterate over offset-setters that follow the bc just expanded.
          * Stop iteration if:
@@ -1584,8 +1952,8 @@ yasm_object_optimize(yasm_object *object, yasm_errwarns *errwarns)
             offset_diff = os->new_val + os->bc->len - old_next_offset;
             optd.len_diff = os->bc->len - orig_len;
             if (optd.len_diff != 0)
-                IT_enumerate(optd.itree, (long)os->bc->bc_index,
-                     (long)os->bc->bc_index, &optd, optimize_term_expand);
+                span_index_enumerate(&optd.sindex, (long)os->bc->bc_index,
+                                     &optd, optimize_term_expand);
 
             os->cur_val = os->new_val;
             os = STAILQ_NEXT(os, link);
@@ -36,12 +36,13 @@
 
 /** Basic YASM relocation.  Object formats will need to extend this
  * structure with additional fields for relocation type, etc.
+ * Relocations are copied by value into an array kept by the section, so
+ * the extended structure must not own any allocated data.
  */
 typedef struct yasm_reloc yasm_reloc;
 
 struct yasm_reloc {
-    /*@reldef@*/ STAILQ_ENTRY(yasm_reloc) link; /**< Link to next reloc */
-    yasm_intnum *addr;          /**< Offset (address) within section */
+    unsigned long addr;         /**< Offset (address) within section */
     /*@dependent@*/ yasm_symrec *sym;       /**< Relocated symbol */
 };
 
@@ -267,31 +268,36 @@ void yasm_section_add_data(yasm_section *sect,
 /** Add a relocation to a section.
  * \param sect          section
  * \param reloc         relocation
- * \param destroy_func  function that can destroy the relocation
- * \note Does not make a copy of reloc.  The same destroy_func must be
- * used for all relocations in a section or an internal error will occur.
- * The section will destroy the relocation address; it is the caller's
- * responsibility to destroy any other allocated data.
+ * \param size          size of the relocation structure, including any
+ *                      object format specific fields
+ * \note Makes a copy of reloc.  The same size must be used for all
+ * relocations in a section or an internal error will occur.
+ * \return The section's copy of the relocation.  Only valid until the next
+ *         relocation is added to the section.
  */
 YASM_LIB_DECL
-void yasm_section_add_reloc(yasm_section *sect, yasm_reloc *reloc,
-    void (*destroy_func) (/*@only@*/ void *reloc));
+yasm_reloc *yasm_section_add_reloc(yasm_section *sect,
+                                   const yasm_reloc *reloc, size_t size);
 
-/** Get the first relocation for a section.
+/** Get the relocations for a section.
  * \param sect          section
- * \return First relocation for section.  NULL if no relocations.
+ * \param nrelocs       number of relocations (returned)
+ * \return Array of relocations, each of the size given to
+ *         yasm_section_add_reloc(), in the order they were added.  NULL if
+ *         no relocations.
  */
 YASM_LIB_DECL
-/*@null@*/ yasm_reloc *yasm_section_relocs_first(yasm_section *sect);
+/*@null@*/ void *yasm_section_get_relocs(yasm_section *sect,
+                                         /*@out@*/ unsigned long *nrelocs);
 
-/** Get the next relocation for a section.
- * \param reloc         previous relocation
- * \return Next relocation for section.  NULL if no more relocations.
+/** Get a relocation of a section by index.
+ * \param sect          section
+ * \param n             index of relocation (0 for first)
+ * \return Relocation.  NULL if there are fewer than n+1 relocations.
  */
-/*@null@*/ yasm_reloc *yasm_section_reloc_next(yasm_reloc *reloc);
-#ifndef YASM_DOXYGEN
-#define yasm_section_reloc_next(x)      STAILQ_NEXT((x), link)
-#endif
+YASM_LIB_DECL
+/*@null@*/ yasm_reloc *yasm_section_get_reloc(yasm_section *sect,
+                                              unsigned long n);
 
 /** Get the basic relocation information for a relocation.
  * \param reloc         relocation
@@ -299,7 +305,7 @@ YASM_LIB_DECL
  * \param symp          relocated symbol (returned)
  */
 YASM_LIB_DECL
-void yasm_reloc_get(yasm_reloc *reloc, yasm_intnum **addrp,
+void yasm_reloc_get(yasm_reloc *reloc, unsigned long *addrp,
                     /*@dependent@*/ yasm_symrec **symp);
 
 /** Get the first bytecode in a section.
@@ -332,6 +338,23 @@ YASM_LIB_DECL
     (yasm_section *sect,
      /*@returned@*/ /*@only@*/ /*@null@*/ yasm_bytecode *bc);
 
+/** Finalize an instruction bytecode just appended to a section, rather
+ * than waiting for yasm_object_finalize(), if its operands are already
+ * fully known (see yasm_insn_operands_known()).  This frees the parsed
+ * operands as soon as the instruction has been parsed.  Errors and
+ * warnings raised are saved and reported by yasm_object_finalize(), so
+ * diagnostics are unchanged.  Does nothing for other bytecodes, or if an
+ * error is pending.
+ * \note The architecture's finalize function must either convert the
+ *       instruction into a different bytecode type or raise an error.
+ * \param sect          section
+ * \param bc            bytecode (the last in sect)
+ * \param prev_bc       bytecode directly preceding bc
+ */
+YASM_LIB_DECL
+void yasm_section_finalize_insn(yasm_section *sect, yasm_bytecode *bc,
+                                yasm_bytecode *prev_bc);
+
 /** Traverses all bytecodes in a section, calling a function on each bytecode.
  * \param sect      section
  * \param errwarns  error/warning set (may be NULL)
@@ -71,6 +71,7 @@ struct yasm_symrec {
         /* bytecode immediately preceding a label */
         /*@dependent@*/ yasm_bytecode *precbc;
     } value;
+    /*@null@*/ /*@only@*/ yasm_intnum *equ_intn;   /* folded constant equ */
     unsigned int size;          /* 0 if not user-defined */
     const char *segment;        /* for segmented systems like DOS */
 
@@ -153,6 +154,8 @@ symrec_destroy_one(/*@only@*/ void *d)
     yasm_xfree(sym->name);
     if (sym->type == SYM_EQU && (sym->status & YASM_SYM_VALUED))
         yasm_expr_destroy(sym->value.expn);
+    if (sym->equ_intn)
+        yasm_intnum_destroy(sym->equ_intn);
     yasm__assoc_data_destroy(sym->assoc_data);
     yasm_xfree(sym);
 }
@@ -176,6 +179,7 @@ symrec_new_common(/*@keep@*/ char *name, int case_sensitive)
     rec->visibility = YASM_SYM_LOCAL;
     rec->size = 0;
     rec->segment = NULL;
+    rec->equ_intn = NULL;
     rec->assoc_data = NULL;
     return rec;
 }
@@ -336,8 +340,11 @@ yasm_symtab_define_label(yasm_symtab *symtab, const char *name,
     if (yasm_error_occurred())
         return rec;
     rec->value.precbc = precbc;
-    if (in_table && precbc)
-        yasm_bc__add_symrec(precbc, rec);
+    if (precbc) {
+        precbc->pos_ref = 1;
+        if (in_table)
+            yasm_bc__add_symrec(precbc, rec);
+    }
     return rec;
 }
 
@@ -349,6 +356,8 @@ yasm_symtab_define_curpos(yasm_symtab *symtab, const char *name,
     if (yasm_error_occurred())
         return rec;
     rec->value.precbc = precbc;
+    if (precbc)
+        precbc->pos_ref = 1;
     return rec;
 }
 
@@ -544,6 +553,20 @@ yasm_symrec_get_equ(const yasm_symrec *sym)
     return (const yasm_expr *)NULL;
 }
 
+const yasm_intnum *
+yasm_symrec__get_equ_intnum(const yasm_symrec *sym)
+{
+    return sym->equ_intn;
+}
+
+void
+yasm_symrec__set_equ_intnum(yasm_symrec *sym, yasm_intnum *intn)
+{
+    if (sym->equ_intn)
+        yasm_intnum_destroy(sym->equ_intn);
+    sym->equ_intn = intn;
+}
+
 int
 yasm_symrec_get_label(const yasm_symrec *sym,
                       yasm_symrec_get_label_bytecodep *precbc)
@@ -309,6 +309,23 @@ YASM_LIB_DECL
 /*@observer@*/ /*@null@*/ const yasm_expr *yasm_symrec_get_equ
     (const yasm_symrec *sym);
 
+/** Get the cached constant value of an EQU symbol.  Internal use only.
+ * \param sym       symbol
+ * \return Folded EQU value, or NULL if the EQU has not (yet) been found to
+ *         be constant.
+ */
+YASM_LIB_DECL
+/*@observer@*/ /*@null@*/ const yasm_intnum *yasm_symrec__get_equ_intnum
+    (const yasm_symrec *sym);
+
+/** Cache the folded constant value of an EQU symbol.  Internal use only.
+ * \param sym       symbol
+ * \param intn      folded EQU value
+ */
+YASM_LIB_DECL
+void yasm_symrec__set_equ_intnum(yasm_symrec *sym,
+                                 /*@only@*/ yasm_intnum *intn);
+
 /** Dependent pointer to a bytecode. */
 typedef /*@dependent@*/ yasm_bytecode *yasm_symrec_get_label_bytecodep;
 
@@ -0,0 +1,612 @@
+/*
+ * In-process assembly throughput benchmark
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/* Assembly throughput benchmark.
+ *
+ * Generates a set of large, deterministic source corpora (compiler-style
+ * AVX2 kernels, data tables, macro-heavy NASM, GAS syntax and jump-dense
+ * code), assembles each in-process through yasm_assemble_buffer(), and
+ * reports per-phase processor time and throughput.
+ *
+ * Usage: assemble_bench [-n iterations] [-s scale] [-t tolerance%]
+ *                       [-b baseline [-u]] [-l]
+ *
+ * With -b, the statements/second of each corpus are compared against the
+ * baseline file and the run fails if any is more than the tolerance
+ * (default 10%) slower.  If the baseline file doesn't exist, or -u is
+ * given, it's (re)written from this run instead.  Baselines are specific to
+ * the machine and build they were recorded on.
+ *
+ * With -l, each corpus is preprocessed once and then only run through the
+ * parser's scanner (see lexbench_nasm.c and lexbench_gas.c), reporting its
+ * throughput in MB/s of preprocessed source.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "libyasm.h"
+#include "libyasm/bitvect.h"
+
+#ifdef CMAKE_BUILD
+void yasm_init_plugin(void);
+#endif
+
+unsigned long lexbench_nasm(yasm_object *object, yasm_linemap *linemap,
+                            yasm_errwarns *errwarns, char **lines,
+                            size_t num_lines);
+unsigned long lexbench_gas(yasm_object *object, yasm_linemap *linemap,
+                           yasm_errwarns *errwarns, char **lines,
+                           size_t num_lines);
+
+/* Growable source text */
+typedef struct srcbuf {
+    char *data;
+    size_t len;
+    size_t size;
+} srcbuf;
+
+static void
+emit(srcbuf *sb, const char *fmt, ...)
+{
+    char line[256];
+    size_t len;
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsprintf(line, fmt, ap);
+    va_end(ap);
+    len = strlen(line);
+
+    if (sb->len + len + 1 > sb->size) {
+        while (sb->len + len + 1 > sb->size)
+            sb->size = sb->size ? sb->size*2 : 65536;
+        sb->data = yasm_xrealloc(sb->data, sb->size);
+    }
+    memcpy(sb->data+sb->len, line, len+1);
+    sb->len += len;
+}
+
+/* Simple deterministic pseudo-random numbers, so every run (and every
+ * platform) assembles exactly the same source.
+ */
+static unsigned long rand_state;
+
+static unsigned long
+rnd(unsigned long n)
+{
+    rand_state = (rand_state * 1103515245UL + 12345UL) & 0xFFFFFFFFUL;
+    return (rand_state >> 8) % n;
+}
+
+static const char *gpr64[] = {
+    "rax", "rbx", "rcx", "rdx", "rsi", "rdi", "r8", "r9", "r10", "r11",
+    "r12", "r13", "r14", "r15"
+};
+#define NUM_GPR64   (sizeof(gpr64)/sizeof(gpr64[0]))
+
+/* Each generator appends a corpus of roughly scale*1000 statements
+ * (instructions or data declarations after macro expansion) and returns
+ * the exact number of statements.
+ */
+
+static unsigned long
+gen_avx2(srcbuf *sb, unsigned long scale)
+{
+    static const char *ops3[] = {
+        "vaddps", "vmulps", "vsubps", "vmaxps", "vminps", "vandps",
+        "vxorps", "vpaddd", "vpmulld", "vpxor", "vpand", "vpsubd"
+    };
+    static const char *fma[] = {
+        "vfmadd231ps", "vfmadd213ps", "vfnmadd231ps", "vfmsub231ps"
+    };
+    unsigned long n = 0, f, i, nfuncs = scale*1000/22;
+
+    emit(sb, "bits 64\ndefault rel\nsection .text\n");
+    for (f=0; f<nfuncs; f++) {
+        unsigned long body = 12 + rnd(8);
+
+        emit(sb, "global kernel_%lu\nkernel_%lu:\n", f, f);
+        emit(sb, "    push rbp\n    mov rbp, rsp\n    sub rsp, %lu\n",
+             32 + 16*rnd(8));
+        emit(sb, "    xor eax, eax\n    vxorps ymm15, ymm15, ymm15\n");
+        n += 5;
+        emit(sb, ".loop:\n");
+        for (i=0; i<body; i++) {
+            unsigned long a = rnd(16), b = rnd(16), c = rnd(16);
+            switch (rnd(6)) {
+                case 0:
+                    emit(sb, "    vmovups ymm%lu, [rdi+rax*4+%lu]\n", a,
+                         32*rnd(8));
+                    break;
+                case 1:
+                    emit(sb, "    vmovups [rdx+rax*4+%lu], ymm%lu\n",
+                         32*rnd(8), a);
+                    break;
+                case 2:
+                    emit(sb, "    %s ymm%lu, ymm%lu, ymm%lu\n",
+                         fma[rnd(4)], a, b, c);
+                    break;
+                case 3:
+                    emit(sb, "    %s ymm%lu, ymm%lu, [rsi+rax*4+%lu]\n",
+                         ops3[rnd(12)], a, b, 32*rnd(8));
+                    break;
+                case 4:
+                    emit(sb, "    vbroadcastss ymm%lu, [rcx+%lu]\n", a,
+                         4*rnd(64));
+                    break;
+                default:
+                    emit(sb, "    %s ymm%lu, ymm%lu, ymm%lu\n",
+                         ops3[rnd(12)], a, b, c);
+                    break;
+            }
+        }
+        emit(sb, "    add rax, 8\n    cmp rax, r8\n    jb .loop\n");
+        emit(sb, "    vzeroupper\n    mov [rbp-8], rax\n    leave\n"
+             "    ret\n");
+        n += body + 7;
+    }
+    return n;
+}
+
+static unsigned long
+gen_data(srcbuf *sb, unsigned long scale)
+{
+    unsigned long n = 0, t, i, ntables = scale*1000/20;
+
+    emit(sb, "section .data\n");
+    for (t=0; t<ntables; t++) {
+        emit(sb, "table_%lu:\n", t);
+        for (i=0; i<16; i++) {
+            switch (rnd(4)) {
+                case 0:
+                    emit(sb, "    dd %lu, %lu, %lu, %lu, %lu, %lu, %lu, "
+                         "%lu\n", rnd(100000), rnd(100000), rnd(100000),
+                         rnd(100000), rnd(100000), rnd(100000),
+                         rnd(100000), rnd(100000));
+                    break;
+                case 1:
+                    emit(sb, "    dq 0x%08lx%08lx, table_%lu, %lu\n",
+                         rnd(0x7FFFFFFFUL), rnd(0x7FFFFFFFUL), rnd(t+1),
+                         rnd(1000000));
+                    break;
+                case 2:
+                    emit(sb, "    dw %lu, %lu, %lu, %lu, -%lu, -%lu\n",
+                         rnd(65536), rnd(65536), rnd(65536), rnd(65536),
+                         rnd(32768), rnd(32768));
+                    break;
+                default:
+                    emit(sb, "    db \"string %lu of table %lu\", %lu, 0\n",
+                         i, t, rnd(256));
+                    break;
+            }
+        }
+        emit(sb, "    times %lu db 0\n", 1 + rnd(16));
+        emit(sb, "    align 8\n");
+        emit(sb, "table_%lu_len equ $-table_%lu\n", t, t);
+        emit(sb, "    dd table_%lu_len\n", t);
+        n += 20;
+    }
+    return n;
+}
+
+static unsigned long
+gen_macro(srcbuf *sb, unsigned long scale)
+{
+    unsigned long n = 0, f, nfuncs = scale*1000/26;
+
+    emit(sb, "bits 64\nsection .text\n");
+    emit(sb, "%%define SLOT(x) ((x)*8+16)\n");
+    emit(sb, "%%macro PROLOGUE 1\n    push rbp\n    mov rbp, rsp\n"
+         "    sub rsp, %%1\n%%endmacro\n");
+    emit(sb, "%%macro EPILOGUE 0\n    leave\n    ret\n%%endmacro\n");
+    emit(sb, "%%macro LOADADD 3\n    mov %%1, [%%2+%%3*8]\n"
+         "    add %%1, %%3\n    imul %%1, %%1, 3\n%%endmacro\n");
+    emit(sb, "%%macro SPILL 2\n%%assign %%%%i 0\n%%rep %%2\n"
+         "    mov [rsp+SLOT(%%%%i)], %%1\n%%assign %%%%i %%%%i+1\n"
+         "%%endrep\n%%endmacro\n");
+    for (f=0; f<nfuncs; f++) {
+        unsigned long reps = 4 + rnd(4), spills = 2 + rnd(4);
+        const char *r1 = gpr64[rnd(NUM_GPR64)];
+
+        emit(sb, "func_%lu:\n    PROLOGUE %lu\n", f, 32 + 8*rnd(16));
+        emit(sb, "%%rep %lu\n    LOADADD %s, rsi, rcx\n%%endrep\n", reps,
+             r1);
+        emit(sb, "    SPILL %s, %lu\n", r1, spills);
+        emit(sb, "%%if %lu > 3\n    mov rax, [rsp+SLOT(%lu)]\n%%else\n"
+             "    xor eax, eax\n%%endif\n", spills, spills-1);
+        emit(sb, "    EPILOGUE\n");
+        n += 3 + reps*3 + spills + 1 + 2;
+    }
+    return n;
+}
+
+static unsigned long
+gen_gas(srcbuf *sb, unsigned long scale)
+{
+    static const char *gpr32[] = {
+        "%eax", "%ebx", "%ecx", "%edx", "%esi", "%edi", "%r8d", "%r9d"
+    };
+    unsigned long n = 0, f, i, nfuncs = scale*1000/32;
+
+    for (f=0; f<nfuncs; f++) {
+        unsigned long body = 16 + rnd(12);
+
+        emit(sb, "\t.text\n\t.globl f%lu\n\t.type f%lu, @function\n"
+             "f%lu:\n", f, f, f);
+        emit(sb, "\tpushq %%rbp\n\tmovq %%rsp, %%rbp\n\tsubq $%lu, %%rsp\n",
+             16*(1+rnd(8)));
+        n += 3;
+        for (i=0; i<body; i++) {
+            const char *r = gpr32[rnd(8)];
+            switch (rnd(6)) {
+                case 0:
+                    emit(sb, "\tmovl %lu(%%rdi,%%rcx,4), %s\n", 4*rnd(64),
+                         r);
+                    break;
+                case 1:
+                    emit(sb, "\tmovl %s, -%lu(%%rbp)\n", r, 4*(1+rnd(16)));
+                    break;
+                case 2:
+                    emit(sb, "\taddl $%lu, %s\n", rnd(1000), r);
+                    break;
+                case 3:
+                    emit(sb, "\tleaq %lu(%%rsi,%%rdx,8), %%rax\n", 8*rnd(32));
+                    break;
+                case 4:
+                    emit(sb, "\tcmpl $%lu, %s\n\tjne .Lf%lu_out\n",
+                         rnd(256), r, f);
+                    n++;
+                    break;
+                default:
+                    emit(sb, "\timull %s, %s\n", r, gpr32[rnd(8)]);
+                    break;
+            }
+        }
+        emit(sb, ".Lf%lu_out:\n\tleave\n\tret\n\t.size f%lu, .-f%lu\n",
+             f, f, f);
+        emit(sb, "\t.section .rodata\n\t.align 4\n.Lt%lu:\n"
+             "\t.long %lu, %lu, %lu, %lu\n", f, rnd(100000), rnd(100000),
+             rnd(100000), rnd(100000));
+        n += body + 3;
+    }
+    return n;
+}
+
+static unsigned long
+gen_jumps(srcbuf *sb, unsigned long scale)
+{
+    unsigned long n = 0, i, nlabels = scale*1000/4;
+
+    emit(sb, "bits 64\nsection .text\n");
+    for (i=0; i<nlabels; i++) {
+        /* Mostly nearby targets, some far enough to need near jumps */
+        unsigned long span = rnd(4) ? 20 : 400;
+        unsigned long lo = i > span ? i-span : 0;
+        unsigned long hi = i+span < nlabels ? i+span : nlabels-1;
+
+        emit(sb, "L%lu:\n    cmp eax, %lu\n    jne L%lu\n", i, rnd(128),
+             lo + rnd(hi-lo+1));
+        if (rnd(3) == 0)
+            emit(sb, "    jmp L%lu\n", lo + rnd(hi-lo+1));
+        else
+            emit(sb, "    add eax, %lu\n", rnd(1000));
+        emit(sb, "    dec ecx\n");
+        n += 4;
+    }
+    return n;
+}
+
+typedef struct corpus {
+    const char *name;
+    const char *parser;
+    const char *objfmt;
+    unsigned long (*gen)(srcbuf *sb, unsigned long scale);
+} corpus;
+
+static const corpus corpora[] = {
+    {"avx2",  "nasm", "elf64", gen_avx2},
+    {"data",  "nasm", "elf64", gen_data},
+    {"macro", "nasm", "elf64", gen_macro},
+    {"gas",   "gas",  "elf64", gen_gas},
+    {"jumps", "nasm", "elf64", gen_jumps},
+};
+#define NUM_CORPORA (sizeof(corpora)/sizeof(corpora[0]))
+
+static void
+print_error(const char *fn, unsigned long line, const char *msg,
+            const char *xref_fn, unsigned long xref_line,
+            const char *xref_msg)
+{
+    fprintf(stderr, "%s:%lu: error: %s\n", fn, line, msg);
+}
+
+static double
+total_time(const yasm_assemble_stats *stats)
+{
+    return stats->setup_time + stats->parse_time + stats->finalize_time +
+           stats->optimize_time + stats->output_time;
+}
+
+/* Supplies the corpus source in place of the file of that name */
+static FILE *
+source_fopen(const char *filename, const char *mode, void *d)
+{
+    const srcbuf *sb = d;
+    FILE *f = tmpfile();
+
+    if (!f)
+        return NULL;
+    fwrite(sb->data, 1, sb->len, f);
+    rewind(f);
+    return f;
+}
+
+/* Preprocesses a corpus, then times scanning the preprocessed lines. */
+static int
+lex_corpus(const corpus *c, const srcbuf *sb, int iterations)
+{
+    yasm_parser_module *parser_module = yasm_load_parser(c->parser);
+    yasm_arch_module *arch_module = yasm_load_arch("x86");
+    yasm_preproc_module *preproc_module;
+    yasm_arch_create_error arch_error;
+    yasm_arch *arch;
+    yasm_object *object;
+    yasm_preproc *preproc;
+    yasm_linemap *linemap;
+    yasm_errwarns *errwarns;
+    char **lines = NULL, *line;
+    size_t num_lines = 0, alloc = 0, bytes = 0, i;
+    unsigned long tokens = 0;
+    double t, best = 0;
+    int n;
+
+    preproc_module =
+        yasm_load_preproc(parser_module->default_preproc_keyword);
+    arch = yasm_arch_create(arch_module, "amd64",
+                            parser_module->keyword, &arch_error);
+    if (!preproc_module || !arch)
+        return 1;
+    yasm_arch_set_var(arch, "mode_bits", 64);
+
+    errwarns = yasm_errwarns_create();
+    linemap = yasm_linemap_create();
+    yasm_linemap_set(linemap, c->name, 0, 1, 1);
+    object = yasm_object_create(c->name, "yasm.out", arch,
+                                yasm_load_objfmt(c->objfmt),
+                                yasm_load_dbgfmt("null"));
+
+    yasm_set_fopen_hook(source_fopen, (void *)sb);
+    preproc = yasm_preproc_create(preproc_module, c->name, object->symtab,
+                                  linemap, errwarns);
+    while ((line = yasm_preproc_get_line(preproc)) != NULL) {
+        if (num_lines >= alloc) {
+            alloc = alloc ? alloc*2 : 1024;
+            lines = yasm_xrealloc(lines, alloc*sizeof(char *));
+        }
+        lines[num_lines++] = line;
+        bytes += strlen(line)+1;
+    }
+    yasm_preproc_destroy(preproc);
+    yasm_set_fopen_hook(NULL, NULL);
+
+    for (n=0; n<iterations; n++) {
+        clock_t start = clock();
+        if (strcmp(c->parser, "gas") == 0)
+            tokens = lexbench_gas(object, linemap, errwarns, lines,
+                                  num_lines);
+        else
+            tokens = lexbench_nasm(object, linemap, errwarns, lines,
+                                   num_lines);
+        t = (double)(clock()-start)/CLOCKS_PER_SEC;
+        if (n == 0 || t < best)
+            best = t;
+    }
+    if (best <= 0)
+        best = 1.0 / CLOCKS_PER_SEC;    /* clock() granularity */
+
+    printf("%-6s %8lu %8lu %9lu %7.3f %8.1f\n", c->name,
+           (unsigned long)num_lines, (unsigned long)(bytes/1024), tokens,
+           best, bytes/1048576.0/best);
+
+    for (i=0; i<num_lines; i++)
+        yasm_xfree(lines[i]);
+    if (lines)
+        yasm_xfree(lines);
+    yasm_object_destroy(object);
+    yasm_linemap_destroy(linemap);
+    yasm_errwarns_destroy(errwarns);
+    return 0;
+}
+
+/* Looks up the baseline rate of a corpus; returns 0 if not present. */
+static double
+baseline_rate(FILE *f, const char *name)
+{
+    char line[256], bname[64];
+    double rate;
+
+    rewind(f);
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%63s %lf", bname, &rate) == 2 &&
+            strcmp(bname, name) == 0)
+            return rate;
+    }
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    yasm_output_buffer out = {NULL, 0, 0};
+    yasm_assemble_options opts;
+    yasm_assemble_stats stats, best;
+    const char *baseline = NULL;
+    FILE *bf = NULL;
+    int iterations = 5, update = 0, lex = 0, nf = 0;
+    unsigned long scale = 100;
+    double tolerance = 10.0;
+    double rates[NUM_CORPORA];
+    size_t c;
+    int i;
+
+    for (i=1; i<argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i+1 < argc)
+            iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0 && i+1 < argc)
+            scale = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+            tolerance = atof(argv[++i]);
+        else if (strcmp(argv[i], "-b") == 0 && i+1 < argc)
+            baseline = argv[++i];
+        else if (strcmp(argv[i], "-u") == 0)
+            update = 1;
+        else if (strcmp(argv[i], "-l") == 0)
+            lex = 1;
+        else {
+            fprintf(stderr, "usage: %s [-n iterations] [-s scale] "
+                    "[-t tolerance%%] [-b baseline [-u]] [-l]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (iterations < 1)
+        iterations = 1;
+    if (scale < 1)
+        scale = 1;
+
+    if (BitVector_Boot() != ErrCode_Ok)
+        return EXIT_FAILURE;
+    yasm_intnum_initialize();
+    yasm_floatnum_initialize();
+    yasm_errwarn_initialize();
+#ifdef CMAKE_BUILD
+    yasm_init_plugin();
+#endif
+
+    if (lex) {
+        printf("%-6s %8s %8s %9s %7s %8s\n", "corpus", "lines", "pp KB",
+               "tokens", "scan", "MB/s");
+        for (c=0; c<NUM_CORPORA; c++) {
+            srcbuf sb = {NULL, 0, 0};
+
+            rand_state = 1;
+            corpora[c].gen(&sb, scale);
+            if (lex_corpus(&corpora[c], &sb, iterations) != 0) {
+                fprintf(stderr, "%s: could not set up scanner\n",
+                        corpora[c].name);
+                return EXIT_FAILURE;
+            }
+            yasm_xfree(sb.data);
+        }
+        yasm_errwarn_cleanup();
+        yasm_floatnum_cleanup();
+        yasm_intnum_cleanup();
+        return EXIT_SUCCESS;
+    }
+
+    if (baseline && !update) {
+        bf = fopen(baseline, "r");
+        if (!bf)
+            update = 1;
+    }
+
+    printf("%-6s %8s %8s %8s %7s %7s %7s %7s %7s %7s %9s %8s\n",
+           "corpus", "stmts", "src KB", "out KB", "setup", "parse", "final",
+           "optim", "output", "total", "stmt/s", "src KB/s");
+
+    for (c=0; c<NUM_CORPORA; c++) {
+        srcbuf sb = {NULL, 0, 0};
+        unsigned long stmts;
+        double t;
+
+        rand_state = 1;
+        stmts = corpora[c].gen(&sb, scale);
+
+        memset(&opts, 0, sizeof(opts));
+        opts.parser = corpora[c].parser;
+        opts.objfmt = corpora[c].objfmt;
+        opts.print_error = print_error;
+        opts.stats = &stats;
+
+        for (i=0; i<iterations; i++) {
+            if (yasm_assemble_buffer(corpora[c].name, sb.data, sb.len, &opts,
+                                     &out) != 0) {
+                fprintf(stderr, "%s: assembly failed\n", corpora[c].name);
+                return EXIT_FAILURE;
+            }
+            if (i == 0 || total_time(&stats) < total_time(&best))
+                best = stats;
+        }
+
+        t = total_time(&best);
+        if (t <= 0)
+            t = 1.0 / CLOCKS_PER_SEC;   /* clock() granularity */
+        rates[c] = stmts / t;
+        printf("%-6s %8lu %8lu %8lu %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f "
+               "%9.0f %8.0f\n", corpora[c].name, stmts,
+               (unsigned long)(sb.len/1024), (unsigned long)(out.len/1024),
+               best.setup_time, best.parse_time, best.finalize_time,
+               best.optimize_time, best.output_time, t, rates[c],
+               sb.len/1024.0/t);
+
+        if (bf) {
+            double base = baseline_rate(bf, corpora[c].name);
+            if (base > 0 && rates[c] < base * (1.0 - tolerance/100.0)) {
+                printf("** %s: %.0f stmt/s is %.1f%% below baseline %.0f\n",
+                       corpora[c].name, rates[c],
+                       100.0 * (base - rates[c]) / base, base);
+                nf++;
+            }
+        }
+        yasm_xfree(sb.data);
+    }
+
+    if (bf)
+        fclose(bf);
+    if (baseline && update) {
+        bf = fopen(baseline, "w");
+        if (!bf) {
+            fprintf(stderr, "could not write baseline `%s'\n", baseline);
+            return EXIT_FAILURE;
+        }
+        fprintf(bf, "# assemble_bench baseline (statements/second)\n");
+        for (c=0; c<NUM_CORPORA; c++)
+            fprintf(bf, "%s %.0f\n", corpora[c].name, rates[c]);
+        fclose(bf);
+        printf("baseline written to %s\n", baseline);
+    }
+
+    yasm_output_buffer_free(&out);
+    yasm_errwarn_cleanup();
+    yasm_floatnum_cleanup();
+    yasm_intnum_cleanup();
+
+    return (nf == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
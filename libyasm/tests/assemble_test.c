@@ -0,0 +1,201 @@
+/*
+ * In-memory assembly tests
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libyasm.h"
+#include "libyasm/bitvect.h"
+
+#ifdef CMAKE_BUILD
+void yasm_init_plugin(void);
+#endif
+
+typedef struct Test_Entry {
+    /* object format (NULL for default) */
+    const char *objfmt;
+
+    /* source code */
+    const char *src;
+
+    /* expected return value */
+    int result;
+
+    /* expected output (compared over outlen bytes) */
+    const char *out;
+    size_t outlen;
+
+    /* expected number of errors reported */
+    int errors;
+} Test_Entry;
+
+static Test_Entry tests[] = {
+    /* Includes are supplied from memory */
+    {NULL, "mov ax, 1\n%include \"virt.inc\"\n", 0, "\xB8\x01\x00\x90", 4,
+     0},
+    {NULL, "%include \"virt.inc\"\n%include \"virt.inc\"\n", 0, "\x90\x90",
+     2, 0},
+    /* Files the include function doesn't supply go to the caller's hook */
+    {NULL, "%include \"outer.inc\"\n", 0, "\xCC", 1, 0},
+    /* Object formats that seek back to write headers */
+    {"elf32", "nop\n", 0, "\x7F" "ELF\x01", 5, 0},
+    {"coff", "nop\n", 0, "\x4C\x01\x01\x00", 4, 0},
+    /* Errors are reported and produce no output */
+    {NULL, "mov ax, [\n", 1, "", 0, 1},
+    {NULL, "jmp nowhere\n", 1, "", 0, 2},
+    {"nosuchfmt", "nop\n", 1, "", 0, 1},
+};
+
+static char failed[1000];
+static char failmsg[100];
+static int num_errors;
+
+static int
+test_include(const char *filename, const char **data, size_t *len, void *d)
+{
+    if (strcmp(filename, "virt.inc") != 0)
+        return 0;
+    *data = "db 0x90\n";
+    *len = strlen(*data);
+    return 1;
+}
+
+/* fopen hook set by the caller around yasm_assemble_buffer() */
+static FILE *
+outer_fopen(const char *filename, const char *mode, void *d)
+{
+    FILE *f;
+
+    if (strcmp(filename, "outer.inc") != 0 || d != (void *)tests)
+        return NULL;
+    f = tmpfile();
+    if (f) {
+        fputs("int3\n", f);
+        rewind(f);
+    }
+    return f;
+}
+
+static void
+test_error(const char *fn, unsigned long line, const char *msg,
+           const char *xref_fn, unsigned long xref_line,
+           const char *xref_msg)
+{
+    num_errors++;
+}
+
+static int
+run_test(Test_Entry *test, yasm_output_buffer *out)
+{
+    yasm_assemble_options opts;
+    int result;
+
+    memset(&opts, 0, sizeof(opts));
+    opts.objfmt = test->objfmt;
+    opts.include_func = test_include;
+    opts.print_error = test_error;
+
+    num_errors = 0;
+    result = yasm_assemble_buffer("test.asm", test->src, strlen(test->src),
+                                  &opts, out);
+    if (result != test->result) {
+        sprintf(failmsg, "`%.40s': expected result %d, got %d",
+                test->src, test->result, result);
+        return 1;
+    }
+    if (num_errors != test->errors) {
+        sprintf(failmsg, "`%.40s': expected %d errors, got %d",
+                test->src, test->errors, num_errors);
+        return 1;
+    }
+    if (test->result == 0 && test->objfmt == NULL &&
+        out->len != test->outlen) {
+        sprintf(failmsg, "`%.40s': expected %lu bytes, got %lu",
+                test->src, (unsigned long)test->outlen,
+                (unsigned long)out->len);
+        return 1;
+    }
+    if (out->len < test->outlen ||
+        memcmp(out->data, test->out, test->outlen) != 0) {
+        sprintf(failmsg, "`%.40s': bad output", test->src);
+        return 1;
+    }
+    return 0;
+}
+
+int
+main(void)
+{
+    yasm_output_buffer out = {NULL, 0, 0};
+    yasm_fopen_hook_func hook;
+    void *hook_data;
+    int nf = 0;
+    int numtests = sizeof(tests)/sizeof(Test_Entry);
+    int i;
+
+    if (BitVector_Boot() != ErrCode_Ok)
+        return EXIT_FAILURE;
+    yasm_intnum_initialize();
+    yasm_floatnum_initialize();
+    yasm_errwarn_initialize();
+#ifdef CMAKE_BUILD
+    yasm_init_plugin();
+#endif
+
+    failed[0] = '\0';
+    printf("Test assemble_test: ");
+    yasm_set_fopen_hook(outer_fopen, (void *)tests);
+    for (i=0; i<numtests; i++) {
+        /* The output buffer is deliberately reused between tests */
+        int fail = run_test(&tests[i], &out);
+        printf("%c", fail>0 ? 'F':'.');
+        fflush(stdout);
+        if (fail)
+            sprintf(failed, "%s ** F: %s\n", failed, failmsg);
+        nf += fail;
+    }
+
+    /* The caller's hook is still in place afterwards */
+    yasm_get_fopen_hook(&hook, &hook_data);
+    if (hook != outer_fopen || hook_data != (void *)tests) {
+        printf("F");
+        strcat(failed, " ** F: caller's fopen hook not restored\n");
+        nf++;
+    } else
+        printf(".");
+    numtests++;
+    yasm_set_fopen_hook(NULL, NULL);
+
+    yasm_output_buffer_free(&out);
+    yasm_errwarn_cleanup();
+    yasm_floatnum_cleanup();
+    yasm_intnum_cleanup();
+
+    printf(" +%d-%d/%d %d%%\n%s",
+           numtests-nf, nf, numtests, 100*(numtests-nf)/numtests, failed);
+    return (nf == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
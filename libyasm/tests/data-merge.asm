@@ -0,0 +1,18 @@
+; Consecutive constant data lines may be merged into one bytecode; make sure
+; labels, current-position references and multiples still see the right
+; offsets.
+db 1, 2, 3
+db "abc"
+here equ $
+db 4
+dw here, $-here
+lbl:
+dd 5
+db 6
+times 3 db 7
+db 8
+dw lbl, after-lbl
+db 9, 10
+after:
+dw 11
+dq after
@@ -0,0 +1,13 @@
+; Constant equ's are folded once and reused; make sure forward references,
+; chained equ's, and equ's mixing labels still evaluate correctly.
+dw	later
+dw	later*2
+four	equ	2+2
+eight	equ	four*2
+dw	eight, eight+four, -eight
+dd	eight<<four
+lbl:
+mixed	equ	lbl+eight
+dw	mixed, mixed-lbl, mixed-lbl
+later	equ	eight+1
+dw	later, later
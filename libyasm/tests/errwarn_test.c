@@ -0,0 +1,171 @@
+/*
+ * Error and warning collection tests
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libyasm.h"
+
+typedef struct Test_Entry {
+    /* maximum repeat count (0 for unlimited) */
+    unsigned long max_repeat;
+
+    /* nonzero to stream output */
+    int stream;
+
+    /* errors/warnings to propagate, each as type (e=error, p=parser error,
+     * w=warning), line, colon, and message, separated by spaces
+     */
+    const char *in;
+
+    /* expected output, each as line, type, colon, and message, followed by
+     * a semicolon
+     */
+    const char *out;
+
+    /* expected error count */
+    unsigned int errors;
+} Test_Entry;
+
+static Test_Entry tests[] = {
+    /* Sorted by line, keeping order within a line */
+    {0, 0, "w3:a w1:b e2:c w1:d", "1w:b;1w:d;2e:c;3w:a;", 1},
+    {0, 0, "w1:a w2:b w3:c", "1w:a;2w:b;3w:c;", 0},
+    /* Parser errors are overwritten by a following error */
+    {0, 0, "p2:syntax e2:real", "2e:real;", 2},
+    {0, 0, "p2:syntax w3:x e3:real", "2e:syntax;3w:x;3e:real;", 2},
+    {0, 0, "w5:x p2:syntax e3:real", "2e:real;5w:x;", 2},
+    /* Repeat limiting */
+    {2, 0, "w1:a w2:a w3:a w4:b w5:a", "1w:a;2w:a;4w:b;2w:a (repeated 2 more times);", 0},
+    {1, 0, "e1:a e2:a w3:a", "1e:a;3w:a;1e:a (repeated 1 more times);", 2},
+    /* Streaming outputs in propagated order */
+    {0, 1, "w3:a w1:b e2:c", "3w:a;1w:b;2e:c;", 1},
+    {0, 1, "p2:syntax e2:real w1:x", "2e:real;1w:x;", 2},
+    {1, 1, "w3:a w1:a w2:b", "3w:a;2w:b;3w:a (repeated 1 more times);", 0},
+};
+
+static char failed[1000];
+static char failmsg[100];
+static char result[200];
+
+static void
+test_error(const char *fn, unsigned long line, const char *msg,
+           const char *xref_fn, unsigned long xref_line,
+           const char *xref_msg)
+{
+    sprintf(result+strlen(result), "%lue:%s;", line, msg);
+}
+
+static void
+test_warning(const char *fn, unsigned long line, const char *msg)
+{
+    sprintf(result+strlen(result), "%luw:%s;", line, msg);
+}
+
+static int
+run_test(Test_Entry *test)
+{
+    yasm_linemap *linemap = yasm_linemap_create();
+    yasm_errwarns *errwarns = yasm_errwarns_create();
+    const char *in = test->in;
+    unsigned int errors;
+
+    yasm_linemap_set(linemap, "test.asm", 0, 1, 1);
+    yasm_errwarns_set_max_repeat(errwarns, test->max_repeat);
+    if (test->stream)
+        yasm_errwarns_stream(errwarns, linemap, 0, test_error, test_warning);
+
+    result[0] = '\0';
+    while (*in != '\0') {
+        char type = *in++;
+        unsigned long line = strtoul(in, (char **)&in, 10);
+        char msg[20];
+        size_t len;
+
+        in++;   /* skip colon */
+        len = strcspn(in, " ");
+        memcpy(msg, in, len);
+        msg[len] = '\0';
+        in += len;
+        if (*in == ' ')
+            in++;
+
+        /* Line 1 of the file is virtual line 1 */
+        yasm_linemap_set(linemap, NULL, line, line, 1);
+        if (type == 'e')
+            yasm_error_set(YASM_ERROR_GENERAL, "%s", msg);
+        else if (type == 'p')
+            yasm_error_set(YASM_ERROR_PARSE, "%s", msg);
+        else
+            yasm_warn_set(YASM_WARN_GENERAL, "%s", msg);
+        yasm_errwarn_propagate(errwarns, line);
+    }
+
+    yasm_errwarns_output_all(errwarns, linemap, 0, test_error, test_warning);
+    errors = yasm_errwarns_num_errors(errwarns, 0);
+
+    yasm_errwarns_destroy(errwarns);
+    yasm_linemap_destroy(linemap);
+
+    if (strcmp(result, test->out) != 0) {
+        sprintf(failmsg, "`%.30s': got `%.50s'", test->in, result);
+        return 1;
+    }
+    if (errors != test->errors) {
+        sprintf(failmsg, "`%.30s': expected %u errors, got %u", test->in,
+                test->errors, errors);
+        return 1;
+    }
+    return 0;
+}
+
+int
+main(void)
+{
+    int nf = 0;
+    int numtests = sizeof(tests)/sizeof(Test_Entry);
+    int i;
+
+    yasm_errwarn_initialize();
+
+    failed[0] = '\0';
+    printf("Test errwarn_test: ");
+    for (i=0; i<numtests; i++) {
+        int fail = run_test(&tests[i]);
+        printf("%c", fail>0 ? 'F':'.');
+        fflush(stdout);
+        if (fail)
+            sprintf(failed, "%s ** F: %s\n", failed, failmsg);
+        nf += fail;
+    }
+
+    yasm_errwarn_cleanup();
+
+    printf(" +%d-%d/%d %d%%\n%s",
+           numtests-nf, nf, numtests, 100*(numtests-nf)/numtests, failed);
+    return (nf == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,179 @@
+/*
+ * Include file resolution tests
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libyasm/file.h"
+#include "libyasm/coretype.h"
+
+#define DIR_A   "include_test_a/"
+#define DIR_B   "include_test_b/"
+#define DIR_C   "include_test_c/"
+#define DIR_D   "include_test_d/"       /* never created */
+
+/* Steps are run in order against the (cached) include file lookup */
+typedef struct Test_Entry {
+    enum {
+        CREATE,         /* create file path */
+        REMOVE,         /* remove file path */
+        ADD_PATH,       /* add include path */
+        DELETE_PATHS,   /* delete all include paths */
+        LOOKUP          /* look up path (from "from"); expect "out" */
+    } action;
+
+    const char *path;
+
+    /* file doing the including (for LOOKUP) */
+    const char *from;
+
+    /* pathname found, NULL if it shouldn't be (for LOOKUP) */
+    const char *out;
+
+    /* what the step checks */
+    const char *desc;
+} Test_Entry;
+
+static Test_Entry tests[] = {
+    {CREATE, DIR_A "other.inc", NULL, NULL, NULL},
+    {CREATE, DIR_B "y.inc", NULL, NULL, NULL},
+    {CREATE, DIR_C "y.inc", NULL, NULL, NULL},
+    {ADD_PATH, DIR_A, NULL, NULL, NULL},
+    {ADD_PATH, DIR_B, NULL, NULL, NULL},
+    {ADD_PATH, DIR_C, NULL, NULL, NULL},
+
+    {LOOKUP, "x.inc", NULL, NULL, "not found"},
+    {CREATE, DIR_A "x.inc", NULL, NULL, NULL},
+    {LOOKUP, "x.inc", NULL, NULL, "not found remembered"},
+
+    {LOOKUP, "y.inc", NULL, DIR_B "y.inc", "found in later path"},
+    {CREATE, DIR_A "y.inc", NULL, NULL, NULL},
+    /* e.g. the -M dependency pass and then assembly */
+    {LOOKUP, "y.inc", NULL, DIR_B "y.inc", "found remembered"},
+    {REMOVE, DIR_B "y.inc", NULL, NULL, NULL},
+    {LOOKUP, "y.inc", NULL, DIR_C "y.inc", "found but gone searches again"},
+
+    /* Never looked up, but its directory has already been listed */
+    {CREATE, DIR_A "z.inc", NULL, NULL, NULL},
+    {LOOKUP, "z.inc", NULL, NULL, "directory listing used"},
+
+    {ADD_PATH, DIR_D, NULL, NULL, NULL},
+    {LOOKUP, "x.inc", NULL, DIR_A "x.inc", "not found forgotten on new path"},
+    {LOOKUP, "y.inc", NULL, DIR_A "y.inc", "found forgotten on new path"},
+    {LOOKUP, "z.inc", NULL, DIR_A "z.inc", "listing refreshed on new path"},
+    {LOOKUP, "y.inc", DIR_C "file.asm", DIR_C "y.inc", "relative to from"},
+
+    {DELETE_PATHS, NULL, NULL, NULL, NULL},
+    {LOOKUP, "x.inc", NULL, NULL, "not found without paths"},
+    {ADD_PATH, DIR_A, NULL, NULL, NULL},
+    {LOOKUP, "x.inc", NULL, DIR_A "x.inc", "found after paths reset"},
+    {DELETE_PATHS, NULL, NULL, NULL, NULL},
+};
+
+static char failed[1000];
+static char failmsg[100];
+
+static int
+run_test(Test_Entry *test)
+{
+    FILE *f;
+    char *oname;
+
+    switch (test->action) {
+        case CREATE:
+            yasm__createpath(test->path);
+            f = fopen(test->path, "w");
+            if (!f) {
+                sprintf(failmsg, "couldn't create `%s'", test->path);
+                return 1;
+            }
+            fclose(f);
+            return -1;
+        case REMOVE:
+            remove(test->path);
+            return -1;
+        case ADD_PATH:
+            yasm_add_include_path(test->path);
+            return -1;
+        case DELETE_PATHS:
+            yasm_delete_include_paths();
+            return -1;
+        case LOOKUP:
+            break;
+    }
+
+    f = yasm_fopen_include(test->path, test->from, "r", &oname);
+    if (f)
+        fclose(f);
+    if ((test->out == NULL) != (oname == NULL) ||
+        (oname && strcmp(oname, test->out) != 0)) {
+        sprintf(failmsg, "%s: `%s' expected %s, got %s!", test->desc,
+                test->path, test->out ? test->out : "none",
+                oname ? oname : "none");
+        if (oname)
+            yasm_xfree(oname);
+        return 1;
+    }
+    if (oname)
+        yasm_xfree(oname);
+    return 0;
+}
+
+int
+main(void)
+{
+    int nf = 0;
+    int numtests = 0;
+    int i;
+
+    failed[0] = '\0';
+    printf("Test include_test: ");
+    for (i=0; i<(int)(sizeof(tests)/sizeof(Test_Entry)); i++) {
+        int fail = run_test(&tests[i]);
+        if (fail < 0)
+            continue;
+        printf("%c", fail>0 ? 'F':'.');
+        fflush(stdout);
+        if (fail)
+            sprintf(failed, "%s ** F: %s\n", failed, failmsg);
+        nf += fail;
+        numtests++;
+    }
+
+    /* Clean up (directories too, where remove() can) */
+    for (i=0; i<(int)(sizeof(tests)/sizeof(Test_Entry)); i++) {
+        if (tests[i].action == CREATE)
+            remove(tests[i].path);
+    }
+    remove(DIR_A);
+    remove(DIR_B);
+    remove(DIR_C);
+
+    printf(" +%d-%d/%d %d%%\n%s",
+           numtests-nf, nf, numtests, 100*(numtests-nf)/numtests, failed);
+    return (nf == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,351 @@
+/*
+ * Integer number tests
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/* Checks the direct literal parsing and value output paths in intnum.c
+ * against the bitvect conversions they stand in for.  With -b, times
+ * both instead.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libyasm/intnum.c"
+
+#define RANDOM_COUNT    20000
+#define BENCH_COUNT     1000000
+
+static const char *hex_literals[] = {
+    "", "0", "_", "7", "7fffffff", "80000000", "ffffffff", "1_0000_0000",
+    "123456789abcdef0", "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF",
+    "100000000000000000000000000000000",
+    "0000000000000000000000000000000000000000000042",
+    "8000000000000000000000000000000000000000000000000000000000000000",
+    "1ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+    "12g4", "-1"
+};
+
+static const char *dec_literals[] = {
+    "", "0", "9", "10000", "2147483647", "2147483648", "4294967296",
+    "340282366920938463463374607431768211455",
+    "340282366920938463463374607431768211456",
+    "0000000000000000000000000000000000000000000000000012",
+    "115792089237316195423570985008687907853269984665640564039457584007913129639935",
+    "115792089237316195423570985008687907853269984665640564039457584007913129639936",
+    "1_000", "-5", "+5", "12a"
+};
+
+static char failed[1000];
+static char failmsg[200];
+static unsigned long seed = 1;
+
+static unsigned long
+rnd(void)
+{
+    seed = (seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+    return seed >> 8;
+}
+
+static int
+intnum_same(const yasm_intnum *a, const yasm_intnum *b)
+{
+    if (a->type != b->type)
+        return 0;
+    if (a->type == INTNUM_L)
+        return a->val.l == b->val.l;
+    return BitVector_equal(a->val.bv, b->val.bv);
+}
+
+/* The conversions yasm_intnum_create_hex() and _dec() used to do */
+static yasm_intnum *
+ref_create(const char *str, int hex)
+{
+    yasm_intnum *intn = yasm_xmalloc(sizeof(yasm_intnum));
+    char *s = yasm__xstrdup(str);
+
+    if (hex)
+        BitVector_from_Hex(conv_bv, (unsigned char *)s);
+    else
+        BitVector_from_Dec_static(from_dec_data, conv_bv, (unsigned char *)s);
+    intnum_frombv(intn, conv_bv);
+    yasm_xfree(s);
+    return intn;
+}
+
+static int
+check_literal(const char *str, int hex)
+{
+    char *s = yasm__xstrdup(str);
+    yasm_intnum *intn = hex ? yasm_intnum_create_hex(s)
+                            : yasm_intnum_create_dec(s);
+    yasm_intnum *ref = ref_create(str, hex);
+    int same = intnum_same(intn, ref);
+
+    yasm_error_clear();
+    yasm_intnum_destroy(ref);
+    yasm_intnum_destroy(intn);
+    yasm_xfree(s);
+    if (!same) {
+        sprintf(failmsg, "%s literal `%.100s' differs", hex ? "hex" : "dec",
+                str);
+        return 1;
+    }
+    return 0;
+}
+
+static int
+test_literal_table(const char **literals, int count, int hex)
+{
+    int i;
+
+    for (i=0; i<count; i++) {
+        if (check_literal(literals[i], hex))
+            return 1;
+    }
+    return 0;
+}
+
+static void
+random_literal(char *str, int hex)
+{
+    static const char hexdigits[] = "0123456789abcdefABCDEF";
+    int len = (int)(rnd() % 48) + 1, i;
+
+    for (i=0; i<len; i++) {
+        if (hex && rnd() % 8 == 0)
+            str[i] = '_';
+        else if (hex)
+            str[i] = hexdigits[rnd() % 22];
+        else
+            str[i] = (char)('0' + rnd() % 10);
+    }
+    str[len] = '\0';
+}
+
+static int
+test_literal_random(int hex)
+{
+    char str[64];
+    int i;
+
+    for (i=0; i<RANDOM_COUNT; i++) {
+        random_literal(str, hex);
+        if (check_literal(str, hex))
+            return 1;
+    }
+    return 0;
+}
+
+/* Random value of up to 136 bits, possibly negated */
+static yasm_intnum *
+random_value(void)
+{
+    char str[64];
+    int len = (int)(rnd() % 34) + 1, i;
+    yasm_intnum *intn;
+
+    for (i=0; i<len; i++)
+        str[i] = "0123456789abcdef"[rnd() % 16];
+    str[len] = '\0';
+    intn = yasm_intnum_create_hex(str);
+    if (rnd() % 2)
+        yasm_intnum_calc(intn, YASM_EXPR_NEG, NULL);
+    return intn;
+}
+
+static int
+test_get_sized_random(void)
+{
+    unsigned char buf[32], refbuf[32];
+    yasm_intnum *intn, *copy;
+    size_t destsize, valsize, i;
+    int shift, n;
+
+    for (n=0; n<RANDOM_COUNT; n++) {
+        intn = random_value();
+        destsize = rnd() % 4 ? rnd() % 16 + 1 : rnd() % 32 + 1;
+        valsize = rnd() % 4 ? destsize*8 : rnd() % (destsize*8) + 1;
+        shift = (int)(rnd() % (destsize*8 - valsize + 1));
+        if (rnd() % 2)
+            shift &= ~7;
+        else if (rnd() % 4 == 0)
+            shift = -(int)(rnd() % 16);
+        for (i=0; i<sizeof(buf); i++)
+            buf[i] = refbuf[i] = (unsigned char)rnd();
+
+        /* the bitvect path can modify the value when shifting right */
+        copy = yasm_intnum_copy(intn);
+        yasm_intnum_get_sized(intn, buf, destsize, valsize, shift, 0, 0);
+        intnum_get_sized_bv(copy, refbuf, destsize, valsize, shift, 0, 0);
+        yasm_intnum_destroy(copy);
+        yasm_intnum_destroy(intn);
+        if (memcmp(buf, refbuf, sizeof(buf)) != 0) {
+            sprintf(failmsg, "get_sized(destsize=%lu, valsize=%lu, shift=%d)"
+                    " differs", (unsigned long)destsize,
+                    (unsigned long)valsize, shift);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static double
+elapsed(clock_t start)
+{
+    return (double)(clock()-start)/CLOCKS_PER_SEC;
+}
+
+static void
+bench_literals(const char *name, const char **literals, int count, int hex)
+{
+    clock_t start;
+    double fast, ref;
+    char *s[16];
+    int i, n;
+
+    for (i=0; i<count; i++)
+        s[i] = yasm__xstrdup(literals[i]);
+
+    start = clock();
+    for (n=0; n<BENCH_COUNT; n++) {
+        i = n % count;
+        yasm_intnum_destroy(hex ? yasm_intnum_create_hex(s[i])
+                                : yasm_intnum_create_dec(s[i]));
+    }
+    fast = elapsed(start);
+
+    start = clock();
+    for (n=0; n<BENCH_COUNT; n++)
+        yasm_intnum_destroy(ref_create(s[n % count], hex));
+    ref = elapsed(start);
+
+    for (i=0; i<count; i++)
+        yasm_xfree(s[i]);
+    printf("%-24s %8.1f ns %8.1f ns\n", name, fast*1e9/BENCH_COUNT,
+           ref*1e9/BENCH_COUNT);
+}
+
+static void
+bench_get_sized(const char *name, const char *hexval, size_t destsize)
+{
+    unsigned char buf[32];
+    char *s = yasm__xstrdup(hexval);
+    yasm_intnum *intn = yasm_intnum_create_hex(s);
+    clock_t start;
+    double fast, ref;
+    int n;
+
+    start = clock();
+    for (n=0; n<BENCH_COUNT; n++)
+        yasm_intnum_get_sized(intn, buf, destsize, destsize*8, 0, 0, 0);
+    fast = elapsed(start);
+
+    start = clock();
+    for (n=0; n<BENCH_COUNT; n++)
+        intnum_get_sized_bv(intn, buf, destsize, destsize*8, 0, 0, 0);
+    ref = elapsed(start);
+
+    yasm_intnum_destroy(intn);
+    yasm_xfree(s);
+    printf("%-24s %8.1f ns %8.1f ns\n", name, fast*1e9/BENCH_COUNT,
+           ref*1e9/BENCH_COUNT);
+}
+
+static void
+run_bench(void)
+{
+    static const char *short_hex[] = {"0", "ff", "1234", "7fffffff"};
+    static const char *wide_hex[] = {
+        "123456789abcdef0", "ffffffffffffffffffffffffffffffff"
+    };
+    static const char *short_dec[] = {"0", "10", "255", "65536"};
+    static const char *wide_dec[] = {
+        "18446744073709551615", "340282366920938463463374607431768211455"
+    };
+
+    printf("%-24s %11s %11s\n", "per operation", "direct", "bitvect");
+    bench_literals("hex literal, short", short_hex, 4, 1);
+    bench_literals("hex literal, 64-128 bit", wide_hex, 2, 1);
+    bench_literals("dec literal, short", short_dec, 4, 0);
+    bench_literals("dec literal, 64-128 bit", wide_dec, 2, 0);
+    bench_get_sized("get_sized, 32 bit", "12345678", 4);
+    bench_get_sized("get_sized, 64 bit", "123456789abcdef0", 8);
+    bench_get_sized("get_sized, 128 bit", "123456789abcdef0123456789abcdef",
+                    16);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int nf = 0, numtests = 0;
+    int i, fail;
+
+    if (BitVector_Boot() != ErrCode_Ok)
+        return EXIT_FAILURE;
+    yasm_intnum_initialize();
+
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        run_bench();
+        yasm_intnum_cleanup();
+        return EXIT_SUCCESS;
+    }
+
+    failed[0] = '\0';
+    printf("Test intnum_test: ");
+    for (i=0; i<5; i++) {
+        switch (i) {
+            case 0:
+                fail = test_literal_table(hex_literals,
+                    sizeof(hex_literals)/sizeof(hex_literals[0]), 1);
+                break;
+            case 1:
+                fail = test_literal_table(dec_literals,
+                    sizeof(dec_literals)/sizeof(dec_literals[0]), 0);
+                break;
+            case 2:
+                fail = test_literal_random(1);
+                break;
+            case 3:
+                fail = test_literal_random(0);
+                break;
+            default:
+                fail = test_get_sized_random();
+                break;
+        }
+        printf("%c", fail>0 ? 'F':'.');
+        fflush(stdout);
+        if (fail)
+            sprintf(failed, "%s ** F: %s\n", failed, failmsg);
+        nf += fail;
+        numtests++;
+    }
+
+    yasm_intnum_cleanup();
+
+    printf(" +%d-%d/%d %d%%\n%s",
+           numtests-nf, nf, numtests, 100*(numtests-nf)/numtests, failed);
+    return (nf == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
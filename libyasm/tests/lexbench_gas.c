@@ -0,0 +1,129 @@
+/*
+ * GAS scanner benchmark
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/* GAS scanner driver for assemble_bench -l: runs only gas_parser_lex() over
+ * already preprocessed lines, which it reads through a preprocessor that
+ * just hands them back.
+ */
+#include <util.h>
+
+#include <libyasm.h>
+
+#include "modules/parsers/gas/gas-parser.h"
+
+unsigned long lexbench_gas(yasm_object *object, yasm_linemap *linemap,
+                           yasm_errwarns *errwarns, char **lines,
+                           size_t num_lines);
+
+typedef struct replay_preproc {
+    yasm_preproc_base preproc;      /* base structure */
+
+    char **lines;
+    size_t num_lines, next;
+} replay_preproc;
+
+static char *
+replay_get_line(yasm_preproc *preproc)
+{
+    replay_preproc *pp = (replay_preproc *)preproc;
+
+    if (pp->next >= pp->num_lines)
+        return NULL;
+    return yasm__xstrdup(pp->lines[pp->next++]);
+}
+
+static yasm_preproc_module replay_module = {
+    "Replay preprocessed lines",
+    "replay",
+    NULL,
+    NULL,
+    replay_get_line,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static void
+destroy_token(int token, YYSTYPE *val)
+{
+    switch (token) {
+        case INTNUM:
+            yasm_intnum_destroy(val->intn);
+            break;
+        case FLTNUM:
+            yasm_floatnum_destroy(val->flt);
+            break;
+        case ID:
+        case LABEL:
+        case STRING:
+            yasm_xfree(val->str.contents);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Returns the number of tokens scanned. */
+unsigned long
+lexbench_gas(yasm_object *object, yasm_linemap *linemap,
+             yasm_errwarns *errwarns, char **lines, size_t num_lines)
+{
+    yasm_parser_gas parser_gas;
+    replay_preproc pp;
+    YYSTYPE val;
+    unsigned long tokens = 0;
+    int token;
+
+    pp.preproc.module = &replay_module;
+    pp.lines = lines;
+    pp.num_lines = num_lines;
+    pp.next = 0;
+
+    memset(&parser_gas, 0, sizeof(parser_gas));
+    parser_gas.object = object;
+    parser_gas.linemap = linemap;
+    parser_gas.preproc = (yasm_preproc *)&pp;
+    parser_gas.errwarns = errwarns;
+    parser_gas.peek_token = NONE;
+    parser_gas.line = NULL;
+    yasm_scanner_initialize(&parser_gas.s);
+    parser_gas.state = INITIAL;
+
+    do {
+        token = gas_parser_lex(&val, &parser_gas);
+        destroy_token(token, &val);
+        tokens++;
+    } while (token != 0);
+
+    yasm_scanner_delete(&parser_gas.s);
+    if (parser_gas.locallabel_base)
+        yasm_xfree(parser_gas.locallabel_base);
+    return tokens;
+}
@@ -0,0 +1,118 @@
+/*
+ * NASM scanner benchmark
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/* NASM scanner driver for assemble_bench -l: runs only nasm_parser_lex()
+ * over already preprocessed lines, as nasm_parser_parse() would feed it.
+ */
+#include <util.h>
+
+#include <libyasm.h>
+
+#include "modules/parsers/nasm/nasm-parser.h"
+
+unsigned long lexbench_nasm(yasm_object *object, yasm_linemap *linemap,
+                            yasm_errwarns *errwarns, char **lines,
+                            size_t num_lines);
+
+static void
+destroy_token(int token, YYSTYPE *val)
+{
+    switch (token) {
+        case INTNUM:
+            yasm_intnum_destroy(val->intn);
+            break;
+        case FLTNUM:
+            yasm_floatnum_destroy(val->flt);
+            break;
+        case DIRECTIVE_NAME:
+        case FILENAME:
+        case ID:
+        case LOCAL_ID:
+        case SPECIAL_ID:
+        case NONLOCAL_ID:
+            yasm_xfree(val->str_val);
+            break;
+        case STRING:
+            yasm_xfree(val->str.contents);
+            break;
+        case INSN:
+            yasm_bc_destroy(val->bc);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Returns the number of tokens scanned. */
+unsigned long
+lexbench_nasm(yasm_object *object, yasm_linemap *linemap,
+              yasm_errwarns *errwarns, char **lines, size_t num_lines)
+{
+    yasm_parser_nasm parser_nasm;
+    YYSTYPE val;
+    unsigned char *buf = NULL;
+    size_t bufsize = 0, i;
+    unsigned long tokens = 0;
+    int token;
+
+    memset(&parser_nasm, 0, sizeof(parser_nasm));
+    parser_nasm.object = object;
+    parser_nasm.linemap = linemap;
+    parser_nasm.errwarns = errwarns;
+    parser_nasm.peek_token = NONE;
+    yasm_scanner_initialize(&parser_nasm.s);
+
+    for (i=0; i<num_lines; i++) {
+        /* The scanner may modify the line, so give it a fresh copy (as the
+         * preprocessor does).
+         */
+        size_t len = strlen(lines[i]);
+        if (len+1 > bufsize) {
+            bufsize = len+1;
+            buf = yasm_xrealloc(buf, bufsize);
+        }
+        memcpy(buf, lines[i], len+1);
+
+        parser_nasm.s.bot = buf;
+        parser_nasm.s.tok = buf;
+        parser_nasm.s.ptr = buf;
+        parser_nasm.s.cur = buf;
+        parser_nasm.s.lim = buf + len+1;
+        parser_nasm.s.top = parser_nasm.s.lim;
+        parser_nasm.state = INITIAL;
+        do {
+            token = nasm_parser_lex(&val, &parser_nasm);
+            destroy_token(token, &val);
+            tokens++;
+        } while (token != 0);
+    }
+
+    if (parser_nasm.locallabel_base)
+        yasm_xfree(parser_nasm.locallabel_base);
+    if (buf)
+        yasm_xfree(buf);
+    return tokens;
+}
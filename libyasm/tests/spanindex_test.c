@@ -0,0 +1,265 @@
+/*
+ * Span index tests
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/* Checks that the optimizer's span index (in section.c) reports the same
+ * terms in the same order as the IntervalTree it replaced, since with align
+ * and org the optimizer's result depends on that order.  With -b, times
+ * both on the intervals of jump-heavy code instead.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libyasm/section.c"
+#include "libyasm/inttree.h"
+
+#define RANDOM_COUNT    200
+#define BENCH_JUMPS     300000
+
+static char failed[1000];
+static char failmsg[200];
+static unsigned long seed = 1;
+
+static unsigned long
+rnd(void)
+{
+    seed = (seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+    return seed >> 8;
+}
+
+/* Terms stand in for themselves; only their addresses are compared */
+static yasm_span_term *terms;
+
+typedef struct found_list {
+    size_t *seq;
+    size_t num;
+} found_list;
+
+static void
+found_term(yasm_span_term *term, void *d)
+{
+    found_list *fl = d;
+    fl->seq[fl->num++] = (size_t)(term-terms);
+}
+
+static void
+found_node(IntervalTreeNode *node, void *d)
+{
+    found_term(node->data, d);
+}
+
+static void
+count_term(yasm_span_term *term, void *d)
+{
+    (*(unsigned long *)d)++;
+}
+
+static void
+count_node(IntervalTreeNode *node, void *d)
+{
+    (*(unsigned long *)d)++;
+}
+
+/* Intervals as the optimizer adds them for jumps (or other span terms)
+ * between nearby bytecodes, in bytecode order.  Many share a low.
+ */
+static void
+jump_intervals(long *low, long *high, size_t n, unsigned long reach)
+{
+    size_t i;
+
+    for (i=0; i<n; i++) {
+        long bc = (long)i, tgt;
+        unsigned long span = rnd() % 4 ? reach : reach*20;
+
+        tgt = bc + (long)(rnd() % (2*span+1)) - (long)span;
+        if (tgt < 0)
+            tgt = 0;
+        if (tgt == bc)
+            tgt++;
+        low[i] = (tgt < bc ? tgt : bc) + 1;
+        high[i] = tgt < bc ? bc : tgt;
+    }
+}
+
+static int
+test_order(size_t n, unsigned long reach)
+{
+    long *low = yasm_xmalloc(n*sizeof(long));
+    long *high = yasm_xmalloc(n*sizeof(long));
+    found_list ref, got;
+    IntervalTree *it = IT_create();
+    span_index idx;
+    size_t i;
+    long p;
+    int fail = 0;
+
+    jump_intervals(low, high, n, reach);
+    span_index_initialize(&idx);
+    for (i=0; i<n; i++) {
+        IT_insert(it, low[i], high[i], &terms[i]);
+        span_index_add(&idx, low[i], high[i], &terms[i]);
+    }
+    span_index_build(&idx);
+
+    ref.seq = yasm_xmalloc((n+1)*sizeof(size_t));
+    got.seq = yasm_xmalloc((n+1)*sizeof(size_t));
+    for (p=-1; p<=(long)n+1 && !fail; p++) {
+        ref.num = got.num = 0;
+        IT_enumerate(it, p, p, &ref, found_node);
+        span_index_enumerate(&idx, p, &got, found_term);
+        if (ref.num != got.num ||
+            memcmp(ref.seq, got.seq, ref.num*sizeof(size_t)) != 0) {
+            sprintf(failmsg, "%lu intervals (reach %lu): point %ld differs",
+                    (unsigned long)n, reach, p);
+            fail = 1;
+        }
+    }
+
+    yasm_xfree(ref.seq);
+    yasm_xfree(got.seq);
+    span_index_cleanup(&idx);
+    IT_destroy(it);
+    yasm_xfree(low);
+    yasm_xfree(high);
+    return fail;
+}
+
+static int
+test_order_random(void)
+{
+    int i;
+
+    for (i=0; i<RANDOM_COUNT; i++) {
+        if (test_order(rnd() % 500, 1 + rnd() % 40))
+            return 1;
+    }
+    return 0;
+}
+
+static double
+elapsed(clock_t start)
+{
+    return (double)(clock()-start)/CLOCKS_PER_SEC;
+}
+
+static void
+run_bench(void)
+{
+    long *low = yasm_xmalloc(BENCH_JUMPS*sizeof(long));
+    long *high = yasm_xmalloc(BENCH_JUMPS*sizeof(long));
+    IntervalTree *it;
+    span_index idx;
+    clock_t start;
+    double it_build, it_query, it_free, si_build, si_query, si_free;
+    unsigned long it_found = 0, si_found = 0;
+    size_t i;
+
+    jump_intervals(low, high, BENCH_JUMPS, 20);
+
+    start = clock();
+    it = IT_create();
+    for (i=0; i<BENCH_JUMPS; i++)
+        IT_insert(it, low[i], high[i], &terms[i]);
+    it_build = elapsed(start);
+    start = clock();
+    for (i=0; i<BENCH_JUMPS; i++)
+        IT_enumerate(it, (long)i, (long)i, &it_found, count_node);
+    it_query = elapsed(start);
+    start = clock();
+    IT_destroy(it);
+    it_free = elapsed(start);
+
+    start = clock();
+    span_index_initialize(&idx);
+    for (i=0; i<BENCH_JUMPS; i++)
+        span_index_add(&idx, low[i], high[i], &terms[i]);
+    span_index_build(&idx);
+    si_build = elapsed(start);
+    start = clock();
+    for (i=0; i<BENCH_JUMPS; i++)
+        span_index_enumerate(&idx, (long)i, &si_found, count_term);
+    si_query = elapsed(start);
+    start = clock();
+    span_index_cleanup(&idx);
+    si_free = elapsed(start);
+
+    yasm_xfree(low);
+    yasm_xfree(high);
+    printf("%d jump intervals, one query per bytecode (%lu/%lu found)\n",
+           BENCH_JUMPS, si_found, it_found);
+    printf("%-8s %11s %11s\n", "", "span_index", "inttree");
+    printf("%-8s %8.1f ms %8.1f ms\n", "build", si_build*1e3, it_build*1e3);
+    printf("%-8s %8.1f ms %8.1f ms\n", "query", si_query*1e3, it_query*1e3);
+    printf("%-8s %8.1f ms %8.1f ms\n", "free", si_free*1e3, it_free*1e3);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int nf = 0, numtests = 0;
+    int i, fail;
+
+    terms = yasm_xmalloc(BENCH_JUMPS*sizeof(yasm_span_term));
+
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        run_bench();
+        yasm_xfree(terms);
+        return EXIT_SUCCESS;
+    }
+
+    failed[0] = '\0';
+    printf("Test spanindex_test: ");
+    for (i=0; i<4; i++) {
+        switch (i) {
+            case 0:
+                fail = test_order(0, 1);
+                break;
+            case 1:
+                fail = test_order(1, 1);
+                break;
+            case 2:
+                fail = test_order(5000, 20);
+                break;
+            default:
+                fail = test_order_random();
+                break;
+        }
+        printf("%c", fail>0 ? 'F':'.');
+        fflush(stdout);
+        if (fail)
+            sprintf(failed, "%s ** F: %s\n", failed, failmsg);
+        nf += fail;
+        numtests++;
+    }
+
+    yasm_xfree(terms);
+
+    printf(" +%d-%d/%d %d%%\n%s",
+           numtests-nf, nf, numtests, 100*(numtests-nf)/numtests, failed);
+    return (nf == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -38,48 +38,55 @@ typedef struct x86_checkea_reg3264_data {
     unsigned char addrsize;
 } x86_checkea_reg3264_data;
 
-/* Only works if ei->type == EXPR_REG (doesn't check).
- * Overwrites ei with intnum of 0 (to eliminate regs from the final expr).
+/* Returns the index into data->regs for a register used in a 32/64-bit
+ * effective address, or -1 if the register can't be used there.
  */
-static /*@null@*/ /*@dependent@*/ int *
-x86_expr_checkea_get_reg3264(yasm_expr__item *ei, int *regnum,
-                             /*returned*/ void *d)
+static int
+x86_expr_checkea_reg3264_num(uintptr_t reg,
+                             const x86_checkea_reg3264_data *data)
 {
-    x86_checkea_reg3264_data *data = d;
-
-    switch ((x86_expritem_reg_size)(ei->data.reg & ~0xFUL)) {
+    switch ((x86_expritem_reg_size)(reg & ~0xFUL)) {
         case X86_REG32:
             if (data->addrsize != 32)
-                return 0;
-            *regnum = (unsigned int)(ei->data.reg & 0xF);
-            break;
+                return -1;
+            return (int)(reg & 0xF);
         case X86_REG64:
             if (data->addrsize != 64)
-                return 0;
-            *regnum = (unsigned int)(ei->data.reg & 0xF);
-            break;
+                return -1;
+            return (int)(reg & 0xF);
         case X86_XMMREG:
             if (data->vsib_mode != 1)
-                return 0;
-            if (data->bits != 64 && (ei->data.reg & 0x8) == 0x8)
-                return 0;
-            *regnum = 17+(unsigned int)(ei->data.reg & 0xF);
-            break;
+                return -1;
+            if (data->bits != 64 && (reg & 0x8) == 0x8)
+                return -1;
+            return 17+(int)(reg & 0xF);
         case X86_YMMREG:
             if (data->vsib_mode != 2)
-                return 0;
-            if (data->bits != 64 && (ei->data.reg & 0x8) == 0x8)
-                return 0;
-            *regnum = 17+(unsigned int)(ei->data.reg & 0xF);
-            break;
+                return -1;
+            if (data->bits != 64 && (reg & 0x8) == 0x8)
+                return -1;
+            return 17+(int)(reg & 0xF);
         case X86_RIP:
             if (data->bits != 64)
-                return 0;
-            *regnum = 16;
-            break;
+                return -1;
+            return 16;
         default:
-            return 0;
+            return -1;
     }
+}
+
+/* Only works if ei->type == EXPR_REG (doesn't check).
+ * Overwrites ei with intnum of 0 (to eliminate regs from the final expr).
+ */
+static /*@null@*/ /*@dependent@*/ int *
+x86_expr_checkea_get_reg3264(yasm_expr__item *ei, int *regnum,
+                             /*returned*/ void *d)
+{
+    x86_checkea_reg3264_data *data = d;
+
+    *regnum = x86_expr_checkea_reg3264_num(ei->data.reg, data);
+    if (*regnum < 0)
+        return 0;
 
     /* overwrite with 0 to eliminate register from displacement expr */
     ei->type = YASM_EXPR_INT;
@@ -426,6 +433,119 @@ x86_expr_checkea_getregusage(yasm_expr **ep, /*@null@*/ int *indexreg,
     return 0;
 }
 
+/* Most terms in an effective address handled by the fast path below; a
+ * valid one rarely has more than three.
+ */
+#define SIMPLE_EA_MAXTERMS  8
+
+/* Fast path of x86_expr_checkea_getregusage() for 32/64-bit addresses.
+ * Handles the common register-plus-constant forms ([reg], [reg+disp],
+ * [reg+reg*scale+disp]) as already leveled by yasm_value_finalize(): an
+ * IDENT or ADD of registers, reg*int products and at most one integer.
+ * Register multipliers and indexreg are accumulated exactly as the general
+ * path would, and the expression is replaced by its integer part without
+ * re-leveling the tree.
+ * Returns 0 if handled, 1 if the general path must be used (in which case
+ * nothing has been modified).
+ */
+static int
+x86_expr_checkea_simple_regusage(yasm_expr **ep, int *indexreg,
+                                 x86_checkea_reg3264_data *data)
+{
+    yasm_expr *e = *ep;
+    yasm_expr *mul;
+    yasm_intnum *disp = NULL;
+    int regnum[SIMPLE_EA_MAXTERMS];
+    long mult[SIMPLE_EA_MAXTERMS];
+    int indexval = 0;
+    int indexmult = 0;
+    int i;
+
+    if ((e->op != YASM_EXPR_ADD && e->op != YASM_EXPR_IDENT) ||
+        e->numterms > SIMPLE_EA_MAXTERMS)
+        return 1;
+
+    /* Check every term before touching anything */
+    for (i=0; i<e->numterms; i++) {
+        switch (e->terms[i].type) {
+            case YASM_EXPR_REG:
+                regnum[i] = x86_expr_checkea_reg3264_num(e->terms[i].data.reg,
+                                                         data);
+                if (regnum[i] < 0)
+                    return 1;
+                mult[i] = 0;
+                break;
+            case YASM_EXPR_INT:
+                if (disp)
+                    return 1;
+                disp = e->terms[i].data.intn;
+                regnum[i] = -1;
+                break;
+            case YASM_EXPR_EXPR:
+                mul = e->terms[i].data.expn;
+                if (mul->op != YASM_EXPR_MUL || mul->numterms != 2)
+                    return 1;
+                if (mul->terms[0].type == YASM_EXPR_REG &&
+                    mul->terms[1].type == YASM_EXPR_INT) {
+                    regnum[i] = x86_expr_checkea_reg3264_num
+                        (mul->terms[0].data.reg, data);
+                    mult[i] = yasm_intnum_get_int(mul->terms[1].data.intn);
+                } else if (mul->terms[0].type == YASM_EXPR_INT &&
+                           mul->terms[1].type == YASM_EXPR_REG) {
+                    regnum[i] = x86_expr_checkea_reg3264_num
+                        (mul->terms[1].data.reg, data);
+                    mult[i] = yasm_intnum_get_int(mul->terms[0].data.intn);
+                } else
+                    return 1;
+                if (regnum[i] < 0)
+                    return 1;
+                break;
+            default:
+                return 1;
+        }
+    }
+
+    /* Accumulate register usage; same indexreg choice as the general path */
+    for (i=0; i<e->numterms; i++) {
+        int *reg;
+
+        if (regnum[i] < 0)
+            continue;
+        reg = &data->regs[regnum[i]];
+        if (e->terms[i].type == YASM_EXPR_REG) {
+            (*reg)++;
+            if (*reg > 0 && indexval <= *reg && !indexmult) {
+                *indexreg = regnum[i];
+                indexval = *reg;
+            }
+        } else {
+            (*reg) += mult[i];
+            if (mult[i] > 0 && indexval <= *reg) {
+                *indexreg = regnum[i];
+                indexval = *reg;
+                indexmult = 1;
+            } else if (*indexreg == regnum[i] && mult[i] < 0 && *reg <= 1) {
+                *indexreg = -1;
+                indexval = 0;
+                indexmult = 0;
+            }
+        }
+    }
+
+    /* What's left is just the displacement */
+    if (e->op == YASM_EXPR_IDENT && disp)
+        return 0;
+    if (disp) {
+        for (i=0; e->terms[i].type != YASM_EXPR_INT; i++)
+            ;
+        e->terms[i].type = YASM_EXPR_NONE;  /* don't delete it! */
+    } else
+        disp = yasm_intnum_create_uint(0);
+    *ep = yasm_expr_create_ident(yasm_expr_int(disp), e->line);
+    yasm_expr_destroy(e);
+    return 0;
+}
+
 /* Calculate the displacement length, if possible.
  * Takes several extra inputs so it can be used by both 32-bit and 16-bit
  * expressions:
@@ -693,7 +813,9 @@ yasm_x86__expr_checkea(x86_effaddr *x86_ea, unsigned char *addrsize,
         reg3264_data.vsib_mode = x86_ea->vsib_mode;
         reg3264_data.bits = bits;
         reg3264_data.addrsize = *addrsize;
-        if (x86_ea->ea.disp.abs) {
+        if (x86_ea->ea.disp.abs &&
+            x86_expr_checkea_simple_regusage(&x86_ea->ea.disp.abs, &indexreg,
+                                             &reg3264_data) != 0) {
             int pcrel = 0;
             switch (x86_expr_checkea_getregusage
                     (&x86_ea->ea.disp.abs, &indexreg, &pcrel, bits,
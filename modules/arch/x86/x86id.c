@@ -24,7 +24,6 @@
  * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
  */
-#include <ctype.h>
 #include <util.h>
 
 #include <libyasm.h>
@@ -1795,27 +1794,22 @@ yasm_x86__parse_check_insnprefix(yasm_arch *arch, const char *id,
 {
     yasm_arch_x86 *arch_x86 = (yasm_arch_x86 *)arch;
     /*@null@*/ const insnprefix_parse_data *pdata;
-    size_t i;
-    static char lcaseid[17];
 
     *bc = (yasm_bytecode *)NULL;
     *prefix = 0;
 
     if (id_len > 16)
         return YASM_ARCH_NOTINSNPREFIX;
-    for (i=0; i<id_len; i++)
-        lcaseid[i] = tolower(id[i]);
-    lcaseid[id_len] = '\0';
 
     switch (PARSER(arch_x86)) {
         case X86_PARSER_NASM:
-            pdata = insnprefix_nasm_find(lcaseid, id_len);
+            pdata = insnprefix_nasm_find(id, id_len);
             break;
         case X86_PARSER_TASM:
-            pdata = insnprefix_nasm_find(lcaseid, id_len);
+            pdata = insnprefix_nasm_find(id, id_len);
             break;
         case X86_PARSER_GAS:
-            pdata = insnprefix_gas_find(lcaseid, id_len);
+            pdata = insnprefix_gas_find(id, id_len);
             break;
         default:
             pdata = NULL;
@@ -0,0 +1,8 @@
+; Current position references must not look like labels to the line
+; number program.
+section .text
+	mov eax, $
+	jmp $
+foo:
+	nop
+	mov ebx, $-foo
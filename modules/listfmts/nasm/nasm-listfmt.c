@@ -39,17 +39,31 @@
 
 #define REGULAR_BUF_SIZE    1024
 
+/* Maximum number of characters of encoded bytes on one listing line */
+#define BYTES_WIDTH         18
+
 yasm_listfmt_module yasm_nasm_LTX_listfmt;
 
+/* Relocation position reached in a section, kept as section associated
+ * data so switching sections doesn't search the other sections.
+ */
 typedef struct sectreloc {
     /*@reldef@*/ SLIST_ENTRY(sectreloc) link;
     yasm_section *sect;
+    unsigned long next_reloc_idx;       /* index of next relocation */
     /*@null@*/ yasm_reloc *next_reloc;  /* next relocation in section */
     unsigned long next_reloc_addr;
 } sectreloc;
 
+static void sectreloc_destroy(/*@only@*/ void *data);
+static void sectreloc_print(void *data, FILE *f, int indent_level);
+
+static const yasm_assoc_data_callback sectreloc_cb = {
+    sectreloc_destroy,
+    sectreloc_print
+};
+
 typedef struct bcreloc {
-    /*@reldef@*/ STAILQ_ENTRY(bcreloc) link;
     unsigned long offset;       /* start of reloc from start of bytecode */
     size_t size;                /* size of reloc in bytes */
     int rel;                    /* PC/IP-relative or "absolute" */
@@ -57,7 +71,14 @@ typedef struct bcreloc {
 
 typedef struct nasm_listfmt_output_info {
     yasm_arch *arch;
-    /*@reldef@*/ STAILQ_HEAD(bcrelochead, bcreloc) bcrelocs;
+
+    /* relocations in the bytecode being output; reused for each bytecode */
+    /*@only@*/ bcreloc *bcrelocs;
+    size_t num_bcrelocs;
+    size_t size_bcrelocs;
+
+    yasm_section *sect;
+    unsigned long next_reloc_idx;       /* index of next relocation */
     /*@null@*/ yasm_reloc *next_reloc;  /* next relocation in section */
     unsigned long next_reloc_addr;
 } nasm_listfmt_output_info;
@@ -77,6 +98,21 @@ nasm_listfmt_destroy(/*@only@*/ yasm_listfmt *listfmt)
     yasm_xfree(listfmt);
 }
 
+static void
+sectreloc_destroy(void *data)
+{
+    yasm_xfree(data);
+}
+
+static void
+sectreloc_print(void *data, FILE *f, int indent_level)
+{
+    sectreloc *hist = (sectreloc *)data;
+
+    fprintf(f, "%*snext_reloc_idx=%lu\n", indent_level, "",
+            hist->next_reloc_idx);
+}
+
 static int
 nasm_listfmt_output_value(yasm_value *value, unsigned char *buf,
                           unsigned int destsize, unsigned long offset,
@@ -101,19 +137,24 @@ nasm_listfmt_output_value(yasm_value *value, unsigned char *buf,
 
     /* Generate reloc if needed */
     if (info->next_reloc && info->next_reloc_addr == bc->offset+offset) {
-        bcreloc *reloc = yasm_xmalloc(sizeof(bcreloc));
+        bcreloc *reloc;
+
+        if (info->num_bcrelocs >= info->size_bcrelocs) {
+            info->size_bcrelocs *= 2;
+            info->bcrelocs = yasm_xrealloc(info->bcrelocs,
+                info->size_bcrelocs*sizeof(bcreloc));
+        }
+        reloc = &info->bcrelocs[info->num_bcrelocs++];
         reloc->offset = offset;
         reloc->size = destsize;
         reloc->rel = value->curpos_rel;
-        STAILQ_INSERT_TAIL(&info->bcrelocs, reloc, link);
 
         /* Get next reloc's info */
-        info->next_reloc = yasm_section_reloc_next(info->next_reloc);
+        info->next_reloc = yasm_section_get_reloc(info->sect,
+                                                  ++info->next_reloc_idx);
         if (info->next_reloc) {
-            yasm_intnum *addr;
             yasm_symrec *sym;
-            yasm_reloc_get(info->next_reloc, &addr, &sym);
-            info->next_reloc_addr = yasm_intnum_get_uint(addr);
+            yasm_reloc_get(info->next_reloc, &info->next_reloc_addr, &sym);
         }
     }
 
@@ -143,6 +184,7 @@ static void
 nasm_listfmt_output(yasm_listfmt *listfmt, FILE *f, yasm_linemap *linemap,
                     yasm_arch *arch)
 {
+    static const char hexdigits[] = "0123456789ABCDEF";
     yasm_bytecode *bc;
     const char *source;
     unsigned long line = 1;
@@ -151,12 +193,16 @@ nasm_listfmt_output(yasm_listfmt *listfmt, FILE *f, yasm_linemap *linemap,
     nasm_listfmt_output_info info;
     /*@reldef@*/ SLIST_HEAD(sectrelochead, sectreloc) reloc_hist;
     /*@null@*/ sectreloc *last_hist = NULL;
-    /*@null@*/ bcreloc *reloc = NULL;
+    /*@null@*/ bcreloc *reloc, *reloc_end;
     yasm_section *sect;
+    /* line number, address, bytes with reloc markers and padding */
+    char outline[64+BYTES_WIDTH*2];
 
     SLIST_INIT(&reloc_hist);
 
     info.arch = arch;
+    info.size_bcrelocs = 8;
+    info.bcrelocs = yasm_xmalloc(info.size_bcrelocs*sizeof(bcreloc));
 
     buf = yasm_xmalloc(REGULAR_BUF_SIZE);
 
@@ -167,37 +213,30 @@ nasm_listfmt_output(yasm_listfmt *listfmt, FILE *f, yasm_linemap *linemap,
             /* get the next relocation for the bytecode's section */
             sect = yasm_bc_get_section(bc);
             if (!last_hist || last_hist->sect != sect) {
-                int found = 0;
-
-                /* look through reloc_hist for matching section */
-                SLIST_FOREACH(last_hist, &reloc_hist, link) {
-                    if (last_hist->sect == sect) {
-                        found = 1;
-                        break;
-                    }
-                }
-
-                if (!found) {
-                    /* not found, add to list*/
+                last_hist = yasm_section_get_data(sect, &sectreloc_cb);
+                if (!last_hist) {
+                    /* first line in this section */
                     last_hist = yasm_xmalloc(sizeof(sectreloc));
                     last_hist->sect = sect;
-                    last_hist->next_reloc = yasm_section_relocs_first(sect);
+                    last_hist->next_reloc_idx = 0;
+                    last_hist->next_reloc = yasm_section_get_reloc(sect, 0);
 
                     if (last_hist->next_reloc) {
-                        yasm_intnum *addr;
                         yasm_symrec *sym;
-                        yasm_reloc_get(last_hist->next_reloc, &addr, &sym);
-                        last_hist->next_reloc_addr =
-                            yasm_intnum_get_uint(addr);
+                        yasm_reloc_get(last_hist->next_reloc,
+                                       &last_hist->next_reloc_addr, &sym);
                     }
 
+                    yasm_section_add_data(sect, &sectreloc_cb, last_hist);
                     SLIST_INSERT_HEAD(&reloc_hist, last_hist, link);
                 }
             }
 
+            info.sect = sect;
+            info.next_reloc_idx = last_hist->next_reloc_idx;
             info.next_reloc = last_hist->next_reloc;
             info.next_reloc_addr = last_hist->next_reloc_addr;
-            STAILQ_INIT(&info.bcrelocs);
+            info.num_bcrelocs = 0;
 
             /* loop over bytecodes on this line (usually only one) */
             while (bc && bc->line == line) {
@@ -222,43 +261,60 @@ nasm_listfmt_output(yasm_listfmt *listfmt, FILE *f, yasm_linemap *linemap,
                 /* output bytes with reloc information */
                 origp = bigbuf ? bigbuf : buf;
                 p = origp;
-                reloc = STAILQ_FIRST(&info.bcrelocs);
+                reloc = info.bcrelocs;
+                reloc_end = info.bcrelocs + info.num_bcrelocs;
+                if (reloc == reloc_end)
+                    reloc = NULL;
                 if (gap) {
                     fprintf(f, "%6lu %08lX <gap>%*s%s\n", listline++, offset,
                             18, "", source ? source : "");
                 } else while (size > 0) {
-                    int i;
+                    /* format each line into outline and write it at once */
+                    char *o = outline;
+                    int i, pad;
 
-                    fprintf(f, "%6lu %08lX ", listline++, offset);
-                    for (i=0; i<18 && size > 0; size--) {
+                    sprintf(o, "%6lu %08lX ", listline++, offset);
+                    o += strlen(o);
+                    for (i=0; i<BYTES_WIDTH && size > 0; size--) {
                         if (reloc && (unsigned long)(p-origp) ==
                                      reloc->offset) {
-                            fprintf(f, "%c", reloc->rel ? '(' : '[');
+                            *o++ = reloc->rel ? '(' : '[';
                             i++;
                         }
-                        fprintf(f, "%02X", *(p++));
+                        *o++ = hexdigits[*p >> 4];
+                        *o++ = hexdigits[*p & 0xF];
+                        p++;
                         i+=2;
                         if (reloc && (unsigned long)(p-origp) ==
                                      reloc->offset+reloc->size) {
-                            fprintf(f, "%c", reloc->rel ? ')' : ']');
+                            *o++ = reloc->rel ? ')' : ']';
                             i++;
-                            reloc = STAILQ_NEXT(reloc, link);
+                            if (++reloc == reloc_end)
+                                reloc = NULL;
                         }
                     }
                     if (size > 0)
-                        fprintf(f, "-");
+                        *o++ = '-';
                     else {
                         if (multiple > 1) {
-                            fprintf(f, "<rept>");
+                            strcpy(o, "<rept>");
+                            o += 6;
                             i += 6;
                         }
-                        fprintf(f, "%*s", 18-i+1, "");
+                        /* matches printf("%*s", ...) with a negative width */
+                        pad = BYTES_WIDTH-i+1;
+                        if (pad < 0)
+                            pad = -pad;
+                        memset(o, ' ', (size_t)pad);
+                        o += pad;
                     }
+                    fwrite(outline, 1, (size_t)(o-outline), f);
                     if (source) {
-                        fprintf(f, "    %s", source);
+                        fputs("    ", f);
+                        fputs(source, f);
                         source = NULL;
                     }
-                    fprintf(f, "\n");
+                    putc('\n', f);
                 }
 
                 if (bigbuf)
@@ -266,28 +322,22 @@ nasm_listfmt_output(yasm_listfmt *listfmt, FILE *f, yasm_linemap *linemap,
                 bc = STAILQ_NEXT(bc, link);
             }
 
-            /* delete bcrelocs (newly generated next bytecode if any) */
-            reloc = STAILQ_FIRST(&info.bcrelocs);
-            while (reloc) {
-                bcreloc *reloc2 = STAILQ_NEXT(reloc, link);
-                yasm_xfree(reloc);
-                reloc = reloc2;
-            }
-
             /* save reloc context */
+            last_hist->next_reloc_idx = info.next_reloc_idx;
             last_hist->next_reloc = info.next_reloc;
             last_hist->next_reloc_addr = info.next_reloc_addr;
         }
         line++;
     }
 
-    /* delete reloc history */
+    /* delete reloc history, detaching it from the sections */
     while (!SLIST_EMPTY(&reloc_hist)) {
         last_hist = SLIST_FIRST(&reloc_hist);
         SLIST_REMOVE_HEAD(&reloc_hist, link);
-        yasm_xfree(last_hist);
+        yasm_section_add_data(last_hist->sect, &sectreloc_cb, NULL);
     }
 
+    yasm_xfree(info.bcrelocs);
     yasm_xfree(buf);
 }
 
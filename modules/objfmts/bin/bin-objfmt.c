@@ -1040,6 +1040,16 @@ bin_objfmt_no_output_bytecode(yasm_bytecode *bc, /*@null@*/ void *d)
 
     /* Warn if not a gap. */
     if (!gap) {
+        const unsigned long *lines;
+        unsigned long num, i;
+
+        /* Data merged from later lines is warned about at each of them */
+        lines = yasm_bc_data_merged_lines(bc, &num);
+        for (i=0; i<num; i++) {
+            yasm_warn_set(YASM_WARN_GENERAL,
+                N_("initialized space declared in nobits section: ignoring"));
+            yasm_errwarn_propagate(info->errwarns, lines[i]);
+        }
         yasm_warn_set(YASM_WARN_GENERAL,
             N_("initialized space declared in nobits section: ignoring"));
     }
@@ -0,0 +1,10 @@
+; Data in a nobits section is warned about on every line, including
+; consecutive constant data lines that share a bytecode
+db 0x90
+section .bss nobits
+db 1
+db 2
+db ""
+dw 3, 4
+x: db 5
+db 6
@@ -469,7 +469,7 @@ coff_objfmt_output_value(yasm_value *value, unsigned char *buf,
         yasm_sym_vis vis = yasm_symrec_get_visibility(value->rel);
         /*@dependent@*/ /*@null@*/ yasm_symrec *sym = value->rel;
         unsigned long addr;
-        coff_reloc *reloc;
+        coff_reloc reloc;
         int nobase = info->csd->flags2 & COFF_FLAG_NOBASE;
 
         /* Sometimes we want the relocation to be generated against one
@@ -558,15 +558,14 @@ coff_objfmt_output_value(yasm_value *value, unsigned char *buf,
         }
 
         /* Generate reloc */
-        reloc = yasm_xmalloc(sizeof(coff_reloc));
         addr = bc->offset + offset;
-        reloc->reloc.addr = yasm_intnum_create_uint(addr);
-        reloc->reloc.sym = sym;
+        reloc.reloc.addr = addr;
+        reloc.reloc.sym = sym;
 
         if (value->curpos_rel) {
             if (objfmt_coff->machine == COFF_MACHINE_I386) {
                 if (valsize == 32)
-                    reloc->type = COFF_RELOC_I386_REL32;
+                    reloc.type = COFF_RELOC_I386_REL32;
                 else {
                     yasm_error_set(YASM_ERROR_TYPE,
                                    N_("coff: invalid relocation size"));
@@ -579,25 +578,25 @@ coff_objfmt_output_value(yasm_value *value, unsigned char *buf,
                     return 1;
                 }
                 if (!value->ip_rel)
-                    reloc->type = COFF_RELOC_AMD64_REL32;
+                    reloc.type = COFF_RELOC_AMD64_REL32;
                 else switch (bc->len*bc->mult_int - (offset+destsize)) {
                     case 0:
-                        reloc->type = COFF_RELOC_AMD64_REL32;
+                        reloc.type = COFF_RELOC_AMD64_REL32;
                         break;
                     case 1:
-                        reloc->type = COFF_RELOC_AMD64_REL32_1;
+                        reloc.type = COFF_RELOC_AMD64_REL32_1;
                         break;
                     case 2:
-                        reloc->type = COFF_RELOC_AMD64_REL32_2;
+                        reloc.type = COFF_RELOC_AMD64_REL32_2;
                         break;
                     case 3:
-                        reloc->type = COFF_RELOC_AMD64_REL32_3;
+                        reloc.type = COFF_RELOC_AMD64_REL32_3;
                         break;
                     case 4:
-                        reloc->type = COFF_RELOC_AMD64_REL32_4;
+                        reloc.type = COFF_RELOC_AMD64_REL32_4;
                         break;
                     case 5:
-                        reloc->type = COFF_RELOC_AMD64_REL32_5;
+                        reloc.type = COFF_RELOC_AMD64_REL32_5;
                         break;
                     default:
                         yasm_error_set(YASM_ERROR_TYPE,
@@ -608,32 +607,32 @@ coff_objfmt_output_value(yasm_value *value, unsigned char *buf,
                 yasm_internal_error(N_("coff objfmt: unrecognized machine"));
         } else if (value->seg_of) {
             if (objfmt_coff->machine == COFF_MACHINE_I386)
-                reloc->type = COFF_RELOC_I386_SECTION;
+                reloc.type = COFF_RELOC_I386_SECTION;
             else if (objfmt_coff->machine == COFF_MACHINE_AMD64)
-                reloc->type = COFF_RELOC_AMD64_SECTION;
+                reloc.type = COFF_RELOC_AMD64_SECTION;
             else
                 yasm_internal_error(N_("coff objfmt: unrecognized machine"));
         } else if (value->section_rel) {
             if (objfmt_coff->machine == COFF_MACHINE_I386)
-                reloc->type = COFF_RELOC_I386_SECREL;
+                reloc.type = COFF_RELOC_I386_SECREL;
             else if (objfmt_coff->machine == COFF_MACHINE_AMD64)
-                reloc->type = COFF_RELOC_AMD64_SECREL;
+                reloc.type = COFF_RELOC_AMD64_SECREL;
             else
                 yasm_internal_error(N_("coff objfmt: unrecognized machine"));
         } else {
             if (objfmt_coff->machine == COFF_MACHINE_I386) {
                 if (nobase)
-                    reloc->type = COFF_RELOC_I386_ADDR32NB;
+                    reloc.type = COFF_RELOC_I386_ADDR32NB;
                 else
-                    reloc->type = COFF_RELOC_I386_ADDR32;
+                    reloc.type = COFF_RELOC_I386_ADDR32;
             } else if (objfmt_coff->machine == COFF_MACHINE_AMD64) {
                 if (valsize == 32) {
                     if (nobase)
-                        reloc->type = COFF_RELOC_AMD64_ADDR32NB;
+                        reloc.type = COFF_RELOC_AMD64_ADDR32NB;
                     else
-                        reloc->type = COFF_RELOC_AMD64_ADDR32;
+                        reloc.type = COFF_RELOC_AMD64_ADDR32;
                 } else if (valsize == 64)
-                    reloc->type = COFF_RELOC_AMD64_ADDR64;
+                    reloc.type = COFF_RELOC_AMD64_ADDR64;
                 else {
                     yasm_error_set(YASM_ERROR_TYPE,
                                    N_("coff: invalid relocation size"));
@@ -643,7 +642,7 @@ coff_objfmt_output_value(yasm_value *value, unsigned char *buf,
                 yasm_internal_error(N_("coff objfmt: unrecognized machine"));
         }
         info->csd->nreloc++;
-        yasm_section_add_reloc(info->sect, (yasm_reloc *)reloc, yasm_xfree);
+        yasm_section_add_reloc(info->sect, &reloc.reloc, sizeof(coff_reloc));
     }
 
     /* Build up final integer output from intn_val, intn_minus, value->abs,
@@ -734,8 +733,9 @@ coff_objfmt_output_section(yasm_section *sect, /*@null@*/ void *d)
     /*@null@*/ coff_objfmt_output_info *info = (coff_objfmt_output_info *)d;
     /*@dependent@*/ /*@null@*/ coff_section_data *csd;
     long pos;
-    coff_reloc *reloc;
-    unsigned char *localbuf;
+    coff_reloc *relocs;
+    unsigned long nrelocs, i;
+    unsigned char *relbuf, *localbuf;
 
     assert(info != NULL);
     csd = yasm_section_get_data(sect, &coff_section_data_cb);
@@ -810,24 +810,25 @@ coff_objfmt_output_section(yasm_section *sect, /*@null@*/ void *d)
         fwrite(info->buf, 10, 1, info->f);
     }
 
-    reloc = (coff_reloc *)yasm_section_relocs_first(sect);
-    while (reloc) {
+    /* Encode all relocations, then write them out at once */
+    relocs = yasm_section_get_relocs(sect, &nrelocs);
+    relbuf = yasm_xmalloc(nrelocs*10);
+    localbuf = relbuf;
+    for (i=0; i<nrelocs; i++) {
+        coff_reloc *reloc = &relocs[i];
         /*@null@*/ coff_symrec_data *csymd;
-        localbuf = info->buf;
 
         csymd = yasm_symrec_get_data(reloc->reloc.sym, &coff_symrec_data_cb);
         if (!csymd)
             yasm_internal_error(
                 N_("coff: no symbol data for relocated symbol"));
 
-        yasm_intnum_get_sized(reloc->reloc.addr, localbuf, 4, 32, 0, 0, 0);
-        localbuf += 4;                          /* address of relocation */
+        YASM_WRITE_32_L(localbuf, reloc->reloc.addr); /* address of reloc */
         YASM_WRITE_32_L(localbuf, csymd->index);    /* relocated symbol */
         YASM_WRITE_16_L(localbuf, reloc->type);     /* type of relocation */
-        fwrite(info->buf, 10, 1, info->f);
-
-        reloc = (coff_reloc *)yasm_section_reloc_next((yasm_reloc *)reloc);
     }
+    fwrite(relbuf, nrelocs*10, 1, info->f);
+    yasm_xfree(relbuf);
 
     return 0;
 }
@@ -43,6 +43,8 @@
  * Each Section is spatially disjoint, and has exactly one SHT entry.
  */
 
+#include <limits.h>
+
 #include <libyasm.h>
 
 #include "elf.h"
@@ -65,6 +67,8 @@ typedef struct {
     FILE *f;
     elf_secthead *shead;
     yasm_section *sect;
+    unsigned long sect_size;    /* bytes output for sect not yet added to
+                                   shead's size */
     yasm_object *object;
     unsigned long sindex;
     yasm_symrec *GOT_sym;
@@ -462,14 +466,13 @@ elf_objfmt_output_reloc(yasm_symrec *sym, yasm_bytecode *bc,
     yasm_intnum *zero;
     int retval;
 
-    reloc = elf_reloc_entry_create(sym, NULL,
-        yasm_intnum_create_uint(bc->offset), 0, valsize, 0);
+    /* allocate .rel[a] sections on a need-basis */
+    reloc = elf_secthead_append_reloc(info->sect, info->shead, sym, NULL,
+                                      bc->offset, 0, valsize, 0);
     if (reloc == NULL) {
         yasm_error_set(YASM_ERROR_TYPE, N_("elf: invalid relocation size"));
         return 1;
     }
-    /* allocate .rel[a] sections on a need-basis */
-    elf_secthead_append_reloc(info->sect, info->shead, reloc);
 
     zero = yasm_intnum_create_uint(0);
     elf_handle_reloc_addend(zero, reloc, 0);
@@ -556,16 +559,15 @@ elf_objfmt_output_value(yasm_value *value, unsigned char *buf,
             intn_val += offset;
 
         /* Check for _GLOBAL_OFFSET_TABLE_ symbol reference */
-        reloc = elf_reloc_entry_create(sym, wrt,
-            yasm_intnum_create_uint(bc->offset + offset), value->curpos_rel,
-            valsize, sym == info->GOT_sym);
+        reloc = elf_secthead_append_reloc(info->sect, info->shead, sym, wrt,
+                                          bc->offset + offset,
+                                          value->curpos_rel, valsize,
+                                          sym == info->GOT_sym);
         if (reloc == NULL) {
             yasm_error_set(YASM_ERROR_TYPE,
                            N_("elf: invalid relocation (WRT or size)"));
             return 1;
         }
-        /* allocate .rel[a] sections on a need-basis */
-        elf_secthead_append_reloc(info->sect, info->shead, reloc);
     }
 
     intn = yasm_intnum_create_uint(intn_val);
@@ -589,6 +591,22 @@ elf_objfmt_output_value(yasm_value *value, unsigned char *buf,
     return retval;
 }
 
+/* Add the bytes counted in info->sect_size to the section header size.
+ * The section size itself may exceed what an unsigned long can hold.
+ */
+static void
+elf_objfmt_flush_sect_size(elf_objfmt_output_info *info)
+{
+    yasm_intnum *sectsize;
+
+    if (info->sect_size == 0)
+        return;
+    sectsize = yasm_intnum_create_uint(info->sect_size);
+    elf_secthead_add_size(info->shead, sectsize);
+    yasm_intnum_destroy(sectsize);
+    info->sect_size = 0;
+}
+
 static int
 elf_objfmt_output_bytecode(yasm_bytecode *bc, /*@null@*/ void *d)
 {
@@ -610,11 +628,9 @@ elf_objfmt_output_bytecode(yasm_bytecode *bc, /*@null@*/ void *d)
             yasm_xfree(bigbuf);
         return 0;
     }
-    else {
-        yasm_intnum *bcsize = yasm_intnum_create_uint(size);
-        elf_secthead_add_size(info->shead, bcsize);
-        yasm_intnum_destroy(bcsize);
-    }
+    if (size > ULONG_MAX - info->sect_size)
+        elf_objfmt_flush_sect_size(info);
+    info->sect_size += size;
 
     /* Warn that gaps are converted to 0 and write out the 0's. */
     if (gap) {
@@ -686,9 +702,12 @@ elf_objfmt_output_section(yasm_section *sect, /*@null@*/ void *d)
 
     info->sect = sect;
     info->shead = shead;
+    info->sect_size = 0;
     yasm_section_bcs_traverse(sect, info->errwarns, info,
                               elf_objfmt_output_bytecode);
 
+    elf_objfmt_flush_sect_size(info);
+
     elf_secthead_set_index(shead, ++info->sindex);
 
     /* No relocations to output?  Go on to next section */
@@ -775,7 +794,9 @@ elf_objfmt_output(yasm_object *object, FILE *f, int all_syms,
     elf_symtab_nlocal = elf_symtab_assign_indices(objfmt_elf->elf_symtab);
 
     /* output known sections - includes reloc sections which aren't in yasm's
-     * list.  Assign indices as we go. */
+     * list.  Assign indices as we go.  This has to stay serial: encoding
+     * evaluates expressions through intnum's static temporaries and reports
+     * through the global errwarn state, neither of which is thread-safe. */
     info.sindex = 3;
     if (yasm_object_sections_traverse(object, &info,
                                       elf_objfmt_output_section))
@@ -141,7 +141,8 @@ elf_x86_amd64_handle_reloc_addend(yasm_intnum *intn,
                                   unsigned long offset)
 {
     /* .rela: copy value out as addend, replace original with 0 */
-    reloc->addend = yasm_intnum_copy(intn);
+    assert(yasm_intnum_check_size(intn, 64, 0, 2));
+    yasm_intnum_get_sized(intn, reloc->addend, 8, 64, 0, 0, 0);
     yasm_intnum_zero(intn);
 }
 
@@ -194,15 +195,11 @@ static void
 elf_x86_amd64_write_reloc(unsigned char *bufp, elf_reloc_entry *reloc,
                           unsigned int r_type, unsigned int r_sym)
 {
-    YASM_WRITE_64I_L(bufp, reloc->reloc.addr);
+    YASM_WRITE_64C_L(bufp, (reloc->reloc.addr >> 16) >> 16,
+                     reloc->reloc.addr);
     /*YASM_WRITE_64_L(bufp, ELF64_R_INFO(r_sym, r_type));*/
     YASM_WRITE_64C_L(bufp, r_sym, r_type);
-    if (reloc->addend)
-        YASM_WRITE_64I_L(bufp, reloc->addend);
-    else {
-        YASM_WRITE_32_L(bufp, 0);
-        YASM_WRITE_32_L(bufp, 0);
-    }
+    memcpy(bufp, reloc->addend, 8);
 }
 
 static void
@@ -139,7 +139,8 @@ elf_x86_x32_handle_reloc_addend(yasm_intnum *intn,
                                   unsigned long offset)
 {
     /* .rela: copy value out as addend, replace original with 0 */
-    reloc->addend = yasm_intnum_copy(intn);
+    assert(yasm_intnum_check_size(intn, 32, 0, 2));
+    yasm_intnum_get_sized(intn, reloc->addend, 8, 64, 0, 0, 0);
     yasm_intnum_zero(intn);
 }
 
@@ -191,13 +192,9 @@ static void
 elf_x86_x32_write_reloc(unsigned char *bufp, elf_reloc_entry *reloc,
                           unsigned int r_type, unsigned int r_sym)
 {
-    YASM_WRITE_32I_L(bufp, reloc->reloc.addr);
+    YASM_WRITE_32_L(bufp, reloc->reloc.addr);
     YASM_WRITE_32_L(bufp, ELF32_R_INFO((unsigned long)r_sym, (unsigned char)r_type));
-    if (reloc->addend)
-        YASM_WRITE_32I_L(bufp, reloc->addend);
-    else {
-        YASM_WRITE_32_L(bufp, 0);
-    }
+    memcpy(bufp, reloc->addend, 4);
 }
 
 static void
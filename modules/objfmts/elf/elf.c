@@ -149,50 +149,6 @@ elf_ssym_has_flag(yasm_symrec *wrt, int flag)
     return 0;
 }
 
-/* takes ownership of addr */
-elf_reloc_entry *
-elf_reloc_entry_create(yasm_symrec *sym,
-                       yasm_symrec *wrt,
-                       yasm_intnum *addr,
-                       int rel,
-                       size_t valsize,
-                       int is_GOT_sym)
-{
-    elf_reloc_entry *entry;
-
-    if (!elf_march->accepts_reloc)
-        yasm_internal_error(N_("Unsupported machine for ELF output"));
-
-    if (!elf_march->accepts_reloc(valsize, wrt))
-    {
-        if (addr)
-            yasm_intnum_destroy(addr);
-        return NULL;
-    }
-
-    if (sym == NULL)
-        yasm_internal_error("sym is null");
-
-    entry = yasm_xmalloc(sizeof(elf_reloc_entry));
-    entry->reloc.sym = sym;
-    entry->reloc.addr = addr;
-    entry->rtype_rel = rel;
-    entry->valsize = valsize;
-    entry->addend = NULL;
-    entry->wrt = wrt;
-    entry->is_GOT_sym = is_GOT_sym;
-
-    return entry;
-}
-
-void
-elf_reloc_entry_destroy(void *entry)
-{
-    if (((elf_reloc_entry*)entry)->addend)
-        yasm_intnum_destroy(((elf_reloc_entry*)entry)->addend);
-    yasm_xfree(entry);
-}
-
 /* strtab functions */
 elf_strtab_entry *
 elf_strtab_entry_create(const char *str)
@@ -687,19 +643,42 @@ elf_secthead_write_to_file(FILE *f, elf_secthead *shead,
     return 0;
 }
 
-void
+/* returns NULL if the machine does not accept the relocation; the returned
+ * entry is only valid until the next relocation is added to sect
+ */
+elf_reloc_entry *
 elf_secthead_append_reloc(yasm_section *sect, elf_secthead *shead,
-                          elf_reloc_entry *reloc)
+                          yasm_symrec *sym, yasm_symrec *wrt,
+                          unsigned long addr, int rel, size_t valsize,
+                          int is_GOT_sym)
 {
+    elf_reloc_entry entry;
+
     if (sect == NULL)
         yasm_internal_error("sect is null");
     if (shead == NULL)
         yasm_internal_error("shead is null");
-    if (reloc == NULL)
-        yasm_internal_error("reloc is null");
+
+    if (!elf_march->accepts_reloc)
+        yasm_internal_error(N_("Unsupported machine for ELF output"));
+
+    if (!elf_march->accepts_reloc(valsize, wrt))
+        return NULL;
+
+    if (sym == NULL)
+        yasm_internal_error("sym is null");
+
+    entry.reloc.sym = sym;
+    entry.reloc.addr = addr;
+    entry.rtype_rel = rel;
+    entry.valsize = valsize;
+    memset(entry.addend, 0, sizeof(entry.addend));
+    entry.wrt = wrt;
+    entry.is_GOT_sym = is_GOT_sym;
 
     shead->nreloc++;
-    yasm_section_add_reloc(sect, (yasm_reloc *)reloc, elf_reloc_entry_destroy);
+    return (elf_reloc_entry *)yasm_section_add_reloc(sect, &entry.reloc,
+                                                     sizeof(elf_reloc_entry));
 }
 
 char *
@@ -740,7 +719,7 @@ elf_secthead_write_rel_to_file(FILE *f, elf_section_index symtab_idx,
     if (shead == NULL)
         yasm_internal_error("shead is null");
 
-    if (!yasm_section_relocs_first(sect))
+    if (!yasm_section_get_reloc(sect, 0))
         return 0;       /* no relocations, no .rel.* section header */
 
     shead->rel_index = sindex;
@@ -758,18 +737,23 @@ unsigned long
 elf_secthead_write_relocs_to_file(FILE *f, yasm_section *sect,
                                   elf_secthead *shead, yasm_errwarns *errwarns)
 {
-    elf_reloc_entry *reloc;
-    unsigned char buf[RELOC_MAXSIZE], *bufp;
-    unsigned long size = 0;
+    elf_reloc_entry *relocs;
+    unsigned char *buf, *bufp;
+    unsigned long nrelocs, i, size = 0;
     long pos;
 
     if (shead == NULL)
         yasm_internal_error("shead is null");
 
-    reloc = (elf_reloc_entry *)yasm_section_relocs_first(sect);
-    if (!reloc)
+    relocs = yasm_section_get_relocs(sect, &nrelocs);
+    if (!relocs)
         return 0;
 
+    if (!elf_march->map_reloc_info_to_type)
+        yasm_internal_error(N_("Unsupported arch/machine for elf output"));
+    if (!elf_march->write_reloc || !elf_march->reloc_entry_size)
+        yasm_internal_error(N_("Unsupported arch/machine for elf output"));
+
     /* first align section to multiple of 4 */
     pos = ftell(f);
     if (pos == -1) {
@@ -784,8 +768,11 @@ elf_secthead_write_relocs_to_file(FILE *f, yasm_section *sect,
     }
     shead->rel_offset = (unsigned long)pos;
 
-
-    while (reloc) {
+    /* encode relocations a block at a time */
+    buf = yasm_xmalloc(RELOC_BLOCK_COUNT*RELOC_MAXSIZE);
+    bufp = buf;
+    for (i=0; i<nrelocs; i++) {
+        elf_reloc_entry *reloc = &relocs[i];
         unsigned int r_type=0, r_sym;
         elf_symtab_entry *esym;
 
@@ -795,20 +782,17 @@ elf_secthead_write_relocs_to_file(FILE *f, yasm_section *sect,
         else
             r_sym = STN_UNDEF;
 
-        if (!elf_march->map_reloc_info_to_type)
-            yasm_internal_error(N_("Unsupported arch/machine for elf output"));
         r_type = elf_march->map_reloc_info_to_type(reloc);
 
-        bufp = buf;
-        if (!elf_march->write_reloc || !elf_march->reloc_entry_size)
-            yasm_internal_error(N_("Unsupported arch/machine for elf output"));
         elf_march->write_reloc(bufp, reloc, r_type, r_sym);
-        fwrite(buf, elf_march->reloc_entry_size, 1, f);
-        size += elf_march->reloc_entry_size;
-
-        reloc = (elf_reloc_entry *)
-            yasm_section_reloc_next((yasm_reloc *)reloc);
+        bufp += elf_march->reloc_entry_size;
+        if ((i+1) % RELOC_BLOCK_COUNT == 0 || i+1 == nrelocs) {
+            fwrite(buf, (unsigned long)(bufp-buf), 1, f);
+            size += (unsigned long)(bufp-buf);
+            bufp = buf;
+        }
     }
+    yasm_xfree(buf);
     return size;
 }
 
@@ -249,6 +249,7 @@ typedef enum {
 #define RELOC64_SIZE 16
 #define RELOC64A_SIZE 24
 #define RELOC_MAXSIZE 24
+#define RELOC_BLOCK_COUNT 1024    /* relocations encoded per write */
 
 #define RELOC32_ALIGN 4
 #define RELOC64_ALIGN 8
@@ -390,7 +391,7 @@ struct elf_reloc_entry {
     yasm_reloc           reloc;
     int                  rtype_rel;
     size_t               valsize;
-    yasm_intnum         *addend;
+    unsigned char        addend[8];     /* little endian; zero if none */
     /*@null@*/ yasm_symrec *wrt;
     int                  is_GOT_sym;
 };
@@ -435,13 +436,6 @@ yasm_symrec *elf_get_special_sym(const char *name, const char *parser);
 /* reloc functions */
 int elf_is_wrt_sym_relative(yasm_symrec *wrt);
 int elf_is_wrt_pos_adjusted(yasm_symrec *wrt);
-elf_reloc_entry *elf_reloc_entry_create(yasm_symrec *sym,
-                                        /*@null@*/ yasm_symrec *wrt,
-                                        yasm_intnum *addr,
-                                        int rel,
-                                        size_t valsize,
-                                        int is_GOT_sym);
-void elf_reloc_entry_destroy(void *entry);
 
 /* strtab functions */
 elf_strtab_entry *elf_strtab_entry_create(const char *str);
@@ -484,8 +478,9 @@ elf_secthead *elf_secthead_create(elf_strtab_entry      *name,
 void elf_secthead_destroy(elf_secthead *esd);
 unsigned long elf_secthead_write_to_file(FILE *f, elf_secthead *esd,
                                          elf_section_index sindex);
-void elf_secthead_append_reloc(yasm_section *sect, elf_secthead *shead,
-                               elf_reloc_entry *reloc);
+/*@null@*/ elf_reloc_entry *elf_secthead_append_reloc(yasm_section *sect,
+    elf_secthead *shead, yasm_symrec *sym, /*@null@*/ yasm_symrec *wrt,
+    unsigned long addr, int rel, size_t valsize, int is_GOT_sym);
 elf_section_type elf_secthead_get_type(elf_secthead *shead);
 void elf_secthead_set_typeflags(elf_secthead *shead, elf_section_type type,
                                 elf_section_flags flags);
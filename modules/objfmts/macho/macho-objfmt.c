@@ -424,7 +424,7 @@ macho_objfmt_output_value(yasm_value *value, unsigned char *buf,
     unsigned long intn_minus = 0, intn_plus = 0;
     int retval;
     unsigned int valsize = value->size;
-    macho_reloc *reloc = NULL;
+    macho_reloc reloc;
 
     assert(info != NULL);
     objfmt_macho = info->objfmt_macho;
@@ -455,60 +455,56 @@ macho_objfmt_output_value(yasm_value *value, unsigned char *buf,
     if (value->rel) {
         yasm_sym_vis vis = yasm_symrec_get_visibility(value->rel);
 
-        reloc = yasm_xcalloc(sizeof(macho_reloc), 1);
-        reloc->reloc.addr = yasm_intnum_create_uint(bc->offset + offset);
-        reloc->reloc.sym = value->rel;
+        memset(&reloc, 0, sizeof(macho_reloc));
+        reloc.reloc.addr = bc->offset + offset;
+        reloc.reloc.sym = value->rel;
         switch (valsize) {
             case 64:
-                reloc->length = 3;
+                reloc.length = 3;
                 break;
             case 32:
-                reloc->length = 2;
+                reloc.length = 2;
                 break;
             case 16:
-                reloc->length = 1;
+                reloc.length = 1;
                 break;
             case 8:
-                reloc->length = 0;
+                reloc.length = 0;
                 break;
             default:
                 yasm_error_set(YASM_ERROR_TOO_COMPLEX,
                                N_("macho: relocation size unsupported"));
-                yasm_xfree(reloc);
                 return 1;
         }
-        reloc->pcrel = 0;
-        reloc->ext = 0;
-        reloc->type = GENERIC_RELOC_VANILLA;
+        reloc.pcrel = 0;
+        reloc.ext = 0;
+        reloc.type = GENERIC_RELOC_VANILLA;
         /* R_ABS */
 
         if (value->rshift > 0) {
             yasm_error_set(YASM_ERROR_TOO_COMPLEX,
                            N_("macho: shifted relocations not supported"));
-            yasm_xfree(reloc);
             return 1;
         }
 
         if (value->seg_of) {
             yasm_error_set(YASM_ERROR_TOO_COMPLEX,
                            N_("macho: SEG not supported"));
-            yasm_xfree(reloc);
             return 1;
         }
 
         if (value->curpos_rel && objfmt_macho->gotpcrel_sym &&
             value->wrt == objfmt_macho->gotpcrel_sym) {
-            reloc->type = X86_64_RELOC_GOT;
+            reloc.type = X86_64_RELOC_GOT;
             value->wrt = NULL;
         } else if (value->wrt) {
             yasm_error_set(YASM_ERROR_TOO_COMPLEX,
                            N_("macho: invalid WRT"));
-            yasm_xfree(reloc);
             return 1;
         }
 
         if (value->curpos_rel) {
-            reloc->pcrel = 1;
+            reloc.pcrel = 1;
             if (!info->is_64) {
                 /* Adjust to start of section, so subtract out the bytecode
                  * offset.
@@ -517,14 +513,14 @@ macho_objfmt_output_value(yasm_value *value, unsigned char *buf,
             } else {
                 /* Add in the offset plus value size to end up with 0. */
                 intn_plus = offset+destsize;
-                if (reloc->type == X86_64_RELOC_GOT) {
+                if (reloc.type == X86_64_RELOC_GOT) {
                     /* XXX: This is a hack */
                     if (offset >= 2 && buf[-2] == 0x8B)
-                        reloc->type = X86_64_RELOC_GOT_LOAD;
+                        reloc.type = X86_64_RELOC_GOT_LOAD;
                 } else if (value->jump_target)
-                    reloc->type = X86_64_RELOC_BRANCH;
+                    reloc.type = X86_64_RELOC_BRANCH;
                 else
-                    reloc->type = X86_64_RELOC_SIGNED;
+                    reloc.type = X86_64_RELOC_SIGNED;
             }
         } else if (info->is_64) {
             if (valsize == 32) {
@@ -532,15 +528,15 @@ macho_objfmt_output_value(yasm_value *value, unsigned char *buf,
                     N_("macho: sorry, cannot apply 32 bit absolute relocations in 64 bit mode, consider \"[_symbol wrt rip]\" for mem access, \"qword\" and \"dq _foo\" for pointers."));
                 return 1;
             }
-            reloc->type = X86_64_RELOC_UNSIGNED;
+            reloc.type = X86_64_RELOC_UNSIGNED;
         }
 
         /* It seems that x86-64 objects need to have all extern relocs? */
         if (info->is_64)
-            reloc->ext = 1;
+            reloc.ext = 1;
 
         if ((vis & YASM_SYM_EXTERN) || (vis & YASM_SYM_COMMON)) {
-            reloc->ext = 1;
+            reloc.ext = 1;
             info->msd->extreloc = 1;    /* section has external relocations */
         } else if (!info->is_64) {
             /*@dependent@*/ /*@null@*/ yasm_bytecode *sym_precbc;
@@ -556,8 +552,8 @@ macho_objfmt_output_value(yasm_value *value, unsigned char *buf,
         }
 
         info->msd->nreloc++;
-        /*printf("reloc %s type %d ",yasm_symrec_get_name(reloc->reloc.sym),reloc->type);*/
-        yasm_section_add_reloc(info->sect, (yasm_reloc *)reloc, yasm_xfree);
+        /*printf("reloc %s type %d ",yasm_symrec_get_name(reloc.reloc.sym),reloc.type);*/
+        yasm_section_add_reloc(info->sect, &reloc.reloc, sizeof(macho_reloc));
     }
 
     if (intn_minus <= intn_plus)
@@ -658,17 +654,23 @@ macho_objfmt_output_relocs(yasm_section *sect, /*@null@*/ void *d)
 {
     /*@null@*/ macho_objfmt_output_info *info = (macho_objfmt_output_info *)d;
     /*@dependent@*/ /*@null@*/ macho_section_data *msd;
-    macho_reloc *reloc;
+    macho_reloc *relocs;
+    unsigned long nrelocs, i;
+    unsigned char *relbuf, *localbuf;
 
-    reloc = (macho_reloc *)yasm_section_relocs_first(sect);
-    while (reloc) {
-        unsigned char *localbuf = info->buf;
+    /* Encode all relocations, then write them out at once */
+    relocs = yasm_section_get_relocs(sect, &nrelocs);
+    if (!relocs)
+        return 0;
+    relbuf = yasm_xmalloc(nrelocs*8);
+    localbuf = relbuf;
+    for (i=0; i<nrelocs; i++) {
+        macho_reloc *reloc = &relocs[i];
         /*@null@*/ macho_symrec_data *xsymd;
         unsigned long symnum;
 
         xsymd = yasm_symrec_get_data(reloc->reloc.sym, &macho_symrec_data_cb);
-        yasm_intnum_get_sized(reloc->reloc.addr, localbuf, 4, 32, 0, 0, 0);
-        localbuf += 4;          /* address of relocation */
+        YASM_WRITE_32_L(localbuf, reloc->reloc.addr);  /* address of reloc */
 
         if (reloc->ext)
             symnum = xsymd->index;
@@ -688,9 +690,9 @@ macho_objfmt_output_relocs(yasm_section *sect, /*@null@*/ void *d)
                         (((unsigned long)reloc->length & 3) << 25) |
                         (((unsigned long)reloc->ext & 1) << 27) |
                         (((unsigned long)reloc->type & 0xf) << 28));
-        fwrite(info->buf, 8, 1, info->f);
-        reloc = (macho_reloc *)yasm_section_reloc_next((yasm_reloc *)reloc);
     }
+    fwrite(relbuf, nrelocs*8, 1, info->f);
+    yasm_xfree(relbuf);
 
     return 0;
 }
@@ -181,30 +181,29 @@ xdf_objfmt_output_value(yasm_value *value, unsigned char *buf,
 
     intn_minus = 0;
     if (value->rel) {
-        xdf_reloc *reloc;
+        xdf_reloc reloc;
 
-        reloc = yasm_xmalloc(sizeof(xdf_reloc));
-        reloc->reloc.addr = yasm_intnum_create_uint(bc->offset + offset);
-        reloc->reloc.sym = value->rel;
-        reloc->base = NULL;
-        reloc->size = valsize/8;
-        reloc->shift = value->rshift;
+        reloc.reloc.addr = bc->offset + offset;
+        reloc.reloc.sym = value->rel;
+        reloc.base = NULL;
+        reloc.size = valsize/8;
+        reloc.shift = value->rshift;
 
         if (value->seg_of)
-            reloc->type = XDF_RELOC_SEG;
+            reloc.type = XDF_RELOC_SEG;
         else if (value->wrt) {
-            reloc->base = value->wrt;
-            reloc->type = XDF_RELOC_WRT;
+            reloc.base = value->wrt;
+            reloc.type = XDF_RELOC_WRT;
         } else if (value->curpos_rel) {
-            reloc->type = XDF_RELOC_RIP;
+            reloc.type = XDF_RELOC_RIP;
             /* Adjust to start of section, so subtract out the bytecode
              * offset.
              */
             intn_minus = bc->offset;
         } else
-            reloc->type = XDF_RELOC_REL;
+            reloc.type = XDF_RELOC_REL;
         info->xsd->nreloc++;
-        yasm_section_add_reloc(info->sect, (yasm_reloc *)reloc, yasm_xfree);
+        yasm_section_add_reloc(info->sect, &reloc.reloc, sizeof(xdf_reloc));
     }
 
     if (intn_minus > 0) {
@@ -283,7 +282,9 @@ xdf_objfmt_output_section(yasm_section *sect, /*@null@*/ void *d)
     /*@null@*/ xdf_objfmt_output_info *info = (xdf_objfmt_output_info *)d;
     /*@dependent@*/ /*@null@*/ xdf_section_data *xsd;
     long pos;
-    xdf_reloc *reloc;
+    xdf_reloc *relocs;
+    unsigned long nrelocs, i;
+    unsigned char *relbuf, *localbuf;
 
     assert(info != NULL);
     xsd = yasm_section_get_data(sect, &xdf_section_data_cb);
@@ -332,9 +333,12 @@ xdf_objfmt_output_section(yasm_section *sect, /*@null@*/ void *d)
     }
     xsd->relptr = (unsigned long)pos;
 
-    reloc = (xdf_reloc *)yasm_section_relocs_first(sect);
-    while (reloc) {
-        unsigned char *localbuf = info->buf;
+    /* Encode all relocations, then write them out at once */
+    relocs = yasm_section_get_relocs(sect, &nrelocs);
+    relbuf = yasm_xmalloc(nrelocs*16);
+    localbuf = relbuf;
+    for (i=0; i<nrelocs; i++) {
+        xdf_reloc *reloc = &relocs[i];
         /*@null@*/ xdf_symrec_data *xsymd;
 
         xsymd = yasm_symrec_get_data(reloc->reloc.sym, &xdf_symrec_data_cb);
@@ -342,8 +346,7 @@ xdf_objfmt_output_section(yasm_section *sect, /*@null@*/ void *d)
             yasm_internal_error(
                 N_("xdf: no symbol data for relocated symbol"));
 
-        yasm_intnum_get_sized(reloc->reloc.addr, localbuf, 4, 32, 0, 0, 0);
-        localbuf += 4;                          /* address of relocation */
+        YASM_WRITE_32_L(localbuf, reloc->reloc.addr); /* address of reloc */
         YASM_WRITE_32_L(localbuf, xsymd->index);    /* relocated symbol */
         if (reloc->base) {
             xsymd = yasm_symrec_get_data(reloc->base, &xdf_symrec_data_cb);
@@ -361,10 +364,9 @@ xdf_objfmt_output_section(yasm_section *sect, /*@null@*/ void *d)
         YASM_WRITE_8(localbuf, reloc->size);        /* size of relocation */
         YASM_WRITE_8(localbuf, reloc->shift);       /* relocation shift */
         YASM_WRITE_8(localbuf, 0);                  /* flags */
-        fwrite(info->buf, 16, 1, info->f);
-
-        reloc = (xdf_reloc *)yasm_section_reloc_next((yasm_reloc *)reloc);
     }
+    fwrite(relbuf, nrelocs*16, 1, info->f);
+    yasm_xfree(relbuf);
 
     return 0;
 }
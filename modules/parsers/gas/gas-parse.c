@@ -1740,16 +1740,24 @@ gas_parser_parse(yasm_parser_gas *parser_gas)
     }
 
     while (get_next_token() != 0) {
-        yasm_bytecode *bc = NULL, *temp_bc;
+        yasm_bytecode *bc = NULL, *temp_bc, *last_bc;
 
         if (!is_eol()) {
             bc = parse_line(parser_gas);
             demand_eol();
         }
 
+        last_bc = yasm_section_bcs_last(cursect);
+        if (bc && parser_gas->merge_data && yasm_bc_data_merge(last_bc, bc))
+            temp_bc = last_bc;
+        else {
+            temp_bc = yasm_section_bcs_append(cursect, bc);
+            if (temp_bc)
+                yasm_section_finalize_insn(cursect, temp_bc, last_bc);
+        }
+
         yasm_errwarn_propagate(parser_gas->errwarns, cur_line);
 
-        temp_bc = yasm_section_bcs_append(cursect, bc);
         if (temp_bc)
             parser_gas->prev_bc = temp_bc;
         if (curtok == ';')
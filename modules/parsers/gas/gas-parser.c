@@ -61,6 +61,14 @@ gas_parser_do_parse(yasm_object *object, yasm_preproc *pp,
     parser_gas.save_input = save_input;
     parser_gas.save_last = 0;
 
+    /* Constant data lines may share a bytecode unless per-line bytecodes
+     * are needed (for listings, debug line info, or bytecode dumps).
+     */
+    parser_gas.merge_data = !save_input
+        && strcmp(yasm_dbgfmt_keyword(object->dbgfmt), "null") == 0
+        && strcmp(((yasm_objfmt_base *)object->objfmt)->module->keyword,
+                  "dbg") != 0;
+
     parser_gas.peek_token = NONE;
 
     parser_gas.line = NULL;
@@ -95,6 +95,7 @@ typedef struct yasm_parser_gas {
     yasm_bytecode *temp_bc;
 
     int save_input;
+    int merge_data;     /* merge constant data with yasm_bc_data_merge() */
     YYCTYPE save_line[2][MAX_SAVED_LINE_LEN];
     int save_last;
 
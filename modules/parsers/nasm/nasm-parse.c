@@ -215,15 +215,38 @@ void
 nasm_parser_parse(yasm_parser_nasm *parser_nasm)
 {
     unsigned char *line;
-    while ((line = (unsigned char *)
-            yasm_preproc_get_line(parser_nasm->preproc)) != NULL) {
+    size_t len;
+    /* Get line numbers out of band when possible (the listing needs the
+     * line number directives as source lines).
+     */
+    int line_info = !parser_nasm->save_input &&
+        yasm_preproc_has_line_info(parser_nasm->preproc);
+
+    for (;;) {
         yasm_bytecode *bc = NULL, *temp_bc;
 
+        if (line_info) {
+            yasm_preproc_linepos pos;
+            line = (unsigned char *)yasm_preproc_get_line_info(
+                parser_nasm->preproc, &len, &pos);
+            if (!line)
+                break;
+            if (pos.filename)
+                yasm_linemap_set(parser_nasm->linemap, pos.filename, 0,
+                                 pos.line, pos.line_inc);
+        } else {
+            line = (unsigned char *)
+                yasm_preproc_get_line(parser_nasm->preproc);
+            if (!line)
+                break;
+            len = strlen((char *)line);
+        }
+
         parser_nasm->s.bot = line;
         parser_nasm->s.tok = line;
         parser_nasm->s.ptr = line;
         parser_nasm->s.cur = line;
-        parser_nasm->s.lim = line + strlen((char *)line)+1;
+        parser_nasm->s.lim = line + len+1;
         parser_nasm->s.top = parser_nasm->s.lim;
 
         get_next_token();
@@ -261,7 +284,15 @@ nasm_parser_parse(yasm_parser_nasm *parser_nasm)
             }
             temp_bc = NULL;
         } else if (bc) {
-            temp_bc = yasm_section_bcs_append(cursect, bc);
+            yasm_bytecode *last_bc = yasm_section_bcs_last(cursect);
+
+            if (parser_nasm->merge_data && yasm_bc_data_merge(last_bc, bc))
+                temp_bc = last_bc;
+            else {
+                temp_bc = yasm_section_bcs_append(cursect, bc);
+                if (temp_bc)
+                    yasm_section_finalize_insn(cursect, temp_bc, last_bc);
+            }
             if (temp_bc)
                 parser_nasm->prev_bc = temp_bc;
         } else
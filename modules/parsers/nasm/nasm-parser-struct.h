@@ -59,6 +59,9 @@ typedef struct yasm_parser_nasm {
 
     int save_input;
 
+    /* merge constant data bytecodes with yasm_bc_data_merge() */
+    int merge_data;
+
     yasm_scanner s;
     int state;
 
@@ -53,6 +53,14 @@ nasm_do_parse(yasm_object *object, yasm_preproc *pp, int save_input,
 
     parser_nasm.save_input = save_input;
 
+    /* Constant data lines may share a bytecode unless per-line bytecodes
+     * are needed (for listings, debug line info, or bytecode dumps).
+     */
+    parser_nasm.merge_data = !save_input
+        && strcmp(yasm_dbgfmt_keyword(object->dbgfmt), "null") == 0
+        && strcmp(((yasm_objfmt_base *)object->objfmt)->module->keyword,
+                  "dbg") != 0;
+
     parser_nasm.peek_token = NONE;
 
     parser_nasm.absstart = NULL;
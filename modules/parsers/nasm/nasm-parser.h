@@ -120,4 +120,10 @@ void nasm_parser_parse(yasm_parser_nasm *parser_nasm);
 void nasm_parser_cleanup(yasm_parser_nasm *parser_nasm);
 int nasm_parser_lex(YYSTYPE *lvalp, yasm_parser_nasm *parser_nasm);
 
+/* Returns the token for a TASM/MASM keyword, or 0 if id is not a keyword
+ * in the current mode.
+ */
+int nasm_parser_check_keyword(yasm_parser_nasm *parser_nasm, const char *id,
+                              size_t id_len);
+
 #endif
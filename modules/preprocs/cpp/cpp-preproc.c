@@ -398,5 +398,6 @@ yasm_preproc_module yasm_cpp_LTX_preproc = {
     cpp_preproc_predefine_macro,
     cpp_preproc_undefine_macro,
     cpp_preproc_define_builtin,
-    cpp_preproc_add_standard
+    cpp_preproc_add_standard,
+    NULL        /* no line info */
 };
@@ -1267,13 +1267,9 @@ gas_preproc_create(const char *in_filename, yasm_symtab *symtab,
     FILE *f;
     yasm_preproc_gas *pp = yasm_xmalloc(sizeof(yasm_preproc_gas));
 
-    if (strcmp(in_filename, "-") != 0) {
-        f = fopen(in_filename, "r");
-        if (!f) {
-            yasm__fatal(N_("Could not open input file"));
-        }
-    } else {
-        f = stdin;
+    f = yasm_fopen_source(in_filename, "r");
+    if (!f) {
+        yasm__fatal(N_("Could not open input file"));
     }
 
     pp->preproc.module = &yasm_gas_LTX_preproc;
@@ -1440,5 +1436,6 @@ yasm_preproc_module yasm_gas_LTX_preproc = {
     gas_preproc_predefine_macro,
     gas_preproc_undefine_macro,
     gas_preproc_define_builtin,
-    gas_preproc_add_standard
+    gas_preproc_add_standard,
+    NULL        /* no line info */
 };
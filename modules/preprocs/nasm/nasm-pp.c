@@ -53,6 +53,7 @@ typedef struct Context Context;
 typedef struct Token Token;
 typedef struct Blocks Blocks;
 typedef struct Line Line;
+typedef struct BodyToken BodyToken;
 typedef struct Include Include;
 typedef struct Cond Cond;
 
@@ -99,7 +100,8 @@ struct MMacro
     Token *dlist;               /* All defaults as one list */
     Token **defaults;           /* Parameter default pointers */
     int ndefs;                  /* number of default parameters */
-    Line *expansion;
+    Line *expansion;            /* lines while being defined */
+    BodyToken *body;            /* compiled lines once defined */
 
     MMacro *next_active;
     MMacro *rep_nest;           /* used for nesting %rep */
@@ -183,6 +185,23 @@ struct Line
     Token *first;
 };
 
+/*
+ * Once a multi-line macro or %rep block has been completely defined,
+ * its `expansion' list is compiled into a single array of these (in
+ * the same, reversed, line order), so that each expansion only has to
+ * walk one contiguous block and never has to measure token text
+ * again. Each line's tokens are followed by an entry of type
+ * BODY_EOL, and the whole body by an entry of type BODY_END.
+ */
+struct BodyToken
+{
+    int type;
+    size_t len;
+    const char *text;           /* NULL if the token had no text */
+};
+#define BODY_EOL    0
+#define BODY_END    (-1)
+
 /*
  * To handle an arbitrary level of file inclusion, we maintain a
  * stack (ie linked list) of these things.
@@ -1160,9 +1179,61 @@ free_mmacro(MMacro * m)
     free_tlist(m->dlist);
     nasm_free(m->defaults);
     free_llist(m->expansion);
+    nasm_free(m->body);
     nasm_free(m);
 }
 
+/*
+ * Compile the lines of a completely defined MMacro into its body,
+ * freeing the lines.
+ */
+static void
+compile_mmacro(MMacro * m)
+{
+    Line *l;
+    Token *t;
+    BodyToken *b;
+    size_t ntok = 1, textlen = 0;
+    char *p;
+
+    for (l = m->expansion; l; l = l->next)
+    {
+        for (t = l->first; t; t = t->next)
+        {
+            ntok++;
+            if (t->text)
+                textlen += strlen(t->text) + 1;
+        }
+        ntok++;
+    }
+
+    b = m->body = nasm_malloc(ntok * sizeof(BodyToken) + textlen);
+    p = (char *)(m->body + ntok);
+    for (l = m->expansion; l; l = l->next)
+    {
+        for (t = l->first; t; t = t->next)
+        {
+            b->type = t->type;
+            b->len = 0;
+            b->text = NULL;
+            if (t->text)
+            {
+                b->len = strlen(t->text);
+                memcpy(p, t->text, b->len + 1);
+                b->text = p;
+                p += b->len + 1;
+            }
+            b++;
+        }
+        b->type = BODY_EOL;
+        b++;
+    }
+    b->type = BODY_END;
+
+    free_llist(m->expansion);
+    m->expansion = NULL;
+}
+
 /*
  * Pop the context stack.
  */
@@ -1259,7 +1330,8 @@ read_line(void)
      */
     buffer[strcspn(buffer, "\032")] = '\0';
 
-    list->line(LIST_READ, buffer);
+    if (list->line)
+        list->line(LIST_READ, buffer);
 
     return buffer;
 }
@@ -1510,7 +1582,7 @@ new_Token(Token * next, int type, const char *text, size_t txtlen)
         if (txtlen == 0)
             txtlen = strlen(text);
         t->text = nasm_malloc(1 + txtlen);
-        strncpy(t->text, text, txtlen);
+        memcpy(t->text, text, txtlen);
         t->text[txtlen] = '\0';
     }
     return t;
@@ -1530,9 +1602,10 @@ delete_Token(Token * t)
  * Convert a line of tokens back into text.
  * If expand_locals is not zero, identifiers of the form "%$*xxx"
  * will be transformed into ..@ctxnum.xxx
+ * If lenp is not NULL, the length of the line is stored there.
  */
 static char *
-detoken(Token * tlist, int expand_locals)
+detoken(Token * tlist, int expand_locals, size_t *lenp)
 {
     Token *t;
     size_t len;
@@ -1582,17 +1655,18 @@ detoken(Token * tlist, int expand_locals)
     {
         if (t->type == TOK_WHITESPACE)
         {
-            *p = ' ';
-                p++;
-                *p = '\0';
+            *p++ = ' ';
         }
         else if (t->text)
         {
-            strcpy(p, t->text);
-            p += strlen(p);
+            const char *q = t->text;
+            while (*q)
+                *p++ = *q++;
         }
     }
     *p = '\0';
+    if (lenp)
+        *lenp = len;
     return line;
 }
 
@@ -2312,7 +2386,7 @@ expand_macros_in_string(char **p)
 {
     Token *line = tokenise(*p);
     line = expand_smacro(line);
-    *p = detoken(line, FALSE);
+    *p = detoken(line, FALSE, NULL);
     do
         line = delete_Token(line);
     while (line);
@@ -2877,7 +2951,7 @@ do_directive(Token * tline)
             }
             else
             {
-                p = detoken(tline, FALSE);
+                p = detoken(tline, FALSE, NULL);
                 error(ERR_WARNING, "%s", p);
                 nasm_free(p);
             }
@@ -3090,6 +3164,7 @@ do_directive(Token * tline)
                 defining->defaults = NULL;
             }
             defining->expansion = NULL;
+            defining->body = NULL;
             free_tlist(origline);
             return DIRECTIVE_FOUND;
 
@@ -3101,6 +3176,7 @@ do_directive(Token * tline)
                         tline->text);
                 return DIRECTIVE_FOUND;
             }
+            compile_mmacro(defining);
             k = hash(defining->name);
             defining->next = mmacros[k];
             mmacros[k] = defining;
@@ -3219,6 +3295,7 @@ do_directive(Token * tline)
             defining->defaults = NULL;
             defining->dlist = NULL;
             defining->expansion = NULL;
+            defining->body = NULL;
             defining->next_active = istk->mstk;
             defining->rep_nest = tmp_defining;
             return DIRECTIVE_FOUND;
@@ -3241,6 +3318,7 @@ do_directive(Token * tline)
              * continues) until the whole expansion is forcibly removed
              * from istk->expansion by a %exitrep.
              */
+            compile_mmacro(defining);
             l = nasm_malloc(sizeof(Line));
             l->next = istk->expansion;
             l->finishes = defining;
@@ -3787,7 +3865,7 @@ do_directive(Token * tline)
             istk->lineinc = m;
             if (tline)
             {
-                nasm_free(nasm_src_set_fname(detoken(tline, FALSE)));
+                nasm_free(nasm_src_set_fname(detoken(tline, FALSE, NULL)));
             }
             free_tlist(origline);
             return DIRECTIVE_FOUND;
@@ -4648,7 +4726,8 @@ expand_mmacro(Token * tline)
     int dont_prepend = 0;
     Token **params, *t, *tt;
     MMacro *m;
-    Line *l, *ll;
+    Line *ll;
+    BodyToken *b;
     int i, nparam;
     long *paramlen;
 
@@ -4748,7 +4827,7 @@ expand_mmacro(Token * tline)
     m->next_active = istk->mstk;
     istk->mstk = m;
 
-    for (l = m->expansion; l; l = l->next)
+    for (b = m->body; b->type != BODY_END; b++)
     {
         Token **tail;
 
@@ -4758,18 +4837,18 @@ expand_mmacro(Token * tline)
         istk->expansion = ll;
         tail = &ll->first;
 
-        for (t = l->first; t; t = t->next)
+        for (; b->type != BODY_EOL; b++)
         {
-            Token *x = t;
-            if (t->type == TOK_PREPROC_ID &&
-                    t->text[1] == '0' && t->text[2] == '0')
+            if (b->type == TOK_PREPROC_ID &&
+                    b->text[1] == '0' && b->text[2] == '0')
             {
                 dont_prepend = -1;
-                x = label;
-                if (!x)
+                if (!label)
                     continue;
+                tt = *tail = new_Token(NULL, label->type, label->text, 0);
             }
-            tt = *tail = new_Token(NULL, x->type, x->text, 0);
+            else
+                tt = *tail = new_Token(NULL, b->type, b->text, b->len);
             tail = &tt->next;
         }
         *tail = NULL;
@@ -4902,10 +4981,11 @@ poke_predef(Line *predef_lines)
 }
 
 static char *
-pp_getline(void)
+pp_getline(size_t *len)
 {
     char *line;
     Token *tline;
+    BodyToken *b;
 
     while (1)
     {
@@ -4947,9 +5027,9 @@ pp_getline(void)
                  * if we did.
                  */
                 l->finishes->in_progress--;
-                for (l = l->finishes->expansion; l; l = l->next)
+                for (b = l->finishes->body; b->type != BODY_END; b++)
                 {
-                    Token *t, *tt, **tail;
+                    Token *tt, **tail;
 
                     ll = nasm_malloc(sizeof(Line));
                     ll->next = istk->expansion;
@@ -4957,11 +5037,12 @@ pp_getline(void)
                     ll->first = NULL;
                     tail = &ll->first;
 
-                    for (t = l->first; t; t = t->next)
+                    for (; b->type != BODY_EOL; b++)
                     {
-                        if (t->text || t->type == TOK_WHITESPACE)
+                        if (b->text || b->type == TOK_WHITESPACE)
                         {
-                            tt = *tail = new_Token(NULL, t->type, t->text, 0);
+                            tt = *tail = new_Token(NULL, b->type, b->text,
+                                                   b->len);
                             tail = &tt->next;
                         }
                     }
@@ -5019,16 +5100,18 @@ pp_getline(void)
 
             if (istk->expansion)
             {                   /* from a macro expansion */
-                char *p;
                 Line *l = istk->expansion;
                 if (istk->mstk)
                     istk->mstk->lineno++;
                 tline = l->first;
                 istk->expansion = l->next;
                 nasm_free(l);
-                p = detoken(tline, FALSE);
-                list->line(LIST_MACRO, p);
-                nasm_free(p);
+                if (list->line)
+                {
+                    char *p = detoken(tline, FALSE, NULL);
+                    list->line(LIST_MACRO, p);
+                    nasm_free(p);
+                }
                 break;
             }
             line = read_line();
@@ -5134,7 +5217,7 @@ pp_getline(void)
                 if (tasm_compatible_mode)
                     tline = tasm_join_tokens(tline);
 
-                line = detoken(tline, TRUE);
+                line = detoken(tline, TRUE, len);
                 free_tlist(tline);
                 break;
             }
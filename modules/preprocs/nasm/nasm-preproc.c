@@ -76,11 +76,6 @@ nil_listgen_output(long v, const void *d, unsigned long v2)
 {
 }
 
-static void
-nil_listgen_line(int v, char *p)
-{
-}
-
 static void
 nil_listgen_uplevel(int v)
 {
@@ -95,7 +90,7 @@ static ListGen nil_list = {
     nil_listgen_init,
     nil_listgen_cleanup,
     nil_listgen_output,
-    nil_listgen_line,
+    NULL,                       /* no line text wanted */
     nil_listgen_uplevel,
     nil_listgen_downlevel
 };
@@ -139,13 +134,9 @@ nasm_preproc_create(const char *in_filename, yasm_symtab *symtab,
 
     preproc_nasm->preproc.module = &yasm_nasm_LTX_preproc;
 
-    if (strcmp(in_filename, "-") != 0) {
-        f = fopen(in_filename, "r");
-        if (!f)
-            yasm__fatal( N_("Could not open input file") );
-    }
-    else
-        f = stdin;
+    f = yasm_fopen_source(in_filename, "r");
+    if (!f)
+        yasm__fatal( N_("Could not open input file") );
 
     preproc_nasm->in = f;
     nasm_symtab = symtab;
@@ -187,20 +178,17 @@ nasm_preproc_destroy(yasm_preproc *preproc)
 }
 
 static char *
-nasm_preproc_get_line(yasm_preproc *preproc)
+nasm_preproc_get_line_info(yasm_preproc *preproc, size_t *len,
+                           yasm_preproc_linepos *pos)
 {
     yasm_preproc_nasm *preproc_nasm = (yasm_preproc_nasm *)preproc;
     long linnum;
     int altline;
     char *line;
 
-    if (preproc_nasm->line) {
-        char *retval = preproc_nasm->line;
-        preproc_nasm->line = NULL;
-        return retval;
-    }
+    pos->filename = NULL;
 
-    line = nasmpp.getline();
+    line = nasmpp.getline(len);
     if (!line)
     {
         nasmpp.cleanup(1);
@@ -212,11 +200,36 @@ nasm_preproc_get_line(yasm_preproc *preproc)
     if (altline != 0) {
         preproc_nasm->lineinc =
             (altline != -1 || preproc_nasm->lineinc != 1);
+        preproc_nasm->prior_linnum = linnum;
+        pos->filename = preproc_nasm->file_name;
+        pos->line = (unsigned long)linnum;
+        pos->line_inc = (unsigned long)preproc_nasm->lineinc;
+    }
+
+    return line;
+}
+
+static char *
+nasm_preproc_get_line(yasm_preproc *preproc)
+{
+    yasm_preproc_nasm *preproc_nasm = (yasm_preproc_nasm *)preproc;
+    yasm_preproc_linepos pos;
+    char *line;
+
+    if (preproc_nasm->line) {
+        char *retval = preproc_nasm->line;
+        preproc_nasm->line = NULL;
+        return retval;
+    }
+
+    line = nasm_preproc_get_line_info(preproc, NULL, &pos);
+
+    /* Emit a line number directive ahead of the line if it moved */
+    if (line && pos.filename) {
         preproc_nasm->line = line;
         line = yasm_xmalloc(40+strlen(preproc_nasm->file_name));
-        sprintf(line, "%%line %ld+%d %s", linnum,
+        sprintf(line, "%%line %ld+%d %s", preproc_nasm->prior_linnum,
                 preproc_nasm->lineinc, preproc_nasm->file_name);
-        preproc_nasm->prior_linnum = linnum;
     }
 
     return line;
@@ -259,7 +272,7 @@ nasm_preproc_get_included_file(yasm_preproc *preproc, /*@out@*/ char *buf,
         }
 
         /* Preprocess some more, throwing away the result */
-        line = nasmpp.getline();
+        line = nasmpp.getline(NULL);
         if (line)
             yasm_xfree(line);
         else
@@ -315,7 +328,8 @@ yasm_preproc_module yasm_nasm_LTX_preproc = {
     nasm_preproc_predefine_macro,
     nasm_preproc_undefine_macro,
     nasm_preproc_define_builtin,
-    nasm_preproc_add_standard
+    nasm_preproc_add_standard,
+    nasm_preproc_get_line_info
 };
 
 static yasm_preproc *
@@ -337,5 +351,6 @@ yasm_preproc_module yasm_tasm_LTX_preproc = {
     nasm_preproc_predefine_macro,
     nasm_preproc_undefine_macro,
     nasm_preproc_define_builtin,
-    nasm_preproc_add_standard
+    nasm_preproc_add_standard,
+    nasm_preproc_get_line_info
 };
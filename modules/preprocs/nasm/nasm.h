@@ -117,7 +117,9 @@ typedef struct {
      * Called to send a text line to the listing generator. The
      * `int' parameter is LIST_READ or LIST_MACRO depending on
      * whether the line came directly from an input file or is the
-     * result of a multi-line macro expansion.
+     * result of a multi-line macro expansion. May be NULL if the
+     * listing generator has no use for the text, in which case the
+     * preprocessor doesn't bother to build it.
      */
     void (*line) (int, char *);
 
@@ -215,9 +217,10 @@ typedef struct {
     /*
      * Called to fetch a line of preprocessed source. The line
      * returned has been malloc'ed, and so should be freed after
-     * use.
+     * use. If the argument is not NULL, the length of the line is
+     * stored there.
      */
-    char *(*getline) (void);
+    char *(*getline) (size_t *);
 
     /*
      * Called at the end of a pass.
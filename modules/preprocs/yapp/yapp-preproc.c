@@ -246,13 +246,9 @@ yapp_preproc_create(const char *in_filename, yasm_linemap *lm,
     FILE *f;
     yasm_preproc_yapp *preproc_yapp = yasm_xmalloc(sizeof(yasm_preproc_yapp));
 
-    if (strcmp(in_filename, "-") != 0) {
-        f = fopen(in_filename, "r");
-        if (!f)
-            yasm__fatal( N_("Could not open input file") );
-    }
-    else
-        f = stdin;
+    f = yasm_fopen_source(in_filename, "r");
+    if (!f)
+        yasm__fatal( N_("Could not open input file") );
 
     preproc_yapp->preproc.module = &yasm_yapp_LTX_preproc;
 
@@ -1016,5 +1012,6 @@ yasm_preproc_module yasm_yapp_LTX_preproc = {
     yapp_preproc_predefine_macro,
     yapp_preproc_undefine_macro,
     yapp_preproc_define_builtin,
-    yapp_preproc_add_standard
+    yapp_preproc_add_standard,
+    NULL        /* no line info */
 };
@@ -0,0 +1,631 @@
+/*
+ * Native golden output test driver
+ *
+ *  Copyright (C) 2026  Yasm developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/* Runs the same checks as out_test.sh, which hands its arguments here when
+ * YASM_NATIVE_TEST is set ("make check-native") and this program has been
+ * built:
+ *
+ *   out_test [-j jobs] name dir description "yasm options" obj-extension
+ *
+ * Every .asm file in dir is assembled in-process with yasm_assemble_buffer() and
+ * its output and diagnostics are compared (ignoring whitespace, like
+ * diff -w) against the .hex and .errwarn files next to it.  libyasm keeps
+ * global state, so rather than threads each case runs in a forked child,
+ * up to jobs (default: number of processors) at a time; this also isolates
+ * crashes.  The report, exit status and results/ files for failing cases
+ * match out_test.sh.  Exits with 77 if the platform isn't supported, so the
+ * script can fall back to running yasm itself.
+ */
+/* fork() and friends are hidden by -ansi otherwise */
+#define _POSIX_C_SOURCE 200112L
+
+#include "util.h"
+
+#include <ctype.h>
+#include <setjmp.h>
+
+#include "libyasm.h"
+#include "libyasm/bitvect.h"
+
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+
+#if defined(HAVE_UNISTD_H) && defined(HAVE_FORK)
+#define USE_FORK
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef CMAKE_BUILD
+void yasm_init_plugin(void);
+#endif
+
+/* Case results; also the exit status of the child running the case */
+enum {
+    RESULT_PASS = 0,
+    RESULT_ERROR,           /* returned an error code */
+    RESULT_NO_ERROR,        /* did not return an error code */
+    RESULT_ERRWARN,         /* errors/warnings didn't match */
+    RESULT_OBJECT,          /* object file didn't match */
+    RESULT_CRASH,
+    RESULT_PENDING
+};
+
+typedef struct test_suite {
+    const char *dir;
+    const char *obj_ext;
+    yasm_assemble_options opts;
+} test_suite;
+
+/* Growable text buffer */
+typedef struct textbuf {
+    char *data;
+    size_t len;
+    size_t size;
+} textbuf;
+
+/* Diagnostics of the case being run (there's no user data pointer in the
+ * print functions).
+ */
+static textbuf errwarn_text;
+
+/* Where a fatal error in the case being run returns to */
+static jmp_buf fatal_jmp;
+
+static void
+text_append(textbuf *tb, const char *s, size_t len)
+{
+    if (tb->len + len + 1 > tb->size) {
+        while (tb->len + len + 1 > tb->size)
+            tb->size = tb->size ? tb->size*2 : 1024;
+        tb->data = yasm_xrealloc(tb->data, tb->size);
+    }
+    memcpy(tb->data+tb->len, s, len);
+    tb->len += len;
+    tb->data[tb->len] = '\0';
+}
+
+/* Same format as the yasm frontend's default (GNU) message style; keep in
+ * step with print_yasm_error() and print_yasm_warning() in
+ * frontends/yasm/yasm.c, which plain "make check" covers.
+ */
+static void
+print_message(const char *filename, unsigned long line, const char *type,
+              const char *msg)
+{
+    char num[32];
+
+    text_append(&errwarn_text, filename, strlen(filename));
+    if (line) {
+        sprintf(num, ":%lu", line);
+        text_append(&errwarn_text, num, strlen(num));
+    }
+    text_append(&errwarn_text, ": ", 2);
+    text_append(&errwarn_text, type, strlen(type));
+    text_append(&errwarn_text, msg, strlen(msg));
+    text_append(&errwarn_text, "\n", 1);
+}
+
+static void
+print_error(const char *filename, unsigned long line, const char *msg,
+            const char *xref_fn, unsigned long xref_line,
+            const char *xref_msg)
+{
+    print_message(filename, line, "error: ", msg);
+    if (xref_fn && xref_msg)
+        print_message(xref_fn, xref_line, "error: ", xref_msg);
+}
+
+static void
+print_warning(const char *filename, unsigned long line, const char *msg)
+{
+    print_message(filename, line, "warning: ", msg);
+}
+
+/* Records the message the way the yasm frontend prints it and abandons
+ * the case; libyasm state after this is only good for exiting, which the
+ * child running the case does next.
+ */
+static void
+handle_fatal(const char *fmt, va_list va)
+{
+    char msg[1024+1];
+
+#ifdef HAVE_VSNPRINTF
+    vsnprintf(msg, 1024, fmt, va);
+#else
+    vsprintf(msg, fmt, va);
+#endif
+    text_append(&errwarn_text, "yasm: FATAL: ", 13);
+    text_append(&errwarn_text, msg, strlen(msg));
+    text_append(&errwarn_text, "\n", 1);
+    longjmp(fatal_jmp, 1);
+}
+
+/* Reads a whole file; returns 0 on success.  A missing file reads as empty
+ * if missing_ok.
+ */
+static int
+read_file(const char *filename, textbuf *tb, int missing_ok)
+{
+    char buf[4096];
+    size_t n;
+    FILE *f = fopen(filename, "rb");
+
+    tb->len = 0;
+    text_append(tb, "", 0);
+    if (!f)
+        return missing_ok ? 0 : 1;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        text_append(tb, buf, n);
+    n = ferror(f);
+    fclose(f);
+    return n != 0;
+}
+
+static void
+write_file(const char *filename, const char *data, size_t len)
+{
+    FILE *f = fopen(filename, "wb");
+    if (!f)
+        return;
+    fwrite(data, 1, len, f);
+    fclose(f);
+}
+
+/* Compares two texts line by line, ignoring all whitespace within lines
+ * (diff -w).  Returns nonzero if they match.
+ */
+static int
+text_match(const char *a, size_t alen, const char *b, size_t blen)
+{
+    const char *aend = a+alen, *bend = b+blen;
+    const char *rest, *end;
+
+    for (;;) {
+        while (a < aend && *a != '\n' && isspace((unsigned char)*a))
+            a++;
+        while (b < bend && *b != '\n' && isspace((unsigned char)*b))
+            b++;
+        if (a == aend || b == bend)
+            break;
+        if (*a != *b)
+            return 0;
+        a++;
+        b++;
+    }
+
+    /* Whatever is left on the other side may only be the newline that
+     * ends a last line the finished side didn't terminate.
+     */
+    if (a == aend) {
+        rest = b;
+        end = bend;
+        if (alen == 0 || aend[-1] == '\n')
+            return rest == end;
+    } else {
+        rest = a;
+        end = aend;
+        if (blen == 0 || bend[-1] == '\n')
+            return rest == end;
+    }
+    return rest == end || (*rest == '\n' && rest+1 == end);
+}
+
+/* Formats an object image the way test_hd does. */
+static void
+hexdump(textbuf *tb, const unsigned char *data, size_t len)
+{
+    static const char hexdigits[] = "0123456789abcdef";
+    char line[4] = "xx \n";
+    size_t i;
+
+    tb->len = 0;
+    text_append(tb, "", 0);
+    for (i=0; i<len; i++) {
+        line[0] = hexdigits[data[i] >> 4];
+        line[1] = hexdigits[data[i] & 0xF];
+        text_append(tb, line, 4);
+    }
+}
+
+/* Returns the case basename (without directory and .asm) in a new string */
+static char *
+case_name(const char *asm_path)
+{
+    const char *base = strrchr(asm_path, '/');
+    size_t len;
+    char *name;
+
+    base = base ? base+1 : asm_path;
+    len = strlen(base) - 4;
+    name = yasm_xmalloc(len+1);
+    memcpy(name, base, len);
+    name[len] = '\0';
+    return name;
+}
+
+/* Replaces the .asm extension of asm_path with ext, in a new string */
+static char *
+golden_path(const char *asm_path, const char *ext)
+{
+    size_t len = strlen(asm_path) - 4;
+    char *path = yasm_xmalloc(len+strlen(ext)+1);
+
+    memcpy(path, asm_path, len);
+    strcpy(path+len, ext);
+    return path;
+}
+
+static int
+run_case(const test_suite *suite, const char *asm_path)
+{
+    static textbuf src, golden, hex;
+    yasm_output_buffer out = {NULL, 0, 0};
+    yasm_assemble_options opts = suite->opts;
+    char *name = case_name(asm_path);
+    char *path, *obj_path;
+    int is_err_case = strstr(asm_path, "err") != NULL;
+    int status, result;
+
+    errwarn_text.len = 0;
+    text_append(&errwarn_text, "", 0);
+
+    obj_path = yasm_xmalloc(strlen("results/")+strlen(name)+
+                            strlen(suite->obj_ext)+1);
+    sprintf(obj_path, "results/%s%s", name, suite->obj_ext);
+    opts.obj_filename = obj_path;
+
+    if (read_file(asm_path, &src, 0) != 0 || setjmp(fatal_jmp) != 0)
+        status = 1;
+    else
+        status = yasm_assemble_buffer("-", src.data, src.len, &opts, &out);
+
+    path = golden_path(asm_path, ".errwarn");
+    read_file(path, &golden, 1);
+    yasm_xfree(path);
+
+    if (status != 0) {
+        if (!is_err_case)
+            result = RESULT_ERROR;
+        else if (text_match(golden.data, golden.len, errwarn_text.data,
+                            errwarn_text.len))
+            result = RESULT_PASS;
+        else
+            result = RESULT_ERRWARN;
+    } else if (is_err_case)
+        result = RESULT_NO_ERROR;
+    else {
+        hexdump(&hex, out.data, out.len);
+        path = golden_path(asm_path, ".hex");
+        read_file(path, &golden, 1);
+        yasm_xfree(path);
+        if (!text_match(golden.data, golden.len, hex.data, hex.len))
+            result = RESULT_OBJECT;
+        else {
+            path = golden_path(asm_path, ".errwarn");
+            read_file(path, &golden, 1);
+            yasm_xfree(path);
+            if (text_match(golden.data, golden.len, errwarn_text.data,
+                           errwarn_text.len))
+                result = RESULT_PASS;
+            else
+                result = RESULT_ERRWARN;
+        }
+    }
+
+    /* Keep the output of failing cases around for inspection */
+    if (result != RESULT_PASS) {
+        if (status == 0) {
+            write_file(obj_path, (const char *)out.data, out.len);
+            path = yasm_xmalloc(strlen(name)+strlen("results/.hx")+1);
+            sprintf(path, "results/%s.hx", name);
+            write_file(path, hex.data, hex.len);
+            yasm_xfree(path);
+        }
+        path = yasm_xmalloc(strlen(name)+strlen("results/.ew")+1);
+        sprintf(path, "results/%s.ew", name);
+        write_file(path, errwarn_text.data, errwarn_text.len);
+        yasm_xfree(path);
+    }
+
+    yasm_output_buffer_free(&out);
+    yasm_xfree(obj_path);
+    yasm_xfree(name);
+    return result;
+}
+
+/* Sets up options the way the yasm command line program would for the
+ * options used by the test scripts.  Returns 0 on success.
+ */
+static int
+parse_options(test_suite *suite, char *args)
+{
+    yasm_assemble_options *opts = &suite->opts;
+    char *arg, *param;
+
+    memset(opts, 0, sizeof(*opts));
+    opts->print_error = print_error;
+    opts->print_warning = print_warning;
+
+    for (arg = strtok(args, " \t"); arg; arg = strtok(NULL, " \t")) {
+        if (arg[0] != '-' || arg[1] == '\0')
+            return 1;
+        if (arg[1] == 'W') {
+            const char *w = arg+2;
+            void (*action)(yasm_warn_class wclass) = yasm_warn_enable;
+
+            if (strncmp(w, "no-", 3) == 0) {
+                action = yasm_warn_disable;
+                w += 3;
+            }
+            if (strcmp(w, "error") == 0)
+                opts->warning_error = (action == yasm_warn_enable);
+            else if (strcmp(w, "unrecognized-char") == 0)
+                action(YASM_WARN_UNREC_CHAR);
+            else if (strcmp(w, "orphan-labels") == 0)
+                action(YASM_WARN_ORPHAN_LABEL);
+            else if (strcmp(w, "uninit-contents") == 0)
+                action(YASM_WARN_UNINIT_CONTENTS);
+            else if (strcmp(w, "size-override") == 0)
+                action(YASM_WARN_SIZE_OVERRIDE);
+            else if (strcmp(w, "segreg-in-64bit") == 0)
+                action(YASM_WARN_SEGREG_IN_64BIT);
+            else
+                return 1;
+            continue;
+        }
+        if (strcmp(arg, "-w") == 0) {
+            yasm_warn_disable_all();
+            continue;
+        }
+
+        /* The rest all take a parameter */
+        if (arg[2] != '\0')
+            param = arg+2;
+        else if (!(param = strtok(NULL, " \t")))
+            return 1;
+        switch (arg[1]) {
+            case 'a':
+                opts->arch = param;
+                break;
+            case 'm':
+                opts->machine = param;
+                break;
+            case 'p':
+                opts->parser = param;
+                break;
+            case 'r':
+                opts->preproc = param;
+                break;
+            case 'f':
+                opts->objfmt = param;
+                break;
+            case 'g':
+                opts->dbgfmt = param;
+                break;
+            default:
+                return 1;
+        }
+    }
+    return 0;
+}
+
+static int
+compare_strings(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Lists the .asm files in dir, sorted; returns the number of cases, or -1
+ * if the directory couldn't be read.
+ */
+static int
+list_cases(const char *dir, char ***cases)
+{
+#ifdef HAVE_DIRENT_H
+    DIR *d = opendir(dir);
+    struct dirent *de;
+    int n = 0, size = 64;
+
+    if (!d)
+        return -1;
+    *cases = yasm_xmalloc(size*sizeof(char *));
+    while ((de = readdir(d)) != NULL) {
+        size_t len = strlen(de->d_name);
+        if (len <= 4 || strcmp(de->d_name+len-4, ".asm") != 0)
+            continue;
+        if (n == size) {
+            size *= 2;
+            *cases = yasm_xrealloc(*cases, size*sizeof(char *));
+        }
+        (*cases)[n] = yasm_xmalloc(strlen(dir)+len+2);
+        sprintf((*cases)[n], "%s/%s", dir, de->d_name);
+        n++;
+    }
+    closedir(d);
+    qsort(*cases, (size_t)n, sizeof(char *), compare_strings);
+    return n;
+#else
+    return -1;
+#endif
+}
+
+static const char *result_chars = ".EEWOC";
+static const char *result_msgs[] = {
+    NULL,
+    "E: %s returned an error code!",
+    "E: %s did not return an error code!",
+    "W: %s did not match errors and warnings!",
+    "O: %s did not match object file!",
+    "C: %s crashed!"
+};
+
+int
+main(int argc, char *argv[])
+{
+    test_suite suite;
+    const char *srcdir = getenv("srcdir");
+    char *dir, *args, **cases;
+    char *results;
+    int ncases, i, printed = 0, passed = 0, failed = 0;
+    int jobs = 0;
+#ifdef USE_FORK
+    pid_t *pids;
+    int running = 0, next = 0;
+#endif
+
+    if (argc > 2 && strcmp(argv[1], "-j") == 0) {
+        jobs = atoi(argv[2]);
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc != 6) {
+        fprintf(stderr, "usage: out_test [-j jobs] name dir description "
+                "\"yasm options\" obj-extension\n");
+        return EXIT_FAILURE;
+    }
+#if defined(USE_FORK) && defined(_SC_NPROCESSORS_ONLN)
+    if (jobs <= 0)
+        jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (jobs <= 0)
+        jobs = 1;
+
+    if (BitVector_Boot() != ErrCode_Ok)
+        return EXIT_FAILURE;
+    yasm_intnum_initialize();
+    yasm_floatnum_initialize();
+    yasm_errwarn_initialize();
+    yasm_fatal = handle_fatal;
+#ifdef CMAKE_BUILD
+    yasm_init_plugin();
+#endif
+
+    dir = yasm_xmalloc(strlen(srcdir ? srcdir : ".")+strlen(argv[2])+2);
+    sprintf(dir, "%s/%s", srcdir ? srcdir : ".", argv[2]);
+    suite.dir = dir;
+    suite.obj_ext = argv[5];
+    args = yasm__xstrdup(argv[4]);
+    if (parse_options(&suite, args) != 0) {
+        fprintf(stderr, "out_test: unsupported yasm options `%s'\n", argv[4]);
+        return 77;
+    }
+    ncases = list_cases(dir, &cases);
+    if (ncases < 0)
+        return 77;
+
+    printf("Test %s: ", argv[1]);
+    fflush(stdout);
+
+    results = yasm_xmalloc((size_t)ncases+1);
+    memset(results, RESULT_PENDING, (size_t)ncases);
+
+#ifdef USE_FORK
+    pids = yasm_xmalloc(((size_t)ncases+1)*sizeof(pid_t));
+    while (printed < ncases) {
+        int status;
+        pid_t pid;
+
+        while (running < jobs && next < ncases) {
+            fflush(stdout);
+            pid = fork();
+            if (pid == 0)
+                _exit(run_case(&suite, cases[next]));
+            if (pid < 0) {
+                if (running > 0)
+                    break;      /* wait for a free slot and retry */
+                /* can't fork at all; just run it here */
+                results[next] = (char)run_case(&suite, cases[next]);
+                pids[next++] = 0;
+                continue;
+            }
+            pids[next++] = pid;
+            running++;
+        }
+
+        if (running > 0) {
+            pid = wait(&status);
+            if (pid > 0) {
+                for (i=0; i<next && pids[i] != pid; i++)
+                    ;
+                if (i < next) {
+                    if (WIFEXITED(status) &&
+                        WEXITSTATUS(status) < RESULT_CRASH)
+                        results[i] = (char)WEXITSTATUS(status);
+                    else
+                        results[i] = RESULT_CRASH;
+                    running--;
+                }
+            }
+        }
+
+        while (printed < ncases && results[printed] != RESULT_PENDING) {
+            putchar(result_chars[(int)results[printed]]);
+            printed++;
+        }
+    }
+    yasm_xfree(pids);
+#else
+    for (i=0; i<ncases; i++) {
+        results[i] = (char)run_case(&suite, cases[i]);
+        putchar(result_chars[(int)results[i]]);
+        fflush(stdout);
+    }
+#endif
+
+    for (i=0; i<ncases; i++) {
+        if (results[i] == RESULT_PASS)
+            passed++;
+        else
+            failed++;
+    }
+    printf(" +%d-%d/%d %d%%\n", passed, failed, ncases,
+           ncases ? 100*passed/ncases : 0);
+    for (i=0; i<ncases; i++) {
+        if (results[i] != RESULT_PASS) {
+            char *name = case_name(cases[i]);
+            printf(" ** ");
+            printf(result_msgs[(int)results[i]], name);
+            printf("\n");
+            yasm_xfree(name);
+        }
+    }
+
+    for (i=0; i<ncases; i++)
+        yasm_xfree(cases[i]);
+    yasm_xfree(cases);
+    yasm_xfree(results);
+    yasm_xfree(args);
+    yasm_xfree(dir);
+    yasm_errwarn_cleanup();
+    yasm_floatnum_cleanup();
+    yasm_intnum_cleanup();
+
+    return failed;
+}
@@ -12,6 +12,19 @@ esac
 
 mkdir results >/dev/null 2>&1
 
+#
+# "make check-native" sets YASM_NATIVE_TEST to run the same checks through
+# the native driver, with libyasm in-process and several cases at a time.
+# That bypasses the yasm frontend, so plain "make check" doesn't.
+#
+if test -n "$YASM_NATIVE_TEST" && test -x ./out_test; then
+    ./out_test "$@"
+    status=$?
+    if test $status -ne 77; then
+        exit $status
+    fi
+fi
+
 #
 # Verify that all test cases match
 #
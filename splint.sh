@@ -20,9 +20,12 @@ splint \
  -I/usr/local/include \
  -DHAVE_CONFIG_H \
  -Dlint \
+ frontends/yasm/yasm-cache.c \
  frontends/yasm/yasm-options.c \
+ frontends/yasm/yasm-server.c \
  frontends/yasm/yasm.c \
  libyasm/arch.c \
+ libyasm/assemble.c \
  libyasm/assocdat.c \
  libyasm/bc-align.c \
  libyasm/bc-data.c \
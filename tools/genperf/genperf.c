@@ -149,7 +149,7 @@ make_c_tab(
 static void
 perfect_gen(FILE *out, const char *lookup_function_name,
             const char *struct_name, keyword_list *kws,
-            const char *filename)
+            const char *filename, int ignore_case)
 {
     ub4 nkeys;
     key *keys;
@@ -197,6 +197,24 @@ perfect_gen(FILE *out, const char *lookup_function_name,
     findhash(&tab, &tabh, &alen, &blen, &salt, &final, 
              scramble, &smax, keys, nkeys, &form);
 
+    /* For ignore-case, hash the key with uppercase letters folded, so that
+     * the caller need not lowercase it first.  The keywords themselves are
+     * lowercase, so the table is unchanged.
+     */
+    if (ignore_case) {
+        for (i=0; i<final.used; i++) {
+            char *call = strstr(final.line[i], "phash_lookup(");
+            if (call) {
+                char tail[80];
+                strcpy(tail, call+12);
+                strcpy(call, "phash_lookup_nocase");
+                strcat(call, tail);
+            } else if (strstr(final.line[i], "phash_checksum(")) {
+                report_error("ignore-case not supported for this many keywords");
+            }
+        }
+    }
+
     /* The hash function beginning */
     fprintf(out, "static const struct %s *\n", struct_name);
     fprintf(out, "%s(const char *key, size_t len)\n", lookup_function_name);
@@ -237,7 +255,11 @@ perfect_gen(FILE *out, const char *lookup_function_name,
         fprintf(out, "%s", final.line[i]);
     fprintf(out, "  if (rsl >= %lu) return NULL;\n", nkeys);
     fprintf(out, "  ret = &pd[rsl];\n");
-    fprintf(out, "  if (strcmp(key, ret->name) != 0) return NULL;\n");
+    if (ignore_case)
+        fprintf(out, "  if (yasm__strncasecmp(key, ret->name, len) != 0 ||\n"
+                     "      ret->name[len] != '\\0') return NULL;\n");
+    else
+        fprintf(out, "  if (strcmp(key, ret->name) != 0) return NULL;\n");
     fprintf(out, "  return ret;\n");
     fprintf(out, "}\n");
     fprintf(out, "\n");
@@ -477,6 +499,17 @@ main(int argc, char *argv[])
         }
         name[i] = '\0';
 
+        /* Case-insensitive lookups rely on lowercase keywords */
+        if (ignore_case) {
+            for (ch = name; *ch; ch++) {
+                if (*ch >= 'A' && *ch <= 'Z') {
+                    report_error("keyword `%s' must be lowercase", name);
+                    break;
+                }
+            }
+            ch = &line[i];
+        }
+
         /* Strip EOL */
         d = strrchr(ch, '\n');
         if (d)
@@ -523,7 +556,8 @@ main(int argc, char *argv[])
         fprintf(out, "%s", sv->str);
 
     /* Get perfect hash */
-    perfect_gen(out, lookup_function_name, struct_name, &keywords, filename);
+    perfect_gen(out, lookup_function_name, struct_name, &keywords, filename,
+                ignore_case);
 
     STAILQ_FOREACH(sv, &usercode2, link)
         fprintf(out, "%s", sv->str);